@@ -23,6 +23,7 @@ classification_externals = (
         "dtree",
         "gmm",
         "knn",
+        "lda",
         "mindist",
         "softmax",
         "anbc",
@@ -35,13 +36,17 @@ classification_externals = (
 regression_externals = (
         "linreg",
         "logreg",
+        "mdreg",
         "mlp"
   )
 
 feature_extraction_externals = (
         "minmax",
         "peak",
-        "zerox"
+        "zerox",
+        "minmax~",
+        "peak~",
+        "zerox~"
         )
 
 all_externals = classification_externals + regression_externals + feature_extraction_externals
@@ -51,7 +56,9 @@ template = template_file.read()
 template_file.close()
 
 for external in all_externals:
-    external_file = "ml_" + external + ".cpp"
+    # Signal externals are named with a trailing ~, which their file names spell as _tilde
+    external_stem = external.replace("~", "_tilde")
+    external_file = "ml_" + external_stem + ".cpp"
     name = NAME_PREFIX + external
 
     if external in classification_externals:
@@ -74,7 +81,7 @@ for external in all_externals:
     package = template.replace(NAME_MARKER, name)
     package = package.replace(SOURCES_MARKER, sources)
 
-    package_file = open(BUILD_ROOT + "/" + "package." + external + ".txt", "w")
+    package_file = open(BUILD_ROOT + "/" + "package." + external_stem + ".txt", "w")
     package_file.write(package)
     package_file.close()
 
@@ -17,8 +17,12 @@
  */
 
 #include "ml_classification.h"
+#include "ml_parallel.h"
 
 #include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ml
 {
@@ -29,7 +33,547 @@ namespace ml
         DECISION_STUMP,
         RADIAL_BASIS_FUNCTION
     };
-  
+    
+    // Below this many samples x features a boosting round is searched on the calling thread
+    const GRT::UINT k_adaboost_min_parallel_work = 1 << 15;
+    
+    // A GRT::DecisionStump as used for training and flat inference: votes +1 when x[feature] is at or above threshold
+    // (positive_above) or at or below it (otherwise) and -1 elsewhere. alpha is the stump's weight in its class' committee
+    struct adaboost_stump
+    {
+        GRT::UINT feature;
+        double threshold;
+        bool positive_above;
+        double alpha;
+    };
+    
+    inline bool adaboost_is_positive(const adaboost_stump &stump, double value)
+    {
+        return stump.positive_above ? value >= stump.threshold : value <= stump.threshold;
+    }
+    
+    // Finds the decision stump with the lowest weighted error. Every feature is sorted once up front, so a round needs
+    // one pass per feature accumulating the positive and negative weight below each distinct value, which scores every
+    // possible threshold in both directions exactly. Features are searched on a pool of worker threads
+    class adaboost_stump_trainer
+    {
+    public:
+        adaboost_stump_trainer()
+        :
+        num_samples(0),
+        num_dimensions(0)
+        {}
+        
+        void init(const GRT::ClassificationData &data)
+        {
+            num_samples = data.getNumSamples();
+            num_dimensions = data.getNumDimensions();
+            sorted_indices.resize(num_samples * num_dimensions);
+            sorted_values.resize(num_samples * num_dimensions);
+            
+            parallel_for(num_dimensions, [&](unsigned int feature, unsigned int)
+            {
+                GRT::UINT *indices = &sorted_indices[feature * num_samples];
+                double *values = &sorted_values[feature * num_samples];
+                
+                for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+                {
+                    indices[sample] = sample;
+                }
+                
+                std::stable_sort(indices, indices + num_samples, [&](GRT::UINT lhs, GRT::UINT rhs) { return data[lhs][feature] < data[rhs][feature]; });
+                
+                for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+                {
+                    values[sample] = data[indices[sample]][feature];
+                }
+            });
+        }
+        
+        // Returns the weighted error of the best stump for samples flagged positive against the rest
+        double train(const std::vector<double> &weights, const std::vector<char> &positive, adaboost_stump &best) const
+        {
+            std::vector<adaboost_stump> stumps(num_dimensions);
+            std::vector<double> errors(num_dimensions);
+            double total_positive = 0.0;
+            double total_negative = 0.0;
+            
+            for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+            {
+                (positive[sample] ? total_positive : total_negative) += weights[sample];
+            }
+            
+            auto search = [&](unsigned int feature, unsigned int)
+            {
+                errors[feature] = search_feature(feature, weights, positive, total_positive, total_negative, stumps[feature]);
+            };
+            
+            if (num_samples * num_dimensions < k_adaboost_min_parallel_work)
+            {
+                for (GRT::UINT feature = 0; feature < num_dimensions; ++feature)
+                {
+                    search(feature, 0);
+                }
+            }
+            else
+            {
+                parallel_for(num_dimensions, search);
+            }
+            
+            // Ties go to the lowest feature index whatever the thread scheduling
+            GRT::UINT best_feature = 0;
+            
+            for (GRT::UINT feature = 1; feature < num_dimensions; ++feature)
+            {
+                if (errors[feature] < errors[best_feature])
+                {
+                    best_feature = feature;
+                }
+            }
+            
+            best = stumps[best_feature];
+            
+            return errors[best_feature];
+        }
+        
+    private:
+        double search_feature(GRT::UINT feature, const std::vector<double> &weights, const std::vector<char> &positive, double total_positive, double total_negative, adaboost_stump &stump) const
+        {
+            const GRT::UINT *indices = &sorted_indices[feature * num_samples];
+            const double *values = &sorted_values[feature * num_samples];
+            double positive_below = 0.0;
+            double negative_below = 0.0;
+            
+            // Calling everything positive is always possible, also the only stump on a constant feature
+            stump.feature = feature;
+            stump.threshold = values[0];
+            stump.positive_above = true;
+            stump.alpha = 0.0;
+            
+            double best_error = total_negative;
+            
+            for (GRT::UINT position = 0; position + 1 < num_samples; ++position)
+            {
+                const GRT::UINT sample = indices[position];
+                
+                (positive[sample] ? positive_below : negative_below) += weights[sample];
+                
+                const double lower = values[position];
+                const double upper = values[position + 1];
+                
+                if (lower == upper)
+                {
+                    continue;
+                }
+                
+                // Positive at or above a threshold between lower and upper, or at or below it
+                const double above_error = positive_below + total_negative - negative_below;
+                const double below_error = negative_below + total_positive - positive_below;
+                const double middle = 0.5 * (lower + upper);
+                
+                if (above_error < best_error)
+                {
+                    best_error = above_error;
+                    stump.threshold = middle > lower ? middle : upper;
+                    stump.positive_above = true;
+                }
+                
+                if (below_error < best_error)
+                {
+                    best_error = below_error;
+                    stump.threshold = middle < upper ? middle : lower;
+                    stump.positive_above = false;
+                }
+            }
+            
+            return best_error;
+        }
+        
+        GRT::UINT num_samples;
+        GRT::UINT num_dimensions;
+        
+        // Sample indices and values of each feature in ascending order of value, feature-major
+        std::vector<GRT::UINT> sorted_indices;
+        std::vector<double> sorted_values;
+    };
+    
+    // GRT::DecisionStump built from an adaboost_stump, so trained committees hold ordinary GRT weak classifiers
+    class adaboost_decision_stump : public GRT::DecisionStump
+    {
+    public:
+        adaboost_decision_stump(const adaboost_stump &stump, GRT::UINT num_dimensions)
+        {
+            decisionFeatureIndex = stump.feature;
+            decisionValue = stump.threshold;
+            direction = stump.positive_above ? 1 : 0;
+            numInputDimensions = num_dimensions;
+            trained = true;
+        }
+    };
+    
+    // GRT::AdaBoost that trains decision stump committees with adaboost_stump_trainer and predicts from a flat array of
+    // stumps. Models using other weak classifiers are trained and run by GRT
+    class ml_adaboost_model : public GRT::AdaBoost
+    {
+    public:
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        using GRT::AdaBoost::train_;
+        using GRT::AdaBoost::predict_;
+        using GRT::AdaBoost::loadModelFromFile;
+        
+    protected:
+        bool uses_stumps_only() const;
+        void build_inference();
+        
+        // Every class' committee back to back, class_offsets[k] being the first stump of class k and
+        // class_offsets[numClasses] the total. Empty unless every weak classifier of the model is a stump
+        std::vector<adaboost_stump> stumps;
+        std::vector<GRT::UINT> class_offsets;
+    };
+    
+    bool ml_adaboost_model::train_(GRT::ClassificationData &trainingData)
+    {
+        if (!uses_stumps_only())
+        {
+            if (!GRT::AdaBoost::train_(trainingData))
+            {
+                return false;
+            }
+            
+            build_inference();
+            
+            return true;
+        }
+        
+        clear();
+        
+        const GRT::UINT M = trainingData.getNumSamples();
+        
+        if (M <= 1)
+        {
+            errorLog << "train_(ClassificationData &trainingData) - There are not enough training samples to train a model! Number of samples: " << M << endl;
+            return false;
+        }
+        
+        numInputDimensions = trainingData.getNumDimensions();
+        numClasses = trainingData.getNumClasses();
+        classLabels = trainingData.getClassLabels();
+        ranges = trainingData.getRanges();
+        models.resize(numClasses);
+        
+        if (useScaling)
+        {
+            trainingData.scale(ranges, 0, 1);
+        }
+        
+        // Same stopping rules and M1 reweighting as GRT, so committees match GRT's apart from the exact thresholds
+        const double beta = 0.001;
+        adaboost_stump_trainer trainer;
+        std::vector<double> weights(M);
+        std::vector<char> positive(M);
+        std::vector<char> wrong(M);
+        std::vector<GRT::UINT> labels(M);
+        
+        trainer.init(trainingData);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            labels[i] = trainingData[i].getClassLabel();
+        }
+        
+        for (GRT::UINT classIter = 0; classIter < numClasses; ++classIter)
+        {
+            models[classIter].setClassLabel(classLabels[classIter]);
+            
+            for (GRT::UINT i = 0; i < M; ++i)
+            {
+                positive[i] = labels[i] == classLabels[classIter];
+            }
+            
+            std::fill(weights.begin(), weights.end(), 1.0 / M);
+            
+            bool keepBoosting = true;
+            GRT::UINT t = 0;
+            
+            while (keepBoosting)
+            {
+                adaboost_stump stump;
+                const double epsilon = trainer.train(weights, positive, stump);
+                double alpha = 0.5 * log((1.0 - epsilon) / epsilon);
+                
+                trainingLog << "PositiveClass: " << classLabels[classIter] << " Boosting Iter: " << t << " Min Error: " << epsilon << " Alpha: " << alpha << endl;
+                
+                if (std::isinf(alpha))
+                {
+                    keepBoosting = false;
+                }
+                
+                if (0.5 - epsilon <= beta)
+                {
+                    keepBoosting = false;
+                }
+                
+                if (++t >= numBoostingIterations)
+                {
+                    keepBoosting = false;
+                }
+                
+                const adaboost_decision_stump decision_stump(stump, numInputDimensions);
+                
+                if (keepBoosting)
+                {
+                    models[classIter].addClassifierToCommitee(&decision_stump, alpha);
+                    
+                    // Raise the weights of misclassified samples and renormalise
+                    const double reWeight = (1.0 - epsilon) / epsilon;
+                    double oldSum = 0;
+                    double newSum = 0;
+                    
+                    for (GRT::UINT i = 0; i < M; ++i)
+                    {
+                        const bool predicted_positive = adaboost_is_positive(stump, trainingData[i][stump.feature]);
+                        
+                        oldSum += weights[i];
+                        
+                        if (predicted_positive != (bool)positive[i])
+                        {
+                            weights[i] *= reWeight;
+                        }
+                        
+                        newSum += weights[i];
+                    }
+                    
+                    for (GRT::UINT i = 0; i < M; ++i)
+                    {
+                        weights[i] *= oldSum / newSum;
+                    }
+                }
+                else if (t - 1 == 0)
+                {
+                    // The first stump is always kept, with a weight of 1 if it classified everything correctly
+                    if (std::isinf(alpha))
+                    {
+                        alpha = 1;
+                    }
+                    
+                    models[classIter].addClassifierToCommitee(&decision_stump, alpha);
+                }
+            }
+        }
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            models[k].normalizeWeights();
+        }
+        
+        trained = true;
+        predictedClassLabel = 0;
+        maxLikelihood = 0;
+        classLikelihoods.resize(numClasses);
+        classDistances.resize(numClasses);
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_adaboost_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (stumps.empty())
+        {
+            return GRT::AdaBoost::predict_(inputVector);
+        }
+        
+        predictedClassLabel = 0;
+        maxLikelihood = -10000;
+        
+        if (!trained)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - AdaBoost Model Not Trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - The size of the input vector (" << inputVector.size() << ") does not match the num features in the model (" << numInputDimensions << endl;
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+            {
+                inputVector[n] = scale(inputVector[n], ranges[n].minValue, ranges[n].maxValue, 0, 1);
+            }
+        }
+        
+        classLikelihoods.resize(numClasses);
+        classDistances.resize(numClasses);
+        
+        // The committee sums of the stump array, then GRT's prediction methods unchanged
+        GRT::UINT bestClassIndex = 0;
+        GRT::UINT numPositivePredictions = 0;
+        double worstDistance = std::numeric_limits<double>::max();
+        double sum = 0;
+        
+        bestDistance = -std::numeric_limits<double>::max();
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            double result = 0.0;
+            
+            for (GRT::UINT stump = class_offsets[k]; stump < class_offsets[k + 1]; ++stump)
+            {
+                const adaboost_stump &weak = stumps[stump];
+                result += adaboost_is_positive(weak, inputVector[weak.feature]) ? weak.alpha : -weak.alpha;
+            }
+            
+            if (predictionMethod == MAX_POSITIVE_VALUE)
+            {
+                if (result > 0)
+                {
+                    if (result > bestDistance)
+                    {
+                        bestDistance = result;
+                        bestClassIndex = k;
+                    }
+                    
+                    numPositivePredictions++;
+                    classLikelihoods[k] = result;
+                }
+                else
+                {
+                    classLikelihoods[k] = 0;
+                }
+                
+                classDistances[k] = result;
+                sum += classLikelihoods[k];
+            }
+            else
+            {
+                if (result > bestDistance)
+                {
+                    bestDistance = result;
+                    bestClassIndex = k;
+                }
+                
+                worstDistance = std::min(worstDistance, result);
+                
+                // In the MAX_VALUE mode every class counts as a valid prediction
+                numPositivePredictions++;
+                classLikelihoods[k] = result;
+                classDistances[k] = result;
+            }
+        }
+        
+        if (predictionMethod == MAX_VALUE)
+        {
+            // Offset possibly negative likelihoods by the most negative one
+            worstDistance = fabs(worstDistance);
+            
+            for (GRT::UINT k = 0; k < numClasses; ++k)
+            {
+                classLikelihoods[k] += worstDistance;
+                sum += classLikelihoods[k];
+            }
+        }
+        
+        if (sum > 0)
+        {
+            for (GRT::UINT k = 0; k < numClasses; ++k)
+            {
+                classLikelihoods[k] /= sum;
+            }
+        }
+        
+        maxLikelihood = classLikelihoods[bestClassIndex];
+        predictedClassLabel = numPositivePredictions == 0 ? GRT_DEFAULT_NULL_CLASS_LABEL : classLabels[bestClassIndex];
+        
+        return true;
+    }
+    
+    bool ml_adaboost_model::loadModelFromFile(fstream &file)
+    {
+        if (!GRT::AdaBoost::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_adaboost_model::clear()
+    {
+        stumps.clear();
+        class_offsets.clear();
+        
+        return GRT::AdaBoost::clear();
+    }
+    
+    bool ml_adaboost_model::uses_stumps_only() const
+    {
+        if (weakClassifiers.empty())
+        {
+            return false;
+        }
+        
+        for (GRT::UINT k = 0; k < weakClassifiers.size(); ++k)
+        {
+            if (weakClassifiers[k]->getWeakClassifierType() != "DecisionStump")
+            {
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    // Copies every committee into the stump array, leaving it empty if any weak classifier is not a stump
+    void ml_adaboost_model::build_inference()
+    {
+        stumps.clear();
+        class_offsets.assign(1, 0);
+        
+        for (GRT::UINT k = 0; k < models.size(); ++k)
+        {
+            GRT::AdaBoostClassModel &model = models[k];
+            const GRT::VectorDouble weights = model.getWeights();
+            
+            for (GRT::UINT i = 0; i < model.getNumWeakClassifiers(); ++i)
+            {
+                const GRT::DecisionStump *decision_stump = model.getWeakClassifier<GRT::DecisionStump>(i);
+                
+                if (decision_stump == NULL)
+                {
+                    stumps.clear();
+                    class_offsets.clear();
+                    return;
+                }
+                
+                adaboost_stump stump;
+                
+                stump.feature = decision_stump->getDecisionFeatureIndex();
+                stump.threshold = decision_stump->getDecisionValue();
+                stump.positive_above = decision_stump->getDirection() == 1;
+                stump.alpha = weights[i];
+                stumps.push_back(stump);
+            }
+            
+            class_offsets.push_back((GRT::UINT)stumps.size());
+        }
+        
+        if (stumps.empty())
+        {
+            class_offsets.clear();
+        }
+    }
+    
     class ml_adaboost : ml_classification
     {
         FLEXT_HEADER_S(ml_adaboost, ml_classification, setup);
@@ -84,7 +628,7 @@ namespace ml
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
                 
-        GRT::AdaBoost adaboost;
+        ml_adaboost_model adaboost;
         
         static const std::string attribute_help;
     };
@@ -19,11 +19,220 @@
 #include "ml_classification.h"
 
 #include <vector>
+#include <cmath>
 
 namespace ml
 {
     const std::string ml_object_name = "ml.anbc";
-   
+    
+    // GRT::ANBC scoring from coefficients folded at train and load time. GRT scores class k as the sum over dimensions n
+    // with a positive weight of log(w_kn * N(x_n; mu_kn, sigma_kn)), which is
+    // constants[k] - sum_n (x_n * scales[n][k] - offsets[n][k])^2 with scales[n][k] = 1 / (sigma_kn * sqrt(2)) (0 for
+    // dimensions that are not weighted) and offsets[n][k] = mu_kn * scales[n][k], the weights, standard deviations and
+    // normalising constants all going into constants[k]. Coefficients are interleaved across classes, dimension n of
+    // class k at [n * numClasses + k], so a prediction is one multiply-add sweep over dimensions x classes that vectorises
+    // across classes, with no exp or log
+    class ml_anbc_model : public GRT::ANBC
+    {
+    public:
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        using GRT::ANBC::train_;
+        using GRT::ANBC::predict_;
+        using GRT::ANBC::loadModelFromFile;
+        
+    protected:
+        void build_inference();
+        void clear_inference();
+        
+        // Empty if a weighted dimension has no spread, GRT's models then score
+        std::vector<double> scales;
+        std::vector<double> offsets;
+        std::vector<double> constants;
+        std::vector<double> scores;
+    };
+    
+    bool ml_anbc_model::train_(GRT::ClassificationData &trainingData)
+    {
+        if (!GRT::ANBC::train_(trainingData))
+        {
+            return false;
+        }
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_anbc_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (constants.empty())
+        {
+            return GRT::ANBC::predict_(inputVector);
+        }
+        
+        predictedClassLabel = 0;
+        maxLikelihood = -10000;
+        
+        if (!trained)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - ANBC Model Not Trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - The size of the input vector (" << inputVector.size() << ") does not match the num features in the model (" << numInputDimensions << endl;
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+            {
+                inputVector[n] = scale(inputVector[n], ranges[n].minValue, ranges[n].maxValue, MIN_SCALE_VALUE, MAX_SCALE_VALUE);
+            }
+        }
+        
+        const GRT::UINT K = numClasses;
+        double *score = &scores[0];
+        
+        std::fill(score, score + K, 0.0);
+        
+        for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+        {
+            const double value = inputVector[n];
+            const double *scale = &scales[n * K];
+            const double *offset = &offsets[n * K];
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                const double z = value * scale[k] - offset[k];
+                score[k] += z * z;
+            }
+        }
+        
+        GRT::UINT bestIndex = 0;
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            score[k] = constants[k] - score[k];
+            
+            if (score[k] > score[bestIndex])
+            {
+                bestIndex = k;
+            }
+        }
+        
+        classLikelihoods.resize(K);
+        classDistances.resize(K);
+        
+        // The log-likelihoods are exponentiated relative to the best class, so the likelihoods stay defined when every
+        // class' likelihood underflows
+        double sum = 0.0;
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            classDistances[k] = score[k];
+            classLikelihoods[k] = exp(score[k] - score[bestIndex]);
+            sum += classLikelihoods[k];
+        }
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            classLikelihoods[k] /= sum;
+        }
+        
+        maxLikelihood = classLikelihoods[bestIndex];
+        
+        if (useNullRejection && score[bestIndex] < models[bestIndex].threshold)
+        {
+            predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+        }
+        else
+        {
+            predictedClassLabel = models[bestIndex].classLabel;
+        }
+        
+        return true;
+    }
+    
+    bool ml_anbc_model::loadModelFromFile(fstream &file)
+    {
+        if (!GRT::ANBC::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_anbc_model::clear()
+    {
+        clear_inference();
+        
+        return GRT::ANBC::clear();
+    }
+    
+    void ml_anbc_model::clear_inference()
+    {
+        scales.clear();
+        offsets.clear();
+        constants.clear();
+    }
+    
+    void ml_anbc_model::build_inference()
+    {
+        const GRT::UINT K = (GRT::UINT)models.size();
+        const GRT::UINT N = numInputDimensions;
+        
+        scales.assign(N * K, 0.0);
+        offsets.assign(N * K, 0.0);
+        constants.assign(K, 0.0);
+        scores.resize(K);
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            const GRT::ANBC_Model &model = models[k];
+            
+            if (model.N != N)
+            {
+                clear_inference();
+                return;
+            }
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                if (!(model.weights[n] > 0))
+                {
+                    continue;
+                }
+                
+                if (!(model.sigma[n] > 0))
+                {
+                    clear_inference();
+                    return;
+                }
+                
+                const double scale = 1.0 / (model.sigma[n] * sqrt(2.0));
+                
+                scales[n * K + k] = scale;
+                offsets[n * K + k] = model.mu[n] * scale;
+                constants[k] += log(model.weights[n]) - log(model.sigma[n] * SQRT_TWO_PI);
+            }
+        }
+        
+        if (K == 0)
+        {
+            clear_inference();
+        }
+    }
+    
     class ml_anbc : ml_classification
     {
         FLEXT_HEADER_S(ml_anbc, ml_classification, setup);
@@ -61,7 +270,7 @@ namespace ml
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
         // Instance variables
-        GRT::ANBC anbc;
+        ml_anbc_model anbc;
         
         static const std::string attribute_help;
     };
@@ -53,14 +53,14 @@ namespace ml
         null_rejection_coeff = classifier.getNullRejectionCoeff();
     }
     
-    bool ml_classification::get_num_samples() const
+    GRT::UINT ml_classification::get_num_samples() const
     {
         GRT::UINT numSamples = 0;
         const ml_data_type data_type = get_data_type();
         
         if (data_type == LABELLED_REGRESSION)
         {
-            regression_data.getNumSamples();
+            numSamples = regression_data.getNumSamples();
         }
         else if (data_type == LABELLED_CLASSIFICATION)
         {
@@ -90,8 +90,11 @@ namespace ml
             return;
         }
         
+        GRT::Timer timer;
         bool success = false;
         
+        timer.start();
+        
         if (data_type == LABELLED_CLASSIFICATION)
         {
             success = classifier.train(classification_data);
@@ -109,6 +112,10 @@ namespace ml
         {
             error("training failed");
         }
+        else
+        {
+            post_training_summary(numSamples, timer.getMilliSeconds() / 1000.0);
+        }
         
         t_atom a_success;
         
@@ -54,7 +54,7 @@ namespace ml
         bool write_specialised_dataset(std::string &path) const;
         
     private:
-        bool get_num_samples() const;
+        GRT::UINT get_num_samples() const;
         
         // Flext attribute wrappers
         FLEXT_CALLVAR_B(get_null_rejection, set_null_rejection);
@@ -17,11 +17,172 @@
  */
 
 #include "ml_classification.h"
+#include "ml_tree.h"
 
 namespace ml
 {
     const std::string ml_object_name = "ml.dtree";
     
+    // GRT::DecisionTree that by default finds splits over quantile-binned features, scoring every bin boundary of a
+    // feature from one class histogram per node instead of rescanning the node's samples for each candidate threshold
+    class ml_dtree_model : public GRT::DecisionTree
+    {
+    public:
+        ml_dtree_model()
+        :
+        num_bins(k_tree_max_bins)
+        {}
+        
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        // Number of quantile bins features are reduced to for split search, 0 uses GRT's own training modes
+        void set_num_bins(GRT::UINT num_bins) { this->num_bins = num_bins; }
+        GRT::UINT get_num_bins() const { return num_bins; }
+        
+        using GRT::DecisionTree::train_;
+        using GRT::DecisionTree::predict_;
+        using GRT::DecisionTree::loadModelFromFile;
+        
+    protected:
+        bool build_inference();
+        
+        GRT::UINT num_bins;
+        
+        // The trained tree compiled for prediction, rebuilt after training and loading
+        tree_flat_forest flat_tree;
+    };
+    
+    bool ml_dtree_model::train_(GRT::ClassificationData &trainingData)
+    {
+        if (num_bins == 0)
+        {
+            return GRT::DecisionTree::train_(trainingData) && build_inference();
+        }
+        
+        clear();
+        
+        const GRT::UINT numSamples = trainingData.getNumSamples();
+        
+        if (numSamples == 0)
+        {
+            errorLog << "train_(ClassificationData &trainingData) - Training data has zero samples!" << endl;
+            return false;
+        }
+        
+        numInputDimensions = trainingData.getNumDimensions();
+        numClasses = trainingData.getNumClasses();
+        classLabels = trainingData.getClassLabels();
+        ranges = trainingData.getRanges();
+        
+        if (useScaling)
+        {
+            trainingData.scale(0, 1);
+        }
+        
+        tree_dataset dataset;
+        tree_settings settings;
+        
+        dataset.assign(trainingData, classLabels, num_bins);
+        settings.num_random_splits = numSplittingSteps;
+        settings.min_samples_per_node = minNumSamplesPerNode;
+        settings.max_depth = maxDepth;
+        settings.remove_features_at_each_split = removeFeaturesAtEachSpilt;
+        
+        std::vector<GRT::UINT> indices(numSamples);
+        tree_builder builder(dataset, settings);
+        GRT::Random random;
+        
+        for (GRT::UINT sample = 0; sample < numSamples; ++sample)
+        {
+            indices[sample] = sample;
+        }
+        
+        decisionTree = builder.build(indices, random);
+        
+        if (decisionTree == NULL)
+        {
+            errorLog << "train_(ClassificationData &trainingData) - Failed to build tree" << endl;
+            clear();
+            return false;
+        }
+        
+        trained = true;
+        
+        return build_inference();
+    }
+    
+    bool ml_dtree_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (flat_tree.is_empty())
+        {
+            return GRT::DecisionTree::predict_(inputVector);
+        }
+        
+        predictedClassLabel = 0;
+        maxLikelihood = 0;
+        
+        if (!trained)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - Model Not Trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - The size of the input vector (" << inputVector.size() << ") does not match the num features in the model (" << numInputDimensions << endl;
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+            {
+                inputVector[n] = scale(inputVector[n], ranges[n].minValue, ranges[n].maxValue, 0, 1);
+            }
+        }
+        
+        classLikelihoods.resize(numClasses);
+        classDistances.assign(numClasses, 0.0);
+        
+        const GRT::UINT best = flat_tree.predict(&inputVector[0], &classLikelihoods[0]);
+        
+        maxLikelihood = classLikelihoods[best];
+        predictedClassLabel = classLabels[best];
+        
+        return true;
+    }
+    
+    bool ml_dtree_model::loadModelFromFile(fstream &file)
+    {
+        if (!GRT::DecisionTree::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        return build_inference();
+    }
+    
+    bool ml_dtree_model::clear()
+    {
+        flat_tree.clear();
+        
+        return GRT::DecisionTree::clear();
+    }
+    
+    bool ml_dtree_model::build_inference()
+    {
+        if (!flat_tree.compile(std::vector<const GRT::DecisionTreeNode *>(1, decisionTree), numClasses))
+        {
+            errorLog << "build_inference() - Model has no tree" << endl;
+            return false;
+        }
+        
+        return true;
+    }
+    
     class ml_dtree : ml_classification
     {
         FLEXT_HEADER_S(ml_dtree, ml_classification, setup);
@@ -38,6 +199,7 @@ namespace ml
         static void setup(t_classid c)
         {
             // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "num_bins", set_num_bins);
             FLEXT_CADDATTR_SET(c, "training_mode", set_training_mode);
             FLEXT_CADDATTR_SET(c, "num_splitting_steps", set_num_splitting_steps);
             FLEXT_CADDATTR_SET(c, "min_samples_per_node", set_min_samples_per_node);
@@ -46,6 +208,7 @@ namespace ml
             
             
             // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "num_bins", get_num_bins);
             FLEXT_CADDATTR_GET(c, "training_mode", get_training_mode);
             FLEXT_CADDATTR_GET(c, "num_splitting_steps", get_num_splitting_steps);
             FLEXT_CADDATTR_GET(c, "min_samples_per_node", get_min_samples_per_node);
@@ -57,6 +220,7 @@ namespace ml
         }
                 
         // Flext attribute setters
+        void set_num_bins(int num_bins);
         void set_training_mode(int training_mode);
         void set_num_splitting_steps(int num_splitting_steps);
         void set_min_samples_per_node(int min_samples_per_node);
@@ -65,6 +229,7 @@ namespace ml
 
         
         // Flext attribute getters
+        void get_num_bins(int &num_bins) const;
         void get_training_mode(int &training_mode) const;
         void get_num_splitting_steps(int &num_splitting_steps) const;
         void get_min_samples_per_node(int &min_samples_per_node) const;
@@ -78,6 +243,7 @@ namespace ml
         
     private:
         // Flext Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_num_bins, set_num_bins);
         FLEXT_CALLVAR_I(get_training_mode, set_training_mode);
         FLEXT_CALLVAR_I(get_num_splitting_steps, set_num_splitting_steps);
         FLEXT_CALLVAR_I(get_min_samples_per_node, set_min_samples_per_node);
@@ -87,12 +253,23 @@ namespace ml
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
                 
-        GRT::DecisionTree dtree;
+        ml_dtree_model dtree;
         
         static const std::string attribute_help;
     };
     
     // Flext attribute setters
+    void ml_dtree::set_num_bins(int num_bins)
+    {
+        if (num_bins < 0 || num_bins == 1 || num_bins > (int)k_tree_max_bins)
+        {
+            error("num_bins must be 0 or between 2 and " + std::to_string(k_tree_max_bins));
+            return;
+        }
+        
+        dtree.set_num_bins(num_bins);
+    }
+    
     void ml_dtree::set_training_mode(int training_mode)
     {
         bool success = dtree.setTrainingMode(training_mode);
@@ -124,6 +301,11 @@ namespace ml
     }
     
     // Flext attribute getters
+    void ml_dtree::get_num_bins(int &num_bins) const
+    {
+        num_bins = dtree.get_num_bins();
+    }
+    
     void ml_dtree::get_training_mode(int &training_mode) const
     {
         training_mode = dtree.getTrainingMode();
@@ -161,8 +343,9 @@ namespace ml
     }
     
     const std::string ml_dtree::attribute_help =
-    "training_mode:\tinteger (0 = BEST_ITERATIVE_SPILT, 1=BEST_RANDOM_SPLIT) sets the training mode (default 0)\n"
-    "num_splitting_steps:\tinteger (n > 0) Sets the number of steps that will be used to search for the best spliting value for each node (default 100)\n"
+    "num_bins:\tinteger (0 or 2-256) sets the number of quantile bins each feature is reduced to before training, every bin boundary is then tried as a split. 0 uses training_mode and num_splitting_steps instead (default 256)\n"
+    "training_mode:\tinteger (0 = BEST_ITERATIVE_SPILT, 1=BEST_RANDOM_SPLIT) sets the training mode used when num_bins is 0 (default 0)\n"
+    "num_splitting_steps:\tinteger (n > 0) Sets the number of steps that will be used to search for the best spliting value for each node when num_bins is 0 (default 100)\n"
     "min_samples_per_node:\tinteger (n > 0) sets the minimum number of samples that are allowed per node, if the number of samples at a node is below this value then the node will automatically become a leaf node (default 5)\n"
     "max_depth:\tinteger (n > 0) sets the maximum depth of the tree, any node that reaches this depth will automatically become a leaf node (default 10)\n"
     "remove_features_at_each_split:\tbool (0 or 1) sets if a feature is removed at each spilt so it can not be used again (default 0)\n";
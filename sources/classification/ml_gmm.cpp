@@ -17,11 +17,1371 @@
  */
 
 #include "ml_classification.h"
+#include "ml_parallel.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ml
 {
     const std::string ml_object_name = "ml.gmm";
     
+    enum gmm_covariance
+    {
+        GMM_COVARIANCE_FULL,
+        GMM_COVARIANCE_DIAGONAL,
+        GMM_NUM_COVARIANCES
+    };
+    
+    // Floor on a component's variances, relative to the variance of the class' data in that dimension
+    const double k_gmm_relative_variance_floor = 1.0e-3;
+    const double k_gmm_min_variance = 1.0e-9;
+    
+    // A mixture of Gaussians compiled for evaluation. Each component k is whitened, z = A_k x - c_k, with A_k the inverse
+    // of the Cholesky factor of its covariance (packed lower triangle) or, for diagonal covariance, the inverse standard
+    // deviations, and c_k = A_k mu_k. Coefficients are interleaved across components, coefficient j of component k at
+    // [j * num_components + k], so the inner loops run over contiguous components and vectorise.
+    // Component k has the log density log_scale_k - |z_k|^2 / 2 with log_scale_k = -log(det_k) / 2 plus whatever
+    // add_log_scales() added. log_likelihood() returns log(sum_k exp(log_scale_k - |z_k|^2 / 2) / sum_k exp(log_scale_k)),
+    // which without added scales is the mixture likelihood normalised by its value at the component means as GRT
+    // computes it, with a log-sum-exp over components
+    class gmm_mixture
+    {
+    public:
+        gmm_mixture()
+        :
+        num_components(0),
+        num_dimensions(0),
+        diagonal(false),
+        log_normaliser(0.0)
+        {}
+        
+        // means hold the mean of component k in dimension i at [k * num_dimensions + i], covariances the covariance of
+        // dimensions i and j at [(k * num_dimensions + i) * num_dimensions + j] or, when diagonal, the variance of
+        // dimension i at [k * num_dimensions + i]. Fails if a covariance matrix is not positive definite
+        bool compile(const double *means, const double *covariances, GRT::UINT num_components, GRT::UINT num_dimensions, bool diagonal)
+        {
+            const GRT::UINT K = num_components;
+            const GRT::UINT N = num_dimensions;
+            const GRT::UINT num_coefficients = diagonal ? N : N * (N + 1) / 2;
+            std::vector<double> inverse;
+            
+            if (K == 0)
+            {
+                return false;
+            }
+            
+            this->num_components = K;
+            this->num_dimensions = N;
+            this->diagonal = diagonal;
+            coefficients.assign(num_coefficients * K, 0.0);
+            offsets.assign(N * K, 0.0);
+            log_scales.assign(K, 0.0);
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                const double *mean = means + k * N;
+                double log_determinant = 0.0;
+                
+                if (diagonal)
+                {
+                    for (GRT::UINT i = 0; i < N; ++i)
+                    {
+                        const double variance = covariances[k * N + i];
+                        
+                        if (!(variance > 0.0))
+                        {
+                            return false;
+                        }
+                        
+                        const double inverse_deviation = 1.0 / sqrt(variance);
+                        
+                        coefficients[i * K + k] = inverse_deviation;
+                        offsets[i * K + k] = mean[i] * inverse_deviation;
+                        log_determinant += log(variance);
+                    }
+                }
+                else
+                {
+                    if (!inverse_cholesky(covariances + k * N * N, N, inverse, log_determinant))
+                    {
+                        return false;
+                    }
+                    
+                    for (GRT::UINT i = 0; i < N; ++i)
+                    {
+                        const GRT::UINT row = i * (i + 1) / 2;
+                        double offset = 0.0;
+                        
+                        for (GRT::UINT j = 0; j <= i; ++j)
+                        {
+                            coefficients[(row + j) * K + k] = inverse[row + j];
+                            offset += inverse[row + j] * mean[j];
+                        }
+                        
+                        offsets[i * K + k] = offset;
+                    }
+                }
+                
+                log_scales[k] = -0.5 * log_determinant;
+            }
+            
+            update_normaliser();
+            
+            return true;
+        }
+        
+        bool compile(const GRT::MixtureModel &model, GRT::UINT num_dimensions)
+        {
+            const GRT::UINT K = model.getK();
+            const GRT::UINT N = num_dimensions;
+            std::vector<double> means(K * N);
+            std::vector<double> covariances(K * N * N);
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                if (model[k].mu.size() != N || model[k].sigma.getNumRows() != N || model[k].sigma.getNumCols() != N)
+                {
+                    return false;
+                }
+                
+                for (GRT::UINT i = 0; i < N; ++i)
+                {
+                    means[k * N + i] = model[k].mu[i];
+                    
+                    for (GRT::UINT j = 0; j < N; ++j)
+                    {
+                        covariances[(k * N + i) * N + j] = model[k].sigma[i][j];
+                    }
+                }
+            }
+            
+            return compile(&means[0], &covariances[0], K, N, false);
+        }
+        
+        // Adds values[k] to the log scale of component k, e.g. a log weight
+        void add_log_scales(const double *values)
+        {
+            for (GRT::UINT k = 0; k < num_components; ++k)
+            {
+                log_scales[k] += values[k];
+            }
+            
+            update_normaliser();
+        }
+        
+        GRT::UINT get_num_components() const { return num_components; }
+        
+        // -2 log_scale_k before any add_log_scales(), i.e. log(det_k)
+        double get_log_determinant(GRT::UINT k) const { return -2.0 * log_scales[k]; }
+        
+        // Inverse covariance of a full covariance component as a num_dimensions x num_dimensions row-major matrix
+        void get_inverse_covariance(GRT::UINT k, double *inverse) const
+        {
+            const GRT::UINT K = num_components;
+            const GRT::UINT N = num_dimensions;
+            
+            for (GRT::UINT i = 0; i < N; ++i)
+            {
+                for (GRT::UINT j = 0; j <= i; ++j)
+                {
+                    double sum = 0.0;
+                    
+                    for (GRT::UINT m = i; m < N; ++m)
+                    {
+                        const GRT::UINT row = m * (m + 1) / 2;
+                        sum += coefficients[(row + i) * K + k] * coefficients[(row + j) * K + k];
+                    }
+                    
+                    inverse[i * N + j] = sum;
+                    inverse[j * N + i] = sum;
+                }
+            }
+        }
+        
+        // Sets log_densities[k] to log_scale_k - |z_k|^2 / 2, projection must hold num_components values
+        void log_components(const double *x, double *log_densities, double *projection) const
+        {
+            const GRT::UINT K = num_components;
+            double *distances = log_densities;
+            
+            std::fill(distances, distances + K, 0.0);
+            
+            if (diagonal)
+            {
+                for (GRT::UINT i = 0; i < num_dimensions; ++i)
+                {
+                    const double value = x[i];
+                    const double *scale = &coefficients[i * K];
+                    const double *offset = &offsets[i * K];
+                    
+                    for (GRT::UINT k = 0; k < K; ++k)
+                    {
+                        const double z = value * scale[k] - offset[k];
+                        distances[k] += z * z;
+                    }
+                }
+            }
+            else
+            {
+                for (GRT::UINT i = 0; i < num_dimensions; ++i)
+                {
+                    const double *coefficient = &coefficients[i * (i + 1) / 2 * K];
+                    const double *offset = &offsets[i * K];
+                    
+                    for (GRT::UINT k = 0; k < K; ++k)
+                    {
+                        projection[k] = -offset[k];
+                    }
+                    
+                    for (GRT::UINT j = 0; j <= i; ++j, coefficient += K)
+                    {
+                        const double value = x[j];
+                        
+                        for (GRT::UINT k = 0; k < K; ++k)
+                        {
+                            projection[k] += coefficient[k] * value;
+                        }
+                    }
+                    
+                    for (GRT::UINT k = 0; k < K; ++k)
+                    {
+                        distances[k] += projection[k] * projection[k];
+                    }
+                }
+            }
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                log_densities[k] = log_scales[k] - 0.5 * distances[k];
+            }
+        }
+        
+        // scratch must hold 2 * num_components values
+        double log_likelihood(const double *x, double *scratch) const
+        {
+            const GRT::UINT K = num_components;
+            double *log_densities = scratch;
+            
+            log_components(x, log_densities, scratch + K);
+            
+            const double maximum = *std::max_element(log_densities, log_densities + K);
+            double sum = 0.0;
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                sum += exp(log_densities[k] - maximum);
+            }
+            
+            return maximum + log(sum) - log_normaliser;
+        }
+    
+    private:
+        void update_normaliser()
+        {
+            const double maximum = *std::max_element(log_scales.begin(), log_scales.end());
+            double sum = 0.0;
+            
+            for (GRT::UINT k = 0; k < num_components; ++k)
+            {
+                sum += exp(log_scales[k] - maximum);
+            }
+            
+            log_normaliser = maximum + log(sum);
+        }
+        
+        // Inverse of the lower Cholesky factor of the N x N row-major sigma, row by row as a packed lower triangle, and
+        // log(det(sigma))
+        static bool inverse_cholesky(const double *sigma, GRT::UINT N, std::vector<double> &inverse, double &log_determinant)
+        {
+            std::vector<double> factor(N * (N + 1) / 2);
+            
+            log_determinant = 0.0;
+            
+            for (GRT::UINT i = 0; i < N; ++i)
+            {
+                const GRT::UINT row = i * (i + 1) / 2;
+                
+                for (GRT::UINT j = 0; j <= i; ++j)
+                {
+                    const GRT::UINT column = j * (j + 1) / 2;
+                    double sum = sigma[i * N + j];
+                    
+                    for (GRT::UINT m = 0; m < j; ++m)
+                    {
+                        sum -= factor[row + m] * factor[column + m];
+                    }
+                    
+                    if (j < i)
+                    {
+                        factor[row + j] = sum / factor[column + j];
+                    }
+                    else if (sum > 0.0)
+                    {
+                        factor[row + i] = sqrt(sum);
+                        log_determinant += 2.0 * log(factor[row + i]);
+                    }
+                    else
+                    {
+                        return false;
+                    }
+                }
+            }
+            
+            inverse.assign(N * (N + 1) / 2, 0.0);
+            
+            for (GRT::UINT i = 0; i < N; ++i)
+            {
+                const GRT::UINT row = i * (i + 1) / 2;
+                
+                inverse[row + i] = 1.0 / factor[row + i];
+                
+                for (GRT::UINT j = 0; j < i; ++j)
+                {
+                    double sum = 0.0;
+                    
+                    for (GRT::UINT m = j; m < i; ++m)
+                    {
+                        sum += factor[row + m] * inverse[m * (m + 1) / 2 + j];
+                    }
+                    
+                    inverse[row + j] = -sum / factor[row + i];
+                }
+            }
+            
+            return true;
+        }
+        
+        GRT::UINT num_components;
+        GRT::UINT num_dimensions;
+        bool diagonal;
+        double log_normaliser;
+        std::vector<double> coefficients;
+        std::vector<double> offsets;
+        std::vector<double> log_scales;
+    };
+    
+    struct gmm_settings
+    {
+        GRT::UINT num_components;
+        bool diagonal;
+        GRT::UINT max_iterations;
+        double tolerance;
+        
+        // When not 0, the iteration and time at which the mean log-likelihood first reaches this value are recorded
+        double target_log_likelihood;
+        
+        // Upper bound on the worker threads of each EM pass, 0 uses every core
+        unsigned int max_workers;
+    };
+    
+    struct gmm_training_result
+    {
+        GRT::UINT num_iterations;
+        double log_likelihood;
+        
+        // 0 if target_log_likelihood was not set or not reached, the time is in milliseconds from the start of training
+        GRT::UINT target_iteration;
+        double target_time;
+    };
+    
+    // Fits a mixture of Gaussians to one class by EM. The means are seeded by k-means++ and the components start from
+    // the covariance of the samples nearest to each seed. Each iteration is a single parallel_block_sum pass over the
+    // data, computing the samples' responsibilities and summing the statistics of the M-step. Training stops after
+    // max_iterations or once the mean log-likelihood per sample changes by less than tolerance. A floor is kept on the
+    // variances and components that lose all their samples restart at a random one
+    class gmm_trainer
+    {
+    public:
+        gmm_trainer(const gmm_settings &settings)
+        :
+        settings(settings),
+        num_samples(0),
+        num_dimensions(0)
+        {}
+        
+        // data holds num_samples rows of num_dimensions values, the mixture is returned in the layout of
+        // gmm_mixture::compile() with the weight of component k in weights[k]
+        bool train(const std::vector<double> &data, GRT::UINT num_samples, GRT::UINT num_dimensions, GRT::Random &random, std::vector<double> &means, std::vector<double> &covariances, std::vector<double> &weights, gmm_training_result &result)
+        {
+            const GRT::UINT K = settings.num_components;
+            const GRT::UINT N = num_dimensions;
+            GRT::Timer timer;
+            
+            timer.start();
+            
+            if (num_samples < K || K == 0 || N == 0)
+            {
+                return false;
+            }
+            
+            this->num_samples = num_samples;
+            this->num_dimensions = N;
+            init_data(data);
+            seed(random, means, covariances, weights);
+            
+            const double log_normal = -0.5 * N * log(TWO_PI);
+            std::vector<double> log_weights(K);
+            double previous_log_likelihood = 0.0;
+            
+            result.num_iterations = 0;
+            result.log_likelihood = 0.0;
+            result.target_iteration = 0;
+            result.target_time = 0.0;
+            
+            while (result.num_iterations < settings.max_iterations)
+            {
+                if (!mixture.compile(&means[0], &covariances[0], K, N, settings.diagonal))
+                {
+                    return false;
+                }
+                
+                for (GRT::UINT k = 0; k < K; ++k)
+                {
+                    log_weights[k] = log(weights[k]) + log_normal;
+                }
+                
+                mixture.add_log_scales(&log_weights[0]);
+                
+                const double log_likelihood = accumulate();
+                
+                result.num_iterations++;
+                result.log_likelihood = log_likelihood;
+                
+                if (settings.target_log_likelihood != 0 && result.target_iteration == 0 && log_likelihood >= settings.target_log_likelihood)
+                {
+                    result.target_iteration = result.num_iterations;
+                    result.target_time = timer.getMilliSeconds();
+                }
+                
+                update(random, means, covariances, weights);
+                
+                if (result.num_iterations > 1 && fabs(log_likelihood - previous_log_likelihood) < settings.tolerance)
+                {
+                    break;
+                }
+                
+                previous_log_likelihood = log_likelihood;
+            }
+            
+            // The data was centred on its mean
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                for (GRT::UINT i = 0; i < N; ++i)
+                {
+                    means[k * N + i] += centre[i];
+                }
+            }
+            
+            return true;
+        }
+    
+    private:
+        // Number of second moment sums per component, the lower triangle of x x^T or its diagonal
+        GRT::UINT get_num_moments() const { return settings.diagonal ? num_dimensions : num_dimensions * (num_dimensions + 1) / 2; }
+        
+        // Centres the data, whose covariance becomes the starting point of any component left without samples
+        void init_data(const std::vector<double> &data)
+        {
+            const GRT::UINT N = num_dimensions;
+            
+            centre.assign(N, 0.0);
+            data_covariance.assign(settings.diagonal ? N : N * N, 0.0);
+            floor.resize(N);
+            samples.resize(num_samples * N);
+            
+            for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+            {
+                for (GRT::UINT i = 0; i < N; ++i)
+                {
+                    centre[i] += data[sample * N + i];
+                }
+            }
+            
+            for (GRT::UINT i = 0; i < N; ++i)
+            {
+                centre[i] /= num_samples;
+            }
+            
+            for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+            {
+                for (GRT::UINT i = 0; i < N; ++i)
+                {
+                    samples[sample * N + i] = data[sample * N + i] - centre[i];
+                }
+            }
+            
+            std::vector<GRT::UINT> all(num_samples);
+            
+            for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+            {
+                all[sample] = sample;
+            }
+            
+            scatter(all, NULL, &data_covariance[0]);
+            
+            for (GRT::UINT i = 0; i < N; ++i)
+            {
+                const double variance = settings.diagonal ? data_covariance[i] : data_covariance[i * N + i];
+                floor[i] = std::max(variance * k_gmm_relative_variance_floor, k_gmm_min_variance);
+            }
+            
+            add_floor(&data_covariance[0]);
+        }
+        
+        // Covariance of the given samples around centre, or around their mean if centre is NULL
+        void scatter(const std::vector<GRT::UINT> &members, const double *centre, double *covariance) const
+        {
+            const GRT::UINT N = num_dimensions;
+            const GRT::UINT size = settings.diagonal ? N : N * N;
+            std::vector<double> mean(N, 0.0);
+            
+            std::fill(covariance, covariance + size, 0.0);
+            
+            if (members.empty())
+            {
+                return;
+            }
+            
+            if (centre == NULL)
+            {
+                for (GRT::UINT member = 0; member < members.size(); ++member)
+                {
+                    for (GRT::UINT i = 0; i < N; ++i)
+                    {
+                        mean[i] += samples[members[member] * N + i];
+                    }
+                }
+                
+                for (GRT::UINT i = 0; i < N; ++i)
+                {
+                    mean[i] /= members.size();
+                }
+                
+                centre = &mean[0];
+            }
+            
+            for (GRT::UINT member = 0; member < members.size(); ++member)
+            {
+                const double *x = &samples[members[member] * N];
+                
+                for (GRT::UINT i = 0; i < N; ++i)
+                {
+                    const double difference = x[i] - centre[i];
+                    
+                    if (settings.diagonal)
+                    {
+                        covariance[i] += difference * difference;
+                        continue;
+                    }
+                    
+                    for (GRT::UINT j = 0; j <= i; ++j)
+                    {
+                        covariance[i * N + j] += difference * (x[j] - centre[j]);
+                    }
+                }
+            }
+            
+            for (GRT::UINT i = 0; i < N; ++i)
+            {
+                if (settings.diagonal)
+                {
+                    covariance[i] /= members.size();
+                    continue;
+                }
+                
+                for (GRT::UINT j = 0; j <= i; ++j)
+                {
+                    covariance[i * N + j] /= members.size();
+                    covariance[j * N + i] = covariance[i * N + j];
+                }
+            }
+        }
+        
+        // Raises variances to the floor, or adds the floor to the diagonal of a full covariance to keep it positive definite
+        void add_floor(double *covariance) const
+        {
+            for (GRT::UINT i = 0; i < num_dimensions; ++i)
+            {
+                if (settings.diagonal)
+                {
+                    covariance[i] = std::max(covariance[i], floor[i]);
+                }
+                else
+                {
+                    covariance[i * num_dimensions + i] += floor[i];
+                }
+            }
+        }
+        
+        // k-means++: the first mean is a random sample and every next one a sample drawn with probability proportional to
+        // its squared distance from the nearest mean so far. Each component starts with the covariance and share of the
+        // samples nearest to its mean
+        void seed(GRT::Random &random, std::vector<double> &means, std::vector<double> &covariances, std::vector<double> &weights) const
+        {
+            const GRT::UINT K = settings.num_components;
+            const GRT::UINT N = num_dimensions;
+            const GRT::UINT size = settings.diagonal ? N : N * N;
+            std::vector<double> distances(num_samples, std::numeric_limits<double>::max());
+            std::vector<GRT::UINT> nearest(num_samples, 0);
+            
+            means.resize(K * N);
+            covariances.resize(K * size);
+            weights.resize(K);
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                GRT::UINT chosen = 0;
+                double total = 0.0;
+                
+                for (GRT::UINT sample = 0; k > 0 && sample < num_samples; ++sample)
+                {
+                    total += distances[sample];
+                }
+                
+                if (total <= 0.0)
+                {
+                    chosen = std::min<GRT::UINT>(random.getRandomNumberInt(0, num_samples), num_samples - 1);
+                }
+                else
+                {
+                    double target = random.getRandomNumberUniform(0.0, total);
+                    
+                    for (chosen = 0; chosen + 1 < num_samples; ++chosen)
+                    {
+                        target -= distances[chosen];
+                        
+                        if (target < 0.0)
+                        {
+                            break;
+                        }
+                    }
+                }
+                
+                const double *mean = &samples[chosen * N];
+                
+                std::copy(mean, mean + N, &means[k * N]);
+                
+                parallel_for(get_num_blocks(num_samples), [&](unsigned int block, unsigned int)
+                {
+                    const GRT::UINT end = std::min(num_samples, (block + 1) * k_parallel_block_size);
+                    
+                    for (GRT::UINT sample = block * k_parallel_block_size; sample < end; ++sample)
+                    {
+                        const double *x = &samples[sample * N];
+                        double distance = 0.0;
+                        
+                        for (GRT::UINT i = 0; i < N; ++i)
+                        {
+                            distance += (x[i] - mean[i]) * (x[i] - mean[i]);
+                        }
+                        
+                        if (distance < distances[sample])
+                        {
+                            distances[sample] = distance;
+                            nearest[sample] = k;
+                        }
+                    }
+                }, settings.max_workers);
+            }
+            
+            std::vector<std::vector<GRT::UINT> > members(K);
+            
+            for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+            {
+                members[nearest[sample]].push_back(sample);
+            }
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                double *covariance = &covariances[k * size];
+                
+                if (members[k].size() < 2)
+                {
+                    std::copy(data_covariance.begin(), data_covariance.end(), covariance);
+                }
+                else
+                {
+                    scatter(members[k], &means[k * N], covariance);
+                    add_floor(covariance);
+                }
+                
+                weights[k] = std::max<double>(members[k].size(), 1.0) / num_samples;
+            }
+        }
+        
+        // E-step against the compiled mixture, summing each component's responsibility, first and second moments per
+        // block. Returns the mean log-likelihood per sample
+        double accumulate()
+        {
+            const GRT::UINT K = settings.num_components;
+            const GRT::UINT N = num_dimensions;
+            const GRT::UINT stride = 1 + N + get_num_moments();
+            
+            scratch.resize(get_num_workers(get_num_blocks(num_samples), settings.max_workers) * 2 * K);
+            
+            // The log-likelihood followed by the statistics of each component
+            parallel_block_sum(num_samples, 1 + K * stride, block_statistics, statistics, [&](GRT::UINT begin, GRT::UINT end, double *partial, unsigned int worker)
+            {
+                double *responsibilities = &scratch[worker * 2 * K];
+                double *projection = responsibilities + K;
+                double *component_statistics = partial + 1;
+                double log_likelihood = 0.0;
+                
+                for (GRT::UINT sample = begin; sample < end; ++sample)
+                {
+                    const double *x = &samples[sample * N];
+                    
+                    mixture.log_components(x, responsibilities, projection);
+                    
+                    const double maximum = *std::max_element(responsibilities, responsibilities + K);
+                    double sum = 0.0;
+                    
+                    for (GRT::UINT k = 0; k < K; ++k)
+                    {
+                        responsibilities[k] = exp(responsibilities[k] - maximum);
+                        sum += responsibilities[k];
+                    }
+                    
+                    log_likelihood += maximum + log(sum);
+                    
+                    for (GRT::UINT k = 0; k < K; ++k)
+                    {
+                        const double responsibility = responsibilities[k] / sum;
+                        double *moments = component_statistics + k * stride;
+                        double *second = moments + 1 + N;
+                        
+                        moments[0] += responsibility;
+                        
+                        for (GRT::UINT i = 0; i < N; ++i)
+                        {
+                            const double weighted = responsibility * x[i];
+                            
+                            moments[1 + i] += weighted;
+                            
+                            if (settings.diagonal)
+                            {
+                                second[i] += weighted * x[i];
+                                continue;
+                            }
+                            
+                            double *row = second + i * (i + 1) / 2;
+                            
+                            for (GRT::UINT j = 0; j <= i; ++j)
+                            {
+                                row[j] += weighted * x[j];
+                            }
+                        }
+                    }
+                }
+                
+                partial[0] = log_likelihood;
+            }, settings.max_workers);
+            
+            return statistics[0] / num_samples;
+        }
+        
+        // M-step from the statistics summed by accumulate()
+        void update(GRT::Random &random, std::vector<double> &means, std::vector<double> &covariances, std::vector<double> &weights) const
+        {
+            const GRT::UINT K = settings.num_components;
+            const GRT::UINT N = num_dimensions;
+            const GRT::UINT size = settings.diagonal ? N : N * N;
+            const GRT::UINT stride = 1 + N + get_num_moments();
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                const double *moments = &statistics[1 + k * stride];
+                const double *second = moments + 1 + N;
+                const double total = moments[0];
+                double *mean = &means[k * N];
+                double *covariance = &covariances[k * size];
+                
+                if (total <= std::numeric_limits<double>::min())
+                {
+                    const GRT::UINT sample = std::min<GRT::UINT>(random.getRandomNumberInt(0, num_samples), num_samples - 1);
+                    
+                    std::copy(&samples[sample * N], &samples[sample * N] + N, mean);
+                    std::copy(data_covariance.begin(), data_covariance.end(), covariance);
+                    weights[k] = 1.0 / num_samples;
+                    continue;
+                }
+                
+                for (GRT::UINT i = 0; i < N; ++i)
+                {
+                    mean[i] = moments[1 + i] / total;
+                }
+                
+                for (GRT::UINT i = 0; i < N; ++i)
+                {
+                    if (settings.diagonal)
+                    {
+                        covariance[i] = second[i] / total - mean[i] * mean[i];
+                        continue;
+                    }
+                    
+                    const double *row = second + i * (i + 1) / 2;
+                    
+                    for (GRT::UINT j = 0; j <= i; ++j)
+                    {
+                        covariance[i * N + j] = row[j] / total - mean[i] * mean[j];
+                        covariance[j * N + i] = covariance[i * N + j];
+                    }
+                }
+                
+                add_floor(covariance);
+                weights[k] = total / num_samples;
+            }
+        }
+        
+        const gmm_settings settings;
+        GRT::UINT num_samples;
+        GRT::UINT num_dimensions;
+        
+        // The class' samples centred on centre, row-major
+        std::vector<double> samples;
+        std::vector<double> centre;
+        std::vector<double> data_covariance;
+        std::vector<double> floor;
+        
+        gmm_mixture mixture;
+        std::vector<double> block_statistics;
+        std::vector<double> statistics;
+        std::vector<double> scratch;
+    };
+    
+    // GRT::GMM trained by gmm_trainer, one class per task on a pool of worker threads, and predicting from mixtures
+    // compiled to inverse Cholesky factors and evaluated in the log domain. It can also train and save models with
+    // diagonal covariance, which GRT has no support for. Full covariance models are stored in GRT's mixture models, so
+    // they are saved in GRT's format. Every class has its own RNG stream, so a non-zero seed gives the same model however
+    // the classes are scheduled
+    class ml_gmm_model : public GRT::GMM
+    {
+    public:
+        ml_gmm_model()
+        :
+        covariance(GMM_COVARIANCE_FULL),
+        seed(0),
+        target_log_likelihood(0)
+        {}
+        
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool saveModelToFile(fstream &file) const;
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        using GRT::GMM::train_;
+        using GRT::GMM::predict_;
+        using GRT::GMM::saveModelToFile;
+        using GRT::GMM::loadModelFromFile;
+        
+        // Covariance used by the next training, set to that of the model when one is loaded
+        bool set_covariance(GRT::UINT covariance);
+        GRT::UINT get_covariance() const { return covariance; }
+        
+        void set_seed(GRT::UINT seed) { this->seed = seed; }
+        GRT::UINT get_seed() const { return seed; }
+        
+        void set_target_log_likelihood(double target_log_likelihood) { this->target_log_likelihood = target_log_likelihood; }
+        double get_target_log_likelihood() const { return target_log_likelihood; }
+        
+        GRT::UINT get_num_mixture_models() const { return numMixtureModels; }
+        GRT::UINT get_max_iterations() const { return maxIter; }
+        double get_tolerance() const { return minChange; }
+        
+        // One result per class of the last training, empty once the model is cleared or loaded
+        const std::vector<gmm_training_result> &get_training_results() const { return training_results; }
+    
+    protected:
+        unsigned long long get_base_seed() const;
+        bool store_full_model(GRT::UINT k, const std::vector<double> &data, const std::vector<double> &means, const std::vector<double> &covariances);
+        bool save_diagonal_model(fstream &file) const;
+        bool load_diagonal_model(fstream &file);
+        void build_inference();
+        
+        GRT::UINT covariance;
+        GRT::UINT seed;
+        double target_log_likelihood;
+        std::vector<gmm_training_result> training_results;
+        
+        // Diagonal models only, GRT's models then just hold each class' label and null rejection threshold. Per class,
+        // the mean and variance of component k in dimension i at [k * numInputDimensions + i]
+        std::vector<std::vector<double> > means;
+        std::vector<std::vector<double> > variances;
+        
+        // Every class' mixture compiled for prediction, empty if a full covariance matrix was not positive definite
+        std::vector<gmm_mixture> mixtures;
+        std::vector<double> log_distances;
+        std::vector<double> scratch;
+        
+        static const std::string diagonal_model_header;
+    };
+    
+    const std::string ml_gmm_model::diagonal_model_header = "ML_GMM_DIAGONAL_MODEL_FILE_V1.0";
+    
+    bool ml_gmm_model::set_covariance(GRT::UINT covariance)
+    {
+        if (covariance >= GMM_NUM_COVARIANCES)
+        {
+            return false;
+        }
+        
+        this->covariance = covariance;
+        
+        return true;
+    }
+    
+    bool ml_gmm_model::train_(GRT::ClassificationData &trainingData)
+    {
+        clear();
+        
+        const GRT::UINT M = trainingData.getNumSamples();
+        
+        if (M == 0)
+        {
+            errorLog << "train_(ClassificationData &trainingData) - Training data is empty!" << endl;
+            return false;
+        }
+        
+        numInputDimensions = trainingData.getNumDimensions();
+        numClasses = trainingData.getNumClasses();
+        classLabels = trainingData.getClassLabels();
+        ranges = trainingData.getRanges();
+        
+        if (useScaling)
+        {
+            trainingData.scale(ranges, GMM_MIN_SCALE_VALUE, GMM_MAX_SCALE_VALUE);
+        }
+        
+        const GRT::UINT N = numInputDimensions;
+        std::vector<std::vector<double> > class_data(numClasses);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            const GRT::UINT k = (GRT::UINT)(std::find(classLabels.begin(), classLabels.end(), trainingData[i].getClassLabel()) - classLabels.begin());
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                class_data[k].push_back(trainingData[i][n]);
+            }
+        }
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            if (class_data[k].size() / N < numMixtureModels)
+            {
+                errorLog << "train_(ClassificationData &trainingData) - Class " << classLabels[k] << " has " << class_data[k].size() / N << " samples, fewer than the " << numMixtureModels << " mixture models" << endl;
+                clear();
+                return false;
+            }
+        }
+        
+        // Classes are trained in parallel, each sharing out the remaining cores to its EM passes
+        const unsigned int num_class_workers = get_num_workers(numClasses);
+        const unsigned long long base_seed = get_base_seed();
+        std::vector<std::vector<double> > class_means(numClasses);
+        std::vector<std::vector<double> > class_covariances(numClasses);
+        std::vector<char> success(numClasses, false);
+        gmm_settings settings;
+        
+        settings.num_components = numMixtureModels;
+        settings.diagonal = covariance == GMM_COVARIANCE_DIAGONAL;
+        settings.max_iterations = maxIter;
+        settings.tolerance = minChange;
+        settings.target_log_likelihood = target_log_likelihood;
+        settings.max_workers = std::max(1u, get_num_workers(std::numeric_limits<unsigned int>::max()) / num_class_workers);
+        training_results.resize(numClasses);
+        
+        parallel_for(numClasses, [&](unsigned int k, unsigned int)
+        {
+            GRT::Random random(base_seed + k + 1);
+            gmm_trainer trainer(settings);
+            std::vector<double> weights;
+            
+            success[k] = trainer.train(class_data[k], (GRT::UINT)class_data[k].size() / N, N, random, class_means[k], class_covariances[k], weights, training_results[k]);
+        }, num_class_workers);
+        
+        models.resize(numClasses);
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            if (!success[k] || (!settings.diagonal && !store_full_model(k, class_data[k], class_means[k], class_covariances[k])))
+            {
+                errorLog << "train_(ClassificationData &trainingData) - Failed to train model for class " << classLabels[k] << endl;
+                clear();
+                return false;
+            }
+            
+            trainingLog << "Class: " << classLabels[k] << " EM iterations: " << training_results[k].num_iterations << " Log-likelihood: " << training_results[k].log_likelihood << endl;
+            
+            models[k].setClassLabel(classLabels[k]);
+            models[k].recomputeNullRejectionThreshold(nullRejectionCoeff);
+        }
+        
+        if (settings.diagonal)
+        {
+            means.swap(class_means);
+            variances.swap(class_covariances);
+        }
+        
+        trained = true;
+        classLikelihoods.resize(numClasses);
+        classDistances.resize(numClasses);
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    // Fills GRT's mixture model of class k, including the determinants, inverse covariances and normalisation factor its
+    // prediction and file format use, and the statistics of the class' training likelihoods
+    bool ml_gmm_model::store_full_model(GRT::UINT k, const std::vector<double> &data, const std::vector<double> &means, const std::vector<double> &covariances)
+    {
+        const GRT::UINT K = numMixtureModels;
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT num_samples = (GRT::UINT)data.size() / N;
+        gmm_mixture mixture;
+        std::vector<double> inverse(N * N);
+        
+        if (!mixture.compile(&means[0], &covariances[0], K, N, false))
+        {
+            return false;
+        }
+        
+        models[k].resize(K);
+        
+        for (GRT::UINT component = 0; component < K; ++component)
+        {
+            GRT::GuassModel &model = models[k][component];
+            
+            mixture.get_inverse_covariance(component, &inverse[0]);
+            model.det = exp(mixture.get_log_determinant(component));
+            model.mu.resize(N);
+            model.sigma.resize(N, N);
+            model.invSigma.resize(N, N);
+            
+            for (GRT::UINT i = 0; i < N; ++i)
+            {
+                model.mu[i] = means[component * N + i];
+                
+                for (GRT::UINT j = 0; j < N; ++j)
+                {
+                    model.sigma[i][j] = covariances[(component * N + i) * N + j];
+                    model.invSigma[i][j] = inverse[i * N + j];
+                }
+            }
+        }
+        
+        models[k].recomputeNormalizationFactor();
+        
+        std::vector<double> likelihoods(num_samples);
+        std::vector<double> scratch(2 * K);
+        double mu = 0.0;
+        double sigma = 0.0;
+        
+        for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+        {
+            likelihoods[sample] = exp(mixture.log_likelihood(&data[sample * N], &scratch[0]));
+            mu += likelihoods[sample];
+        }
+        
+        mu /= num_samples;
+        
+        for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+        {
+            sigma += (likelihoods[sample] - mu) * (likelihoods[sample] - mu);
+        }
+        
+        sigma = num_samples > 1 ? sqrt(sigma / (num_samples - 1)) : 0.0;
+        models[k].setTrainingMuAndSigma(mu, sigma);
+        
+        return true;
+    }
+    
+    unsigned long long ml_gmm_model::get_base_seed() const
+    {
+        if (seed != 0)
+        {
+            return seed;
+        }
+        
+        GRT::Timer timer;
+        
+        return (unsigned long long)timer.getSystemTime();
+    }
+    
+    bool ml_gmm_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (mixtures.empty())
+        {
+            return GRT::GMM::predict_(inputVector);
+        }
+        
+        predictedClassLabel = 0;
+        
+        if (!trained)
+        {
+            errorLog << "predict_(VectorDouble &x) - Mixture Models have not been trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &x) - The size of the input vector (" << inputVector.size() << ") does not match that of the number of features the model was trained with (" << numInputDimensions << ")." << endl;
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+            {
+                inputVector[n] = scale(inputVector[n], ranges[n].minValue, ranges[n].maxValue, GMM_MIN_SCALE_VALUE, GMM_MAX_SCALE_VALUE);
+            }
+        }
+        
+        classLikelihoods.resize(numClasses);
+        classDistances.resize(numClasses);
+        log_distances.resize(numClasses);
+        
+        GRT::UINT bestIndex = 0;
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            log_distances[k] = mixtures[k].log_likelihood(&inputVector[0], &scratch[0]);
+            
+            if (log_distances[k] > log_distances[bestIndex])
+            {
+                bestIndex = k;
+            }
+        }
+        
+        // Normalised relative to the best class, so the likelihoods stay defined when every class' distance underflows
+        double sum = 0.0;
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            classDistances[k] = exp(log_distances[k]);
+            classLikelihoods[k] = exp(log_distances[k] - log_distances[bestIndex]);
+            sum += classLikelihoods[k];
+        }
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            classLikelihoods[k] /= sum;
+        }
+        
+        maxLikelihood = classLikelihoods[bestIndex];
+        
+        if (useNullRejection && log_distances[bestIndex] < log(models[bestIndex].getNullRejectionThreshold()))
+        {
+            predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+        }
+        else
+        {
+            predictedClassLabel = models[bestIndex].getClassLabel();
+        }
+        
+        return true;
+    }
+    
+    // Models with diagonal covariance are saved in their own format
+    bool ml_gmm_model::saveModelToFile(fstream &file) const
+    {
+        if (!means.empty())
+        {
+            return save_diagonal_model(file);
+        }
+        
+        return GRT::GMM::saveModelToFile(file);
+    }
+    
+    bool ml_gmm_model::loadModelFromFile(fstream &file)
+    {
+        clear();
+        
+        const std::streampos start = file.tellg();
+        std::string word;
+        
+        if (file >> word && word == diagonal_model_header)
+        {
+            if (!load_diagonal_model(file))
+            {
+                clear();
+                return false;
+            }
+            
+            covariance = GMM_COVARIANCE_DIAGONAL;
+            build_inference();
+            
+            return true;
+        }
+        
+        file.clear();
+        file.seekg(start);
+        
+        if (!GRT::GMM::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        covariance = GMM_COVARIANCE_FULL;
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_gmm_model::save_diagonal_model(fstream &file) const
+    {
+        if (!file.is_open())
+        {
+            return false;
+        }
+        
+        const std::streamsize precision = file.precision(17);
+        
+        file << diagonal_model_header << std::endl;
+        file << "Trained: " << trained << std::endl;
+        file << "NumFeatures: " << numInputDimensions << std::endl;
+        file << "NumClasses: " << numClasses << std::endl;
+        file << "NumMixtureModels: " << numMixtureModels << std::endl;
+        file << "MaxIter: " << maxIter << std::endl;
+        file << "MinChange: " << minChange << std::endl;
+        file << "UseScaling: " << useScaling << std::endl;
+        file << "UseNullRejection: " << useNullRejection << std::endl;
+        file << "NullRejectionCoeff: " << nullRejectionCoeff << std::endl;
+        
+        file << "Ranges:";
+        for (GRT::UINT n = 0; n < ranges.size(); ++n)
+        {
+            file << " " << ranges[n].minValue << " " << ranges[n].maxValue;
+        }
+        file << std::endl;
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            file << "Class: " << models[k].getClassLabel() << " " << models[k].getNullRejectionThreshold() << std::endl;
+            file << "Means:";
+            for (GRT::UINT index = 0; index < means[k].size(); ++index)
+            {
+                file << " " << means[k][index];
+            }
+            file << std::endl << "Variances:";
+            for (GRT::UINT index = 0; index < variances[k].size(); ++index)
+            {
+                file << " " << variances[k][index];
+            }
+            file << std::endl;
+        }
+        
+        file.precision(precision);
+        
+        return true;
+    }
+    
+    // Reads the fields written by save_diagonal_model(), after the header
+    bool ml_gmm_model::load_diagonal_model(fstream &file)
+    {
+        std::string word;
+        
+        file >> word >> trained;
+        file >> word >> numInputDimensions;
+        file >> word >> numClasses;
+        file >> word >> numMixtureModels;
+        file >> word >> maxIter;
+        file >> word >> minChange;
+        file >> word >> useScaling;
+        file >> word >> useNullRejection;
+        file >> word >> nullRejectionCoeff;
+        
+        if (!file || numMixtureModels == 0)
+        {
+            return false;
+        }
+        
+        ranges.resize(numInputDimensions);
+        
+        file >> word;
+        for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+        {
+            file >> ranges[n].minValue >> ranges[n].maxValue;
+        }
+        
+        const GRT::UINT size = numMixtureModels * numInputDimensions;
+        
+        models.resize(numClasses);
+        classLabels.resize(numClasses);
+        means.assign(numClasses, std::vector<double>(size));
+        variances.assign(numClasses, std::vector<double>(size));
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            GRT::UINT classLabel = 0;
+            double threshold = 0.0;
+            
+            file >> word >> classLabel >> threshold;
+            
+            file >> word;
+            for (GRT::UINT index = 0; index < size; ++index)
+            {
+                file >> means[k][index];
+            }
+            file >> word;
+            for (GRT::UINT index = 0; index < size; ++index)
+            {
+                file >> variances[k][index];
+            }
+            
+            classLabels[k] = classLabel;
+            models[k].setClassLabel(classLabel);
+            models[k].setNullRejectionThreshold(threshold);
+        }
+        
+        if (!file)
+        {
+            return false;
+        }
+        
+        classLikelihoods.resize(numClasses);
+        classDistances.resize(numClasses);
+        
+        return true;
+    }
+    
+    bool ml_gmm_model::clear()
+    {
+        training_results.clear();
+        means.clear();
+        variances.clear();
+        mixtures.clear();
+        
+        return GRT::GMM::clear();
+    }
+    
+    void ml_gmm_model::build_inference()
+    {
+        GRT::UINT max_components = 0;
+        
+        mixtures.assign(models.size(), gmm_mixture());
+        
+        for (GRT::UINT k = 0; k < models.size(); ++k)
+        {
+            const bool compiled = means.empty() ? mixtures[k].compile(models[k], numInputDimensions) : mixtures[k].compile(&means[k][0], &variances[k][0], numMixtureModels, numInputDimensions, true);
+            
+            if (!compiled)
+            {
+                mixtures.clear();
+                return;
+            }
+            
+            max_components = std::max(max_components, mixtures[k].get_num_components());
+        }
+        
+        scratch.resize(2 * max_components);
+    }
+    
     class ml_gmm : ml_classification
     {
         FLEXT_HEADER_S(ml_gmm, ml_classification, setup);
@@ -39,19 +1399,42 @@ namespace ml
         {
             // Flext attribute set messages
             FLEXT_CADDATTR_SET(c, "num_mixture_models", set_num_mixture_models);
+            FLEXT_CADDATTR_SET(c, "covariance", set_covariance);
+            FLEXT_CADDATTR_SET(c, "max_iterations", set_max_iterations);
+            FLEXT_CADDATTR_SET(c, "tolerance", set_tolerance);
+            FLEXT_CADDATTR_SET(c, "seed", set_seed);
+            FLEXT_CADDATTR_SET(c, "target_log_likelihood", set_target_log_likelihood);
             
             // Flext attribute get messages
             FLEXT_CADDATTR_GET(c, "num_mixture_models", get_num_mixture_models);
+            FLEXT_CADDATTR_GET(c, "covariance", get_covariance);
+            FLEXT_CADDATTR_GET(c, "max_iterations", get_max_iterations);
+            FLEXT_CADDATTR_GET(c, "tolerance", get_tolerance);
+            FLEXT_CADDATTR_GET(c, "seed", get_seed);
+            FLEXT_CADDATTR_GET(c, "target_log_likelihood", get_target_log_likelihood);
             
             // Associate this Flext class with a certain help file prefix
             DefineHelp(c, ml_object_name.c_str());
         }
         
+        // Method overrides
+        bool get_training_summary(GRT::UINT num_samples, double seconds, std::stringstream &summary) const;
+        
         // Flext attribute setters
         void set_num_mixture_models(int type);
+        void set_covariance(int covariance);
+        void set_max_iterations(int max_iterations);
+        void set_tolerance(float tolerance);
+        void set_seed(int seed);
+        void set_target_log_likelihood(float target_log_likelihood);
         
         // Flext attribute getters
         void get_num_mixture_models(int &type) const;
+        void get_covariance(int &covariance) const;
+        void get_max_iterations(int &max_iterations) const;
+        void get_tolerance(float &tolerance) const;
+        void get_seed(int &seed) const;
+        void get_target_log_likelihood(float &target_log_likelihood) const;
         
         // Pure virtual method implementations
         GRT::Classifier &get_Classifier_instance();
@@ -60,11 +1443,16 @@ namespace ml
     private:
         // Flext Flext attribute wrappers
         FLEXT_CALLVAR_I(get_num_mixture_models, set_num_mixture_models);
+        FLEXT_CALLVAR_I(get_covariance, set_covariance);
+        FLEXT_CALLVAR_I(get_max_iterations, set_max_iterations);
+        FLEXT_CALLVAR_F(get_tolerance, set_tolerance);
+        FLEXT_CALLVAR_I(get_seed, set_seed);
+        FLEXT_CALLVAR_F(get_target_log_likelihood, set_target_log_likelihood);
         
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        GRT::GMM gmm;
+        ml_gmm_model gmm;
         
         static const std::string attribute_help;
     };
@@ -72,14 +1460,127 @@ namespace ml
     // Flext attribute setters
     void ml_gmm::set_num_mixture_models(int num_mixture_models)
     {
-        gmm.setNumMixtureModels(num_mixture_models);
+        bool success = gmm.setNumMixtureModels(num_mixture_models);
+        
+        if (success == false)
+        {
+            error("unable to set num_mixture_models, hint: should be greater than 0");
+        }
+    }
+    
+    void ml_gmm::set_covariance(int covariance)
+    {
+        bool success = covariance >= 0 && gmm.set_covariance(covariance);
+        
+        if (success == false)
+        {
+            error("invalid covariance: " + std::to_string(covariance) + ", must be " + std::to_string(GMM_COVARIANCE_FULL) + ":FULL or " + std::to_string(GMM_COVARIANCE_DIAGONAL) + ":DIAGONAL");
+        }
+    }
+    
+    void ml_gmm::set_max_iterations(int max_iterations)
+    {
+        bool success = max_iterations > 0 && gmm.setMaxIter(max_iterations);
+        
+        if (success == false)
+        {
+            error("unable to set max_iterations, hint: should be greater than 0");
+        }
+    }
+    
+    void ml_gmm::set_tolerance(float tolerance)
+    {
+        bool success = gmm.setMinChange(tolerance);
+        
+        if (success == false)
+        {
+            error("unable to set tolerance, hint: should be greater than 0");
+        }
+    }
+    
+    void ml_gmm::set_seed(int seed)
+    {
+        if (seed < 0)
+        {
+            error("seed must be 0 or greater");
+            return;
+        }
+        
+        gmm.set_seed(seed);
     }
     
+    void ml_gmm::set_target_log_likelihood(float target_log_likelihood)
+    {
+        gmm.set_target_log_likelihood(target_log_likelihood);
+    }
     
     // Flext attribute getters
     void ml_gmm::get_num_mixture_models(int &num_mixture_models) const
     {
-        flext::error("function not implemented");
+        num_mixture_models = gmm.get_num_mixture_models();
+    }
+    
+    void ml_gmm::get_covariance(int &covariance) const
+    {
+        covariance = gmm.get_covariance();
+    }
+    
+    void ml_gmm::get_max_iterations(int &max_iterations) const
+    {
+        max_iterations = gmm.get_max_iterations();
+    }
+    
+    void ml_gmm::get_tolerance(float &tolerance) const
+    {
+        tolerance = gmm.get_tolerance();
+    }
+    
+    void ml_gmm::get_seed(int &seed) const
+    {
+        seed = gmm.get_seed();
+    }
+    
+    void ml_gmm::get_target_log_likelihood(float &target_log_likelihood) const
+    {
+        target_log_likelihood = gmm.get_target_log_likelihood();
+    }
+    
+    // Method overrides
+    // The EM iterations so initialisations and settings can be compared, and when target_log_likelihood is set, when
+    // every class reached it
+    bool ml_gmm::get_training_summary(GRT::UINT, double, std::stringstream &summary) const
+    {
+        const std::vector<gmm_training_result> &results = gmm.get_training_results();
+        GRT::UINT max_iterations = 0;
+        GRT::UINT target_iteration = 0;
+        double target_time = 0.0;
+        double log_likelihood = 0.0;
+        bool reached = true;
+        
+        for (GRT::UINT k = 0; k < results.size(); ++k)
+        {
+            max_iterations = std::max(max_iterations, results[k].num_iterations);
+            target_iteration = std::max(target_iteration, results[k].target_iteration);
+            target_time = std::max(target_time, results[k].target_time);
+            log_likelihood += results[k].log_likelihood / results.size();
+            reached = reached && results[k].target_iteration > 0;
+        }
+        
+        summary << ", " << results.size() << " classes, at most " << max_iterations << " EM iterations per class, mean log-likelihood " << log_likelihood;
+        
+        if (gmm.get_target_log_likelihood() != 0)
+        {
+            if (reached)
+            {
+                summary << "\nreached target_log_likelihood " << gmm.get_target_log_likelihood() << " in every class by iteration " << target_iteration << " after " << target_time / 1000.0 << "s";
+            }
+            else
+            {
+                summary << "\ntarget_log_likelihood " << gmm.get_target_log_likelihood() << " not reached in every class";
+            }
+        }
+        
+        return true;
     }
     
     // Implement pure virtual methods
@@ -94,7 +1595,12 @@ namespace ml
     }
     
     const std::string ml_gmm::attribute_help =
-    "num_mixture_models:\tinteger (n > 0) sets the number of mixture models used for class (default 2)\n";
+    "num_mixture_models:\tinteger (n > 0) sets the number of mixture models used for class (default 2)\n"
+    "covariance:\tinteger selecting the covariance matrix of each mixture model, 0:FULL, 1:DIAGONAL; diagonal models need O(n) memory and time per mixture model for n features instead of O(n^2) and are saved in their own model format (default FULL)\n"
+    "max_iterations:\tinteger (n > 0) setting the maximum number of EM iterations used to train each class (default 100)\n"
+    "tolerance:\tfloating point value (> 0), training of a class stops once its mean log-likelihood per sample changes by less than this between two EM iterations (default 1.0e-5)\n"
+    "seed:\tinteger seeding the k-means++ initialisation of every class, any value other than 0 makes training reproducible, 0 seeds from the clock (default 0)\n"
+    "target_log_likelihood:\tfloating point value, when not 0 training also posts the iteration and time by which every class reached this mean log-likelihood per sample (default 0)\n";
         
     typedef class ml_gmm ml0x2egmm;
     
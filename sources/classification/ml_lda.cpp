@@ -16,76 +16,1002 @@
  * this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-
-// TODO: GRT header states class is still under development (August 5th 2014)
-
 #include "ml_classification.h"
+#include "ml_parallel.h"
+#include "ml_linalg.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ml
 {
     static const std::string ml_object_name = "ml.lda";
     
+    enum lda_output
+    {
+        LDA_OUTPUT_LABEL,
+        LDA_OUTPUT_PROJECTION,
+        LDA_NUM_OUTPUTS
+    };
+    
+    const double k_lda_default_regularisation = 1.0e-6;
+    const double k_lda_default_null_rejection_coeff = 3.0;
+    
+    // Limits of the Jacobi eigenvalue iteration, which stops once the off-diagonal elements are negligible
+    const GRT::UINT k_lda_max_sweeps = 100;
+    const double k_lda_eigen_tolerance = 1.0e-24;
+    
     // Utility functions
     
+    // Overwrites every column of the N x N row-major matrix b with L^-1 times it
+    void lda_forward_substitute(const std::vector<double> &L, std::vector<double> &b, GRT::UINT N)
+    {
+        for (GRT::UINT i = 0; i < N; ++i)
+        {
+            double *row_i = &b[i * N];
+            
+            for (GRT::UINT k = 0; k < i; ++k)
+            {
+                const double factor = L[i * N + k];
+                const double *row_k = &b[k * N];
+                
+                for (GRT::UINT column = 0; column < N; ++column)
+                {
+                    row_i[column] -= factor * row_k[column];
+                }
+            }
+            
+            const double scale = 1.0 / L[i * N + i];
+            
+            for (GRT::UINT column = 0; column < N; ++column)
+            {
+                row_i[column] *= scale;
+            }
+        }
+    }
+    
+    // Eigen-decomposes the symmetric N x N row-major matrix a with cyclic Jacobi rotations, which are accurate for
+    // every eigenvalue however close. a is left diagonal with the eigenvalues and the columns of vectors are the
+    // eigenvectors
+    void lda_jacobi(std::vector<double> &a, std::vector<double> &vectors, GRT::UINT N)
+    {
+        vectors.assign(N * N, 0.0);
+        
+        for (GRT::UINT n = 0; n < N; ++n)
+        {
+            vectors[n * N + n] = 1.0;
+        }
+        
+        for (GRT::UINT sweep = 0; sweep < k_lda_max_sweeps; ++sweep)
+        {
+            double off_diagonal = 0.0;
+            double diagonal = 0.0;
+            
+            for (GRT::UINT p = 0; p < N; ++p)
+            {
+                diagonal += a[p * N + p] * a[p * N + p];
+                
+                for (GRT::UINT q = p + 1; q < N; ++q)
+                {
+                    off_diagonal += a[p * N + q] * a[p * N + q];
+                }
+            }
+            
+            if (off_diagonal <= k_lda_eigen_tolerance * diagonal)
+            {
+                return;
+            }
+            
+            for (GRT::UINT p = 0; p < N; ++p)
+            {
+                for (GRT::UINT q = p + 1; q < N; ++q)
+                {
+                    const double a_pq = a[p * N + q];
+                    
+                    if (a_pq == 0.0)
+                    {
+                        continue;
+                    }
+                    
+                    const double theta = (a[q * N + q] - a[p * N + p]) / (2.0 * a_pq);
+                    const double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                    const double c = 1.0 / sqrt(t * t + 1.0);
+                    const double s = t * c;
+                    
+                    for (GRT::UINT k = 0; k < N; ++k)
+                    {
+                        const double a_kp = a[k * N + p];
+                        const double a_kq = a[k * N + q];
+                        
+                        a[k * N + p] = c * a_kp - s * a_kq;
+                        a[k * N + q] = s * a_kp + c * a_kq;
+                    }
+                    
+                    for (GRT::UINT k = 0; k < N; ++k)
+                    {
+                        const double a_pk = a[p * N + k];
+                        const double a_qk = a[q * N + k];
+                        
+                        a[p * N + k] = c * a_pk - s * a_qk;
+                        a[q * N + k] = s * a_pk + c * a_qk;
+                    }
+                    
+                    for (GRT::UINT k = 0; k < N; ++k)
+                    {
+                        const double v_kp = vectors[k * N + p];
+                        const double v_kq = vectors[k * N + q];
+                        
+                        vectors[k * N + p] = c * v_kp - s * v_kq;
+                        vectors[k * N + q] = s * v_kp + c * v_kq;
+                    }
+                }
+            }
+        }
+    }
+    
+    // Fisher linear discriminant analysis. Training finds the directions that maximise the between-class variance
+    // relative to the pooled within-class variance by whitening the within-class covariance with its Cholesky factor
+    // and eigen-decomposing the whitened between-class covariance. The projection onto the leading directions has an
+    // identity within-class covariance, so a prediction is the class whose projected mean is nearest after adding the
+    // log of its prior. GRT::LDA is unfinished, so this derives from GRT::Classifier and has its own model format
+    class ml_lda_model : public GRT::Classifier
+    {
+    public:
+        ml_lda_model()
+        :
+        regularisation(k_lda_default_regularisation),
+        num_dimensions(0),
+        projection_size(0),
+        explained_variance(0.0)
+        {
+            classType = "LDA";
+            classifierType = classType;
+            nullRejectionCoeff = k_lda_default_null_rejection_coeff;
+            debugLog.setProceedingText("[DEBUG LDA]");
+            errorLog.setProceedingText("[ERROR LDA]");
+            trainingLog.setProceedingText("[TRAINING LDA]");
+            warningLog.setProceedingText("[WARNING LDA]");
+        }
+        
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool saveModelToFile(fstream &file) const;
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        bool recomputeNullRejectionThresholds();
+        
+        using GRT::Classifier::train_;
+        using GRT::Classifier::predict_;
+        using GRT::Classifier::saveModelToFile;
+        using GRT::Classifier::loadModelFromFile;
+        
+        // The projection of the last input given to predict(), projection_size values
+        const std::vector<double> &get_projection() const { return projected; }
+        
+        bool set_regularisation(double regularisation)
+        {
+            if (regularisation < 0)
+            {
+                return false;
+            }
+            this->regularisation = regularisation;
+            return true;
+        }
+        
+        // 0 keeps every discriminant direction, one less than the number of classes
+        bool set_num_dimensions(int num_dimensions)
+        {
+            if (num_dimensions < 0)
+            {
+                return false;
+            }
+            this->num_dimensions = num_dimensions;
+            return true;
+        }
+        
+        double get_regularisation() const { return regularisation; }
+        GRT::UINT get_num_dimensions() const { return num_dimensions; }
+        GRT::UINT get_projection_size() const { return projection_size; }
+        
+        // Share of the between-class variance kept by the trained projection
+        double get_explained_variance() const { return explained_variance; }
+    
+    protected:
+        void compute_scatter(const std::vector<double> &inputs, const std::vector<GRT::UINT> &targets, const std::vector<double> &class_centres, std::vector<double> &scatter) const;
+        void project(const double *input, double *output) const;
+        bool load_model(fstream &file);
+        
+        double regularisation;
+        GRT::UINT num_dimensions;
+        
+        GRT::UINT projection_size;
+        double explained_variance;
+        
+        // Row d of the projection at [d * numInputDimensions], projections are centred on the mean of the training data
+        std::vector<double> projection;
+        std::vector<double> projection_offset;
+        
+        // Projected mean of class k at [k * projection_size]
+        std::vector<double> class_means;
+        std::vector<double> log_priors;
+        
+        // Mean and standard deviation of the training samples' distances to their projected class mean
+        std::vector<double> distance_means;
+        std::vector<double> distance_deviations;
+        
+        std::vector<double> projected;
+        
+        static const std::string model_header;
+    };
+    
+    const std::string ml_lda_model::model_header = "ML_LDA_MODEL_FILE_V1.0";
+    
+    bool ml_lda_model::train_(GRT::ClassificationData &trainingData)
+    {
+        clear();
+        
+        const GRT::UINT M = trainingData.getNumSamples();
+        const GRT::UINT N = trainingData.getNumDimensions();
+        const GRT::UINT K = trainingData.getNumClasses();
+        
+        if (M == 0)
+        {
+            errorLog << "train_(ClassificationData &trainingData) - Training data has zero samples!" << endl;
+            return false;
+        }
+        
+        if (K < 2)
+        {
+            errorLog << "train_(ClassificationData &trainingData) - Training data must contain at least two classes!" << endl;
+            return false;
+        }
+        
+        numInputDimensions = N;
+        numClasses = K;
+        classLabels = trainingData.getClassLabels();
+        ranges = trainingData.getRanges();
+        
+        if (useScaling)
+        {
+            trainingData.scale(ranges, 0, 1);
+        }
+        
+        std::vector<double> inputs(M * N);
+        std::vector<GRT::UINT> targets(M);
+        std::vector<double> class_centres(K * N, 0.0);
+        std::vector<double> mean(N, 0.0);
+        std::vector<GRT::UINT> class_sizes(K, 0);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            const GRT::UINT k = (GRT::UINT)(std::find(classLabels.begin(), classLabels.end(), trainingData[i].getClassLabel()) - classLabels.begin());
+            
+            targets[i] = k;
+            class_sizes[k]++;
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                inputs[i * N + n] = trainingData[i][n];
+                class_centres[k * N + n] += inputs[i * N + n];
+            }
+        }
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                mean[n] += class_centres[k * N + n] / M;
+                class_centres[k * N + n] /= class_sizes[k];
+            }
+        }
+        
+        // Pooled within-class covariance, shrunk towards a multiple of the identity so that it is well conditioned even
+        // with constant or collinear features
+        std::vector<double> within;
+        
+        compute_scatter(inputs, targets, class_centres, within);
+        
+        const double degrees_of_freedom = M > K ? M - K : M;
+        double trace = 0.0;
+        
+        for (GRT::UINT index = 0; index < N * N; ++index)
+        {
+            within[index] /= degrees_of_freedom;
+        }
+        
+        for (GRT::UINT n = 0; n < N; ++n)
+        {
+            trace += within[n * N + n];
+        }
+        
+        const double ridge = regularisation * (trace > 0.0 ? trace / N : 1.0);
+        
+        for (GRT::UINT n = 0; n < N; ++n)
+        {
+            within[n * N + n] += ridge;
+        }
+        
+        if (!cholesky_decompose(within, N))
+        {
+            errorLog << "train_(ClassificationData &trainingData) - The within-class covariance matrix is singular, increase the regularisation!" << endl;
+            clear();
+            return false;
+        }
+        
+        // Between-class covariance, whitened to L^-1 B L^-T
+        std::vector<double> between(N * N, 0.0);
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            const double weight = (double)class_sizes[k] / M;
+            
+            for (GRT::UINT row = 0; row < N; ++row)
+            {
+                const double difference = weight * (class_centres[k * N + row] - mean[row]);
+                
+                for (GRT::UINT column = 0; column < N; ++column)
+                {
+                    between[row * N + column] += difference * (class_centres[k * N + column] - mean[column]);
+                }
+            }
+        }
+        
+        lda_forward_substitute(within, between, N);
+        
+        for (GRT::UINT row = 0; row < N; ++row)
+        {
+            for (GRT::UINT column = row + 1; column < N; ++column)
+            {
+                std::swap(between[row * N + column], between[column * N + row]);
+            }
+        }
+        
+        lda_forward_substitute(within, between, N);
+        
+        for (GRT::UINT row = 0; row < N; ++row)
+        {
+            for (GRT::UINT column = row + 1; column < N; ++column)
+            {
+                const double value = 0.5 * (between[row * N + column] + between[column * N + row]);
+                
+                between[row * N + column] = value;
+                between[column * N + row] = value;
+            }
+        }
+        
+        std::vector<double> vectors;
+        std::vector<GRT::UINT> order(N);
+        double total_variance = 0.0;
+        
+        lda_jacobi(between, vectors, N);
+        
+        for (GRT::UINT n = 0; n < N; ++n)
+        {
+            order[n] = n;
+            total_variance += std::max(0.0, between[n * N + n]);
+        }
+        
+        std::sort(order.begin(), order.end(), [&](GRT::UINT a, GRT::UINT b)
+        {
+            return between[a * N + a] > between[b * N + b];
+        });
+        
+        const GRT::UINT D = std::min(N, num_dimensions == 0 ? K - 1 : num_dimensions);
+        
+        projection_size = D;
+        projection.assign(D * N, 0.0);
+        projection_offset.assign(D, 0.0);
+        explained_variance = 0.0;
+        
+        for (GRT::UINT d = 0; d < D; ++d)
+        {
+            const GRT::UINT index = order[d];
+            double *direction = &projection[d * N];
+            GRT::UINT largest = 0;
+            
+            explained_variance += std::max(0.0, between[index * N + index]);
+            
+            // Solve L^T v = u, so that v^T W v = 1 for the within-class covariance W
+            for (GRT::UINT n = N; n-- > 0;)
+            {
+                double value = vectors[n * N + index];
+                
+                for (GRT::UINT k = n + 1; k < N; ++k)
+                {
+                    value -= within[k * N + n] * direction[k];
+                }
+                
+                direction[n] = value / within[n * N + n];
+                
+                if (fabs(direction[n]) > fabs(direction[largest]))
+                {
+                    largest = n;
+                }
+            }
+            
+            // The sign of an eigenvector is arbitrary, make its largest weight positive so training is repeatable
+            const double sign = direction[largest] < 0.0 ? -1.0 : 1.0;
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                direction[n] *= sign;
+                projection_offset[d] += direction[n] * mean[n];
+            }
+        }
+        
+        explained_variance = total_variance > 0.0 ? explained_variance / total_variance : 1.0;
+        
+        class_means.resize(K * D);
+        log_priors.resize(K);
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            project(&class_centres[k * N], &class_means[k * D]);
+            log_priors[k] = log((double)class_sizes[k] / M);
+        }
+        
+        // Statistics of each class' distances for the NULL rejection thresholds
+        std::vector<double> output(D);
+        
+        distance_means.assign(K, 0.0);
+        distance_deviations.assign(K, 0.0);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            const GRT::UINT k = targets[i];
+            const double *class_mean = &class_means[k * D];
+            double distance = 0.0;
+            
+            project(&inputs[i * N], &output[0]);
+            
+            for (GRT::UINT d = 0; d < D; ++d)
+            {
+                distance += (output[d] - class_mean[d]) * (output[d] - class_mean[d]);
+            }
+            
+            distance = sqrt(distance);
+            distance_means[k] += distance;
+            distance_deviations[k] += distance * distance;
+        }
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            distance_means[k] /= class_sizes[k];
+            distance_deviations[k] = sqrt(std::max(0.0, distance_deviations[k] / class_sizes[k] - distance_means[k] * distance_means[k]));
+        }
+        
+        projected.resize(D);
+        classLikelihoods.resize(K);
+        classDistances.resize(K);
+        trained = true;
+        
+        recomputeNullRejectionThresholds();
+        
+        return true;
+    }
+    
+    // Accumulates the within-class scatter matrix with parallel_block_sum
+    void ml_lda_model::compute_scatter(const std::vector<double> &inputs, const std::vector<GRT::UINT> &targets, const std::vector<double> &class_centres, std::vector<double> &scatter) const
+    {
+        const GRT::UINT M = (GRT::UINT)targets.size();
+        const GRT::UINT N = numInputDimensions;
+        std::vector<double> block_scatters;
+        std::vector<double> differences(get_num_workers(get_num_blocks(M)) * N);
+        
+        parallel_block_sum(M, N * N, block_scatters, scatter, [&](GRT::UINT begin, GRT::UINT end, double *block_scatter, unsigned int worker)
+        {
+            double *difference = &differences[worker * N];
+            
+            for (GRT::UINT i = begin; i < end; ++i)
+            {
+                const double *input = &inputs[i * N];
+                const double *centre = &class_centres[targets[i] * N];
+                
+                for (GRT::UINT n = 0; n < N; ++n)
+                {
+                    difference[n] = input[n] - centre[n];
+                }
+                
+                // Lower triangle only, the matrix is symmetric
+                for (GRT::UINT row = 0; row < N; ++row)
+                {
+                    const double value = difference[row];
+                    double *scatter_row = block_scatter + row * N;
+                    
+                    for (GRT::UINT column = 0; column <= row; ++column)
+                    {
+                        scatter_row[column] += value * difference[column];
+                    }
+                }
+            }
+        });
+        
+        for (GRT::UINT row = 0; row < N; ++row)
+        {
+            for (GRT::UINT column = row + 1; column < N; ++column)
+            {
+                scatter[row * N + column] = scatter[column * N + row];
+            }
+        }
+    }
+    
+    void ml_lda_model::project(const double *input, double *output) const
+    {
+        const GRT::UINT N = numInputDimensions;
+        
+        for (GRT::UINT d = 0; d < projection_size; ++d)
+        {
+            const double *direction = &projection[d * N];
+            double value = -projection_offset[d];
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                value += direction[n] * input[n];
+            }
+            
+            output[d] = value;
+        }
+    }
+    
+    bool ml_lda_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        predictedClassLabel = 0;
+        maxLikelihood = 0;
+        
+        if (!trained)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - LDA Model Not Trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - The size of the input vector (" << inputVector.size() << ") does not match the num features in the model (" << numInputDimensions << endl;
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+            {
+                inputVector[n] = scale(inputVector[n], ranges[n].minValue, ranges[n].maxValue, 0, 1);
+            }
+        }
+        
+        const GRT::UINT D = projection_size;
+        
+        project(&inputVector[0], &projected[0]);
+        
+        // Discriminant of each class, the log-likelihood of the projection up to a constant
+        GRT::UINT bestIndex = 0;
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            const double *class_mean = &class_means[k * D];
+            double distance = 0.0;
+            
+            for (GRT::UINT d = 0; d < D; ++d)
+            {
+                distance += (projected[d] - class_mean[d]) * (projected[d] - class_mean[d]);
+            }
+            
+            classDistances[k] = sqrt(distance);
+            classLikelihoods[k] = log_priors[k] - 0.5 * distance;
+            
+            if (classLikelihoods[k] > classLikelihoods[bestIndex])
+            {
+                bestIndex = k;
+            }
+        }
+        
+        const double max_discriminant = classLikelihoods[bestIndex];
+        double sum = 0.0;
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            classLikelihoods[k] = exp(classLikelihoods[k] - max_discriminant);
+            sum += classLikelihoods[k];
+        }
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            classLikelihoods[k] /= sum;
+        }
+        
+        maxLikelihood = classLikelihoods[bestIndex];
+        bestDistance = classDistances[bestIndex];
+        
+        if (useNullRejection && bestDistance > nullRejectionThresholds[bestIndex])
+        {
+            predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+        }
+        else
+        {
+            predictedClassLabel = classLabels[bestIndex];
+        }
+        
+        return true;
+    }
+    
+    bool ml_lda_model::recomputeNullRejectionThresholds()
+    {
+        if (!trained)
+        {
+            return false;
+        }
+        
+        nullRejectionThresholds.resize(numClasses);
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            nullRejectionThresholds[k] = distance_means[k] + nullRejectionCoeff * distance_deviations[k];
+        }
+        
+        return true;
+    }
+    
+    bool ml_lda_model::clear()
+    {
+        projection_size = 0;
+        explained_variance = 0.0;
+        projection.clear();
+        projection_offset.clear();
+        class_means.clear();
+        log_priors.clear();
+        distance_means.clear();
+        distance_deviations.clear();
+        projected.clear();
+        
+        return GRT::Classifier::clear();
+    }
+    
+    bool ml_lda_model::saveModelToFile(fstream &file) const
+    {
+        if (!file.is_open())
+        {
+            errorLog << "saveModelToFile(fstream &file) - The file is not open!" << endl;
+            return false;
+        }
+        
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT D = projection_size;
+        const std::streamsize precision = file.precision(17);
+        
+        file << model_header << std::endl;
+        file << "Trained: " << trained << std::endl;
+        file << "NumFeatures: " << N << std::endl;
+        file << "NumClasses: " << numClasses << std::endl;
+        file << "NumDimensions: " << D << std::endl;
+        file << "Regularisation: " << regularisation << std::endl;
+        file << "UseScaling: " << useScaling << std::endl;
+        file << "UseNullRejection: " << useNullRejection << std::endl;
+        file << "NullRejectionCoeff: " << nullRejectionCoeff << std::endl;
+        
+        if (trained)
+        {
+            file << "Ranges:";
+            for (GRT::UINT n = 0; n < ranges.size(); ++n)
+            {
+                file << " " << ranges[n].minValue << " " << ranges[n].maxValue;
+            }
+            file << std::endl;
+            
+            for (GRT::UINT d = 0; d < D; ++d)
+            {
+                file << "Direction: " << projection_offset[d];
+                for (GRT::UINT n = 0; n < N; ++n)
+                {
+                    file << " " << projection[d * N + n];
+                }
+                file << std::endl;
+            }
+            
+            for (GRT::UINT k = 0; k < numClasses; ++k)
+            {
+                file << "Class: " << classLabels[k] << " " << log_priors[k] << " " << distance_means[k] << " " << distance_deviations[k];
+                for (GRT::UINT d = 0; d < D; ++d)
+                {
+                    file << " " << class_means[k * D + d];
+                }
+                file << std::endl;
+            }
+        }
+        
+        file.precision(precision);
+        
+        return true;
+    }
+    
+    bool ml_lda_model::loadModelFromFile(fstream &file)
+    {
+        clear();
+        
+        if (!file.is_open())
+        {
+            errorLog << "loadModelFromFile(fstream &file) - Could not open file to load model!" << endl;
+            return false;
+        }
+        
+        std::string word;
+        
+        file >> word;
+        
+        if (word != model_header)
+        {
+            errorLog << "loadModelFromFile(fstream &file) - Could not find Model File Header!" << endl;
+            return false;
+        }
+        
+        if (!load_model(file))
+        {
+            errorLog << "loadModelFromFile(fstream &file) - Failed to load the LDA model!" << endl;
+            clear();
+            return false;
+        }
+        
+        return true;
+    }
+    
+    // Reads the fields written by saveModelToFile(), after the header
+    bool ml_lda_model::load_model(fstream &file)
+    {
+        std::string word;
+        bool is_trained = false;
+        
+        file >> word >> is_trained;
+        file >> word >> numInputDimensions;
+        file >> word >> numClasses;
+        file >> word >> projection_size;
+        file >> word >> regularisation;
+        file >> word >> useScaling;
+        file >> word >> useNullRejection;
+        file >> word >> nullRejectionCoeff;
+        
+        if (!file)
+        {
+            return false;
+        }
+        
+        if (!is_trained)
+        {
+            return true;
+        }
+        
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT D = projection_size;
+        
+        ranges.resize(N);
+        
+        file >> word;
+        for (GRT::UINT n = 0; n < N; ++n)
+        {
+            file >> ranges[n].minValue >> ranges[n].maxValue;
+        }
+        
+        projection.resize(D * N);
+        projection_offset.resize(D);
+        
+        for (GRT::UINT d = 0; d < D; ++d)
+        {
+            file >> word >> projection_offset[d];
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                file >> projection[d * N + n];
+            }
+        }
+        
+        classLabels.resize(numClasses);
+        log_priors.resize(numClasses);
+        distance_means.resize(numClasses);
+        distance_deviations.resize(numClasses);
+        class_means.resize(numClasses * D);
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            file >> word >> classLabels[k] >> log_priors[k] >> distance_means[k] >> distance_deviations[k];
+            for (GRT::UINT d = 0; d < D; ++d)
+            {
+                file >> class_means[k * D + d];
+            }
+        }
+        
+        if (!file || numClasses == 0)
+        {
+            return false;
+        }
+        
+        projected.resize(D);
+        classLikelihoods.resize(numClasses);
+        classDistances.resize(numClasses);
+        trained = true;
+        
+        recomputeNullRejectionThresholds();
+        
+        return true;
+    }
     
     // Class declaration
     class ml_lda : ml_classification
     {
         FLEXT_HEADER_S(ml_lda, ml_classification, setup);
-        
+    
     public:
         ml_lda()
+        :
+        output(LDA_OUTPUT_LABEL)
         {
             post("LDA algorithm based on the GRT library version " + GRT::GRTBase::getGRTVersion());
             set_scaling(default_scaling);
+            help.append_attributes(attribute_help);
         }
         
         ~ml_lda()
         {
             
         }
-        
+    
     protected:
         static void setup(t_classid c)
         {
             // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "num_dimensions", set_num_dimensions);
+            FLEXT_CADDATTR_SET(c, "regularisation", set_regularisation);
+            FLEXT_CADDATTR_SET(c, "output", set_output);
             
             // Flext attribute get messages
-            
-            // Flext method messages
+            FLEXT_CADDATTR_GET(c, "num_dimensions", get_num_dimensions);
+            FLEXT_CADDATTR_GET(c, "regularisation", get_regularisation);
+            FLEXT_CADDATTR_GET(c, "output", get_output);
             
             // Associate this Flext class with a certain help file prefix
             DefineHelp(c, ml_object_name.c_str());
         }
         
         // Methods
+        void map(int argc, const t_atom *argv);
+        
+        // Method overrides
+        bool get_training_summary(GRT::UINT num_samples, double seconds, std::stringstream &summary) const;
         
         // Flext attribute setters
+        void set_num_dimensions(int num_dimensions);
+        void set_regularisation(float regularisation);
+        void set_output(int output);
         
         // Flext attribute getters
+        void get_num_dimensions(int &num_dimensions) const;
+        void get_regularisation(float &regularisation) const;
+        void get_output(int &output) const;
         
         // Pure virtual method implementations
         GRT::Classifier &get_Classifier_instance();
         const GRT::Classifier &get_Classifier_instance() const;
-        
+    
     private:
-        // Flext Flext method wrappers
-        
         // Flext Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_num_dimensions, set_num_dimensions);
+        FLEXT_CALLVAR_F(get_regularisation, set_regularisation);
+        FLEXT_CALLVAR_I(get_output, set_output);
         
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        GRT::LDA lda;
+        ml_lda_model lda;
+        lda_output output;
+        AtomList projection_list;
+        
+        static const std::string attribute_help;
     };
     
-    // Utility functions
-        
     // Flext attribute setters
+    void ml_lda::set_num_dimensions(int num_dimensions)
+    {
+        bool success = lda.set_num_dimensions(num_dimensions);
+        
+        if (success == false)
+        {
+            error("unable to set num_dimensions, hint: should be 0 or greater");
+        }
+    }
+    
+    void ml_lda::set_regularisation(float regularisation)
+    {
+        bool success = lda.set_regularisation(regularisation);
+        
+        if (success == false)
+        {
+            error("unable to set regularisation, hint: should be 0 or greater");
+        }
+    }
+    
+    void ml_lda::set_output(int output)
+    {
+        if (output < 0 || output >= LDA_NUM_OUTPUTS)
+        {
+            error("invalid output: " + std::to_string(output) + ", must be " + std::to_string(LDA_OUTPUT_LABEL) + ":LABEL or " + std::to_string(LDA_OUTPUT_PROJECTION) + ":PROJECTION");
+            return;
+        }
+        
+        this->output = (lda_output)output;
+    }
     
     // Flext attribute getters
+    void ml_lda::get_num_dimensions(int &num_dimensions) const
+    {
+        num_dimensions = lda.get_num_dimensions();
+    }
+    
+    void ml_lda::get_regularisation(float &regularisation) const
+    {
+        regularisation = lda.get_regularisation();
+    }
+    
+    void ml_lda::get_output(int &output) const
+    {
+        output = this->output;
+    }
     
     // Methods
+    bool ml_lda::get_training_summary(GRT::UINT, double, std::stringstream &summary) const
+    {
+        summary << ", projected " << lda.getNumInputDimensions() << " features to " << lda.get_projection_size() << " dimensions keeping " << lda.get_explained_variance() * 100.0 << "% of the between-class variance";
+        
+        return true;
+    }
+    
+    void ml_lda::map(int argc, const t_atom *argv)
+    {
+        if (output == LDA_OUTPUT_LABEL)
+        {
+            ml_classification::map(argc, argv);
+            return;
+        }
+        
+        if (lda.getTrained() == false)
+        {
+            error("model has not been trained, use 'train' to train the model");
+            return;
+        }
+        
+        const GRT::UINT numInputFeatures = lda.getNumInputDimensions();
+        
+        if (argc < 0 || (unsigned)argc != numInputFeatures)
+        {
+            std::stringstream ss;
+            ss << "invalid input length, expected " << numInputFeatures << ", got " << argc;
+            error(ss.str());
+            return;
+        }
+        
+        GRT::VectorDouble query(numInputFeatures);
+        
+        for (uint32_t index = 0; index < (uint32_t)argc; ++index)
+        {
+            query[index] = GetAFloat(argv[index]);
+        }
+        
+        if (lda.predict(query) == false)
+        {
+            error("unable to map input");
+            return;
+        }
+        
+        const std::vector<double> &projection = lda.get_projection();
+        
+        if (projection_list.Count() != (int)projection.size())
+        {
+            projection_list(projection.size());
+        }
+        
+        for (GRT::UINT index = 0; index < projection.size(); ++index)
+        {
+            SetFloat(projection_list[index], projection[index]);
+        }
+        
+        ToOutList(0, projection_list);
+    }
     
     // Implement pure virtual methods
     GRT::Classifier &ml_lda::get_Classifier_instance()
@@ -98,6 +1024,11 @@ namespace ml
         return lda;
     }
     
+    const std::string ml_lda::attribute_help =
+    "num_dimensions:\tinteger (n >= 0) setting the number of discriminant directions the model projects onto, 0 uses one less than the number of classes (default 0)\n"
+    "regularisation:\tfloating point value (>= 0) added to the diagonal of the within-class covariance matrix, relative to its mean variance, so that training succeeds with constant or collinear features, larger values trade accuracy for robustness with few samples (default 1.0e-6)\n"
+    "output:\tinteger selecting what 'map' outputs, 0:LABEL outputs the class label, 1:PROJECTION outputs the input projected onto the discriminant directions as a list, for use as reduced features for another classifier (default LABEL)\n";
+    
     typedef class ml_lda ml0x2elda;
     
 #ifdef BUILD_AS_LIBRARY
@@ -108,5 +1039,3 @@ namespace ml
 
     
 } //namespace ml
-
-
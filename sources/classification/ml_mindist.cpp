@@ -17,11 +17,347 @@
  */
 
 #include "ml_classification.h"
+#include "ml_parallel.h"
+
+#include <algorithm>
+#include <limits>
 
 namespace ml
 {
     const std::string ml_object_name = "ml.mindist";
     
+    // Number of features between the checks for early rejection
+    const GRT::UINT k_mindist_rejection_stride = 4;
+    
+    // GRT::MinDist that clusters every class as an independent task on a pool of worker threads and predicts from one
+    // matrix of all the classes' centroids. The centroids are stored feature-major, feature n of centroid c at
+    // [n * num_centroids + c], so the squared distances to every centroid accumulate in one pass over the features that
+    // vectorises across centroids
+    class ml_mindist_model : public GRT::MinDist
+    {
+    public:
+        ml_mindist_model()
+        :
+        early_rejection(false),
+        num_centroids(0)
+        {}
+        
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        bool recomputeNullRejectionThresholds();
+        
+        using GRT::MinDist::train_;
+        using GRT::MinDist::predict_;
+        using GRT::MinDist::loadModelFromFile;
+        
+        // With null rejection on, stop a prediction as soon as every centroid is further away than its class' rejection
+        // threshold, which the remaining features can only increase. The prediction is then the null class and the class
+        // distances are the partial sums reached
+        void set_early_rejection(bool early_rejection) { this->early_rejection = early_rejection; }
+        bool get_early_rejection() const { return early_rejection; }
+        
+        GRT::UINT get_num_clusters() const { return numClusters; }
+        
+    protected:
+        void build_inference();
+        
+        bool early_rejection;
+        
+        GRT::UINT num_centroids;
+        std::vector<double> centroids;
+        std::vector<GRT::UINT> centroid_classes;
+        std::vector<double> centroid_thresholds;
+        std::vector<double> distances;
+    };
+    
+    bool ml_mindist_model::train_(GRT::ClassificationData &trainingData)
+    {
+        clear();
+        
+        const GRT::UINT M = trainingData.getNumSamples();
+        const GRT::UINT N = trainingData.getNumDimensions();
+        const GRT::UINT K = trainingData.getNumClasses();
+        
+        if (M == 0)
+        {
+            errorLog << "train_(ClassificationData &labelledTrainingData) - Training data has zero samples!" << endl;
+            return false;
+        }
+        
+        if (M <= numClusters)
+        {
+            errorLog << "train_(ClassificationData &labelledTrainingData) - There are not enough training samples for the number of clusters. Either reduce the number of clusters or increase the number of training samples!" << endl;
+            return false;
+        }
+        
+        numInputDimensions = N;
+        numClasses = K;
+        models.resize(K);
+        classLabels = trainingData.getClassLabels();
+        nullRejectionThresholds.resize(K);
+        ranges = trainingData.getRanges();
+        
+        if (useScaling)
+        {
+            trainingData.scale(ranges, 0, 1);
+        }
+        
+        std::vector<GRT::MatrixDouble> class_data(K);
+        std::vector<GRT::UINT> class_sizes(K, 0);
+        std::vector<GRT::UINT> sample_classes(M);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            sample_classes[i] = (GRT::UINT)(std::find(classLabels.begin(), classLabels.end(), trainingData[i].getClassLabel()) - classLabels.begin());
+            class_sizes[sample_classes[i]]++;
+        }
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            class_data[k].resize(class_sizes[k], N);
+            class_sizes[k] = 0;
+        }
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            const GRT::UINT k = sample_classes[i];
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                class_data[k][class_sizes[k]][n] = trainingData[i][n];
+            }
+            
+            class_sizes[k]++;
+        }
+        
+        // Each class' model runs its own KMeans, so the classes are trained concurrently
+        std::vector<char> success(K, false);
+        
+        parallel_for(K, [&](unsigned int k, unsigned int)
+        {
+            models[k].setGamma(nullRejectionCoeff);
+            success[k] = models[k].train(classLabels[k], class_data[k], numClusters);
+        });
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            if (!success[k])
+            {
+                errorLog << "train_(ClassificationData &labelledTrainingData) - Failed to train model for class: " << classLabels[k] << endl;
+                clear();
+                return false;
+            }
+            
+            nullRejectionThresholds[k] = models[k].getRejectionThreshold();
+        }
+        
+        trained = true;
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_mindist_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (centroids.empty())
+        {
+            return GRT::MinDist::predict_(inputVector);
+        }
+        
+        predictedClassLabel = 0;
+        maxLikelihood = 0;
+        
+        if (!trained)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - MinDist Model Not Trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - The size of the input vector (" << inputVector.size() << ") does not match the num features in the model (" << numInputDimensions << endl;
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+            {
+                inputVector[n] = scale(inputVector[n], ranges[n].minValue, ranges[n].maxValue, 0, 1);
+            }
+        }
+        
+        const GRT::UINT C = num_centroids;
+        const bool check_rejection = early_rejection && useNullRejection;
+        double *distance = &distances[0];
+        bool rejected = false;
+        
+        std::fill(distance, distance + C, 0.0);
+        
+        for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+        {
+            const double value = inputVector[n];
+            const double *centroid = &centroids[n * C];
+            
+            for (GRT::UINT c = 0; c < C; ++c)
+            {
+                const double difference = value - centroid[c];
+                distance[c] += difference * difference;
+            }
+            
+            if (check_rejection && (n + 1) % k_mindist_rejection_stride == 0 && n + 1 < numInputDimensions)
+            {
+                rejected = true;
+                
+                for (GRT::UINT c = 0; c < C && rejected; ++c)
+                {
+                    rejected = distance[c] > centroid_thresholds[c];
+                }
+                
+                if (rejected)
+                {
+                    break;
+                }
+            }
+        }
+        
+        classLikelihoods.resize(numClasses);
+        classDistances.assign(numClasses, std::numeric_limits<double>::max());
+        
+        for (GRT::UINT c = 0; c < C; ++c)
+        {
+            double &classDistance = classDistances[centroid_classes[c]];
+            classDistance = std::min(classDistance, distance[c]);
+        }
+        
+        // The class likelihoods are 1 / (distance + 0.0001) normalised, as GRT computes them
+        GRT::UINT bestIndex = 0;
+        double sum = 0;
+        
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            if (classDistances[k] < classDistances[bestIndex])
+            {
+                bestIndex = k;
+            }
+            
+            classLikelihoods[k] = 1.0 / (classDistances[k] + 0.0001);
+            sum += classLikelihoods[k];
+        }
+        
+        if (sum != 0)
+        {
+            for (GRT::UINT k = 0; k < numClasses; ++k)
+            {
+                classLikelihoods[k] /= sum;
+            }
+        }
+        
+        maxLikelihood = classLikelihoods[bestIndex];
+        
+        if (rejected || (useNullRejection && classDistances[bestIndex] > models[bestIndex].getRejectionThreshold()))
+        {
+            predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+        }
+        else
+        {
+            predictedClassLabel = models[bestIndex].getClassLabel();
+        }
+        
+        return true;
+    }
+    
+    bool ml_mindist_model::loadModelFromFile(fstream &file)
+    {
+        if (!GRT::MinDist::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_mindist_model::clear()
+    {
+        num_centroids = 0;
+        centroids.clear();
+        centroid_classes.clear();
+        centroid_thresholds.clear();
+        
+        return GRT::MinDist::clear();
+    }
+    
+    bool ml_mindist_model::recomputeNullRejectionThresholds()
+    {
+        if (!GRT::MinDist::recomputeNullRejectionThresholds())
+        {
+            return false;
+        }
+        
+        for (GRT::UINT c = 0; c < centroid_thresholds.size(); ++c)
+        {
+            centroid_thresholds[c] = models[centroid_classes[c]].getRejectionThreshold();
+        }
+        
+        return true;
+    }
+    
+    void ml_mindist_model::build_inference()
+    {
+        std::vector<GRT::MatrixDouble> clusters(models.size());
+        
+        num_centroids = 0;
+        centroids.clear();
+        centroid_classes.clear();
+        centroid_thresholds.clear();
+        
+        for (GRT::UINT k = 0; k < models.size(); ++k)
+        {
+            clusters[k] = models[k].getClusters();
+            
+            if (clusters[k].getNumCols() != numInputDimensions)
+            {
+                return;
+            }
+            
+            for (GRT::UINT cluster = 0; cluster < clusters[k].getNumRows(); ++cluster)
+            {
+                centroid_classes.push_back(k);
+                centroid_thresholds.push_back(models[k].getRejectionThreshold());
+            }
+        }
+        
+        num_centroids = (GRT::UINT)centroid_classes.size();
+        
+        if (num_centroids == 0)
+        {
+            centroid_classes.clear();
+            centroid_thresholds.clear();
+            return;
+        }
+        
+        centroids.resize(numInputDimensions * num_centroids);
+        distances.resize(num_centroids);
+        
+        GRT::UINT c = 0;
+        
+        for (GRT::UINT k = 0; k < models.size(); ++k)
+        {
+            for (GRT::UINT cluster = 0; cluster < clusters[k].getNumRows(); ++cluster, ++c)
+            {
+                for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+                {
+                    centroids[n * num_centroids + c] = clusters[k][cluster][n];
+                }
+            }
+        }
+    }
+    
     class ml_mindist : ml_classification
     {
         FLEXT_HEADER_S(ml_mindist, ml_classification, setup);
@@ -39,9 +375,11 @@ namespace ml
         {
             // Flext attribute set messages
             FLEXT_CADDATTR_SET(c, "num_clusters", set_num_clusters);
+            FLEXT_CADDATTR_SET(c, "early_rejection", set_early_rejection);
             
             // Flext attribute get messages
             FLEXT_CADDATTR_GET(c, "num_clusters", get_num_clusters);
+            FLEXT_CADDATTR_GET(c, "early_rejection", get_early_rejection);
             
             // Associate this Flext class with a certain help file prefix
             DefineHelp(c, ml_object_name.c_str());
@@ -49,9 +387,11 @@ namespace ml
         
         // Flext attribute setters
         void set_num_clusters(int type);
+        void set_early_rejection(bool early_rejection);
         
         // Flext attribute getters
         void get_num_clusters(int &type) const;
+        void get_early_rejection(bool &early_rejection) const;
         
         // Pure virtual method implementations
         GRT::Classifier &get_Classifier_instance();
@@ -60,11 +400,12 @@ namespace ml
     private:
         // Flext Flext attribute wrappers
         FLEXT_CALLVAR_I(get_num_clusters, set_num_clusters);
+        FLEXT_CALLVAR_B(get_early_rejection, set_early_rejection);
         
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        GRT::MinDist mindist;
+        ml_mindist_model mindist;
         
         static const std::string attribute_help;
     };
@@ -73,13 +414,28 @@ namespace ml
     // Flext attribute setters
     void ml_mindist::set_num_clusters(int num_clusters)
     {
-        mindist.setNumClusters(num_clusters);
+        bool success = num_clusters > 0 && mindist.setNumClusters(num_clusters);
+        
+        if (success == false)
+        {
+            error("unable to set num_clusters, hint: should be greater than 0");
+        }
+    }
+    
+    void ml_mindist::set_early_rejection(bool early_rejection)
+    {
+        mindist.set_early_rejection(early_rejection);
     }
     
     // Flext attribute getters
     void ml_mindist::get_num_clusters(int &num_clusters) const
     {
-        error("function not implemented");
+        num_clusters = mindist.get_num_clusters();
+    }
+    
+    void ml_mindist::get_early_rejection(bool &early_rejection) const
+    {
+        early_rejection = mindist.get_early_rejection();
     }
         
     // Implement pure virtual methods
@@ -93,7 +449,8 @@ namespace ml
         return mindist;
     }
     
-    const std::string ml_mindist::attribute_help = "num_clusters:\tinteger (n > 0) sets how many clusters each model will try to find during the training phase (default 10)";
+    const std::string ml_mindist::attribute_help = "num_clusters:\tinteger (n > 0) sets how many clusters each model will try to find during the training phase (default 10)\n"
+    "early_rejection:\tinteger (0 or 1) when on and null_rejection is on, 'map' stops as soon as the input is further from every cluster than its class' NULL-rejection threshold and outputs the NULL class, saving the rest of the distance computation (default 0)\n";
     
     typedef class ml_mindist ml0x2emindist;
     
@@ -17,16 +17,215 @@
  */
 
 #include "ml_classification.h"
+#include "ml_parallel.h"
+#include "ml_tree.h"
 
 namespace ml
 {
     const std::string ml_object_name = "ml.randforest";
     const std::string k_attribute_help =
-    "num_random_splits:\tinteger (n > 0) sets the number of steps that will be used to search for the best spliting value for each node. (default 100)\n"
+    "forest_size:\tinteger (n > 0) sets the number of trees in the forest (default 10)\n"
+    "seed:\tinteger seeding the bootstrap and split selection of every tree, any value other than 0 makes training reproducible, 0 seeds from the clock (default 0)\n"
+    "num_bins:\tinteger (0 or 2-256) sets the number of quantile bins each feature is reduced to before training, every bin boundary is then tried as a split, which is faster but gives up the random choice of split thresholds. 0 uses num_random_splits random thresholds per node (default 0)\n"
+    "num_random_splits:\tinteger (n > 0) sets the number of steps that will be used to search for the best spliting value for each node when num_bins is 0. (default 100)\n"
     "min_samples_per_node:\tinteger (n > 0) Sets the minimum number of samples that are allowed per node (default 5)\n"
     "max_depth:\tinteger (n > 0) Sets the maximum depth of the tree, any node that reaches this depth will automatically become a leaf node. (default 10)\n";
     
     
+    // GRT::RandomForests with trees grown concurrently. Each tree draws its bootstrap as an index vector into one shared
+    // copy of the training data and has its own RNG stream, so a non-zero seed gives the same forest however the trees
+    // are scheduled across threads
+    class ml_randforest_model : public GRT::RandomForests
+    {
+    public:
+        ml_randforest_model()
+        :
+        seed(0),
+        num_bins(0)
+        {}
+        
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        void set_seed(GRT::UINT seed) { this->seed = seed; }
+        GRT::UINT get_seed() const { return seed; }
+        
+        // Number of quantile bins features are reduced to for split search, 0 tries num_random_splits random
+        // thresholds per feature at every node instead
+        void set_num_bins(GRT::UINT num_bins) { this->num_bins = num_bins; }
+        GRT::UINT get_num_bins() const { return num_bins; }
+        
+        using GRT::RandomForests::train_;
+        using GRT::RandomForests::predict_;
+        using GRT::RandomForests::loadModelFromFile;
+        
+    protected:
+        unsigned long long get_base_seed() const;
+        bool build_inference();
+        
+        GRT::UINT seed;
+        GRT::UINT num_bins;
+        
+        // The trained forest compiled for prediction, rebuilt after training and loading
+        tree_flat_forest flat_forest;
+    };
+    
+    bool ml_randforest_model::train_(GRT::ClassificationData &trainingData)
+    {
+        clear();
+        
+        const GRT::UINT numSamples = trainingData.getNumSamples();
+        
+        if (numSamples == 0)
+        {
+            errorLog << "train_(ClassificationData &trainingData) - Training data has zero samples!" << endl;
+            return false;
+        }
+        
+        numInputDimensions = trainingData.getNumDimensions();
+        numClasses = trainingData.getNumClasses();
+        classLabels = trainingData.getClassLabels();
+        ranges = trainingData.getRanges();
+        
+        if (useScaling)
+        {
+            trainingData.scale(0, 1);
+        }
+        
+        tree_dataset dataset;
+        tree_settings settings;
+        
+        dataset.assign(trainingData, classLabels, num_bins);
+        settings.num_random_splits = numRandomSplits;
+        settings.min_samples_per_node = minNumSamplesPerNode;
+        settings.max_depth = maxDepth;
+        settings.remove_features_at_each_split = false;
+        
+        const unsigned long long base_seed = get_base_seed();
+        std::vector<GRT::DecisionTreeNode *> trees(forestSize, NULL);
+        
+        parallel_for(forestSize, [&](unsigned int tree, unsigned int)
+        {
+            GRT::Random tree_random(base_seed + tree + 1);
+            std::vector<GRT::UINT> bootstrap(numSamples);
+            tree_builder builder(dataset, settings);
+            
+            for (GRT::UINT sample = 0; sample < numSamples; ++sample)
+            {
+                bootstrap[sample] = std::min<GRT::UINT>(tree_random.getRandomNumberInt(0, numSamples), numSamples - 1);
+            }
+            
+            trees[tree] = builder.build(bootstrap, tree_random);
+        });
+        
+        forest = trees;
+        
+        for (GRT::UINT tree = 0; tree < forestSize; ++tree)
+        {
+            if (forest[tree] == NULL)
+            {
+                errorLog << "train_(ClassificationData &trainingData) - Failed to build tree " << tree << endl;
+                clear();
+                return false;
+            }
+        }
+        
+        trained = true;
+        
+        return build_inference();
+    }
+    
+    bool ml_randforest_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (flat_forest.is_empty())
+        {
+            return GRT::RandomForests::predict_(inputVector);
+        }
+        
+        predictedClassLabel = 0;
+        maxLikelihood = 0;
+        
+        if (!trained)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - Model Not Trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - The size of the input vector (" << inputVector.size() << ") does not match the num features in the model (" << numInputDimensions << endl;
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+            {
+                inputVector[n] = scale(inputVector[n], ranges[n].minValue, ranges[n].maxValue, 0, 1);
+            }
+        }
+        
+        classLikelihoods.resize(numClasses);
+        classDistances.resize(numClasses);
+        
+        const GRT::UINT best = flat_forest.predict(&inputVector[0], &classLikelihoods[0]);
+        
+        // GRT's distances are the likelihoods summed over trees
+        for (GRT::UINT k = 0; k < numClasses; ++k)
+        {
+            classDistances[k] = classLikelihoods[k] * forestSize;
+        }
+        
+        maxLikelihood = classLikelihoods[best];
+        predictedClassLabel = classLabels[best];
+        
+        return true;
+    }
+    
+    bool ml_randforest_model::loadModelFromFile(fstream &file)
+    {
+        if (!GRT::RandomForests::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        return build_inference();
+    }
+    
+    bool ml_randforest_model::clear()
+    {
+        flat_forest.clear();
+        
+        return GRT::RandomForests::clear();
+    }
+    
+    bool ml_randforest_model::build_inference()
+    {
+        const std::vector<const GRT::DecisionTreeNode *> trees(forest.begin(), forest.end());
+        
+        if (!flat_forest.compile(trees, numClasses))
+        {
+            errorLog << "build_inference() - Forest has a missing tree" << endl;
+            return false;
+        }
+        
+        return true;
+    }
+    
+    unsigned long long ml_randforest_model::get_base_seed() const
+    {
+        if (seed != 0)
+        {
+            return seed;
+        }
+        
+        GRT::Timer timer;
+        
+        return (unsigned long long)timer.getSystemTime();
+    }
+    
     // Class declaration
     class ml_randforest : ml_classification
     {
@@ -49,12 +248,18 @@ namespace ml
         static void setup(t_classid c)
         {
             // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "forest_size", set_forest_size);
+            FLEXT_CADDATTR_SET(c, "seed", set_seed);
+            FLEXT_CADDATTR_SET(c, "num_bins", set_num_bins);
             FLEXT_CADDATTR_SET(c, "num_random_splits", set_num_random_splits);
             FLEXT_CADDATTR_SET(c, "min_samples_per_node", set_min_samples_per_node);
             FLEXT_CADDATTR_SET(c, "max_depth", set_max_depth);
 
             
             // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "forest_size", get_forest_size);
+            FLEXT_CADDATTR_GET(c, "seed", get_seed);
+            FLEXT_CADDATTR_GET(c, "num_bins", get_num_bins);
             FLEXT_CADDATTR_GET(c, "num_random_splits", get_num_random_splits);
             FLEXT_CADDATTR_GET(c, "min_samples_per_node", get_min_samples_per_node);
             FLEXT_CADDATTR_GET(c, "max_depth", get_max_depth);
@@ -64,12 +269,18 @@ namespace ml
         }
         
         // Flext attribute setters
+        void set_forest_size(int forest_size);
+        void set_seed(int seed);
+        void set_num_bins(int num_bins);
         void set_num_random_splits(int num_random_splits);
         void set_min_samples_per_node(int min_samples_per_node);
         void set_max_depth(int max_depth);
 
         
         // Flext attribute getters
+        void get_forest_size(int &forest_size) const;
+        void get_seed(int &seed) const;
+        void get_num_bins(int &num_bins) const;
         void get_num_random_splits(int &num_random_splits) const;
         void get_min_samples_per_node(int &min_samples_per_node) const;
         void get_max_depth(int &max_depth) const;
@@ -80,6 +291,9 @@ namespace ml
         
     private:
         // Flext Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_forest_size, set_forest_size);
+        FLEXT_CALLVAR_I(get_seed, set_seed);
+        FLEXT_CALLVAR_I(get_num_bins, set_num_bins);
         FLEXT_CALLVAR_I(get_num_random_splits, set_num_random_splits);
         FLEXT_CALLVAR_I(get_min_samples_per_node, set_min_samples_per_node);
         FLEXT_CALLVAR_I(get_max_depth, set_max_depth);
@@ -87,13 +301,46 @@ namespace ml
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        GRT::RandomForests randforest;
+        ml_randforest_model randforest;
         
         static const std::string attribute_help;
     };
     
     
     // Flext attribute setters
+    void ml_randforest::set_forest_size(int forest_size)
+    {
+        if (forest_size < 1)
+        {
+            error("forest_size must be greater than 0");
+            return;
+        }
+        
+        randforest.setForestSize(forest_size);
+    }
+    
+    void ml_randforest::set_seed(int seed)
+    {
+        if (seed < 0)
+        {
+            error("seed must be 0 or greater");
+            return;
+        }
+        
+        randforest.set_seed(seed);
+    }
+    
+    void ml_randforest::set_num_bins(int num_bins)
+    {
+        if (num_bins < 0 || num_bins == 1 || num_bins > (int)k_tree_max_bins)
+        {
+            error("num_bins must be 0 or between 2 and " + std::to_string(k_tree_max_bins));
+            return;
+        }
+        
+        randforest.set_num_bins(num_bins);
+    }
+    
     void ml_randforest::set_num_random_splits(int num_random_splits)
     {
         randforest.setNumRandomSpilts(num_random_splits);
@@ -106,10 +353,25 @@ namespace ml
     
     void ml_randforest::set_max_depth(int max_depth)
     {
-        randforest.setMinNumSamplesPerNode(max_depth);
+        randforest.setMaxDepth(max_depth);
     }
     
     // Flext attribute getters
+    void ml_randforest::get_forest_size(int &forest_size) const
+    {
+        forest_size = randforest.getForestSize();
+    }
+    
+    void ml_randforest::get_seed(int &seed) const
+    {
+        seed = randforest.get_seed();
+    }
+    
+    void ml_randforest::get_num_bins(int &num_bins) const
+    {
+        num_bins = randforest.get_num_bins();
+    }
+    
     void ml_randforest::get_num_random_splits(int &num_random_splits) const
     {
         num_random_splits = randforest.getNumRandomSpilts();
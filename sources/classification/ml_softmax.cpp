@@ -17,40 +17,839 @@
  */
 
 #include "ml_classification.h"
+#include "ml_parallel.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ml
 {
     static const std::string ml_object_name = "ml.softmax";
     
+    enum softmax_solver
+    {
+        SOFTMAX_SOLVER_SGD,
+        SOFTMAX_SOLVER_LBFGS,
+        SOFTMAX_NUM_SOLVERS
+    };
+    
+    const double k_softmax_default_regularisation = 1.0e-4;
+    
+    // Number of curvature pairs kept by L-BFGS and limits of its backtracking line search
+    const GRT::UINT k_softmax_history_size = 8;
+    const GRT::UINT k_softmax_max_line_search_steps = 30;
+    const double k_softmax_sufficient_decrease = 1.0e-4;
+    
+    struct softmax_training_result
+    {
+        softmax_training_result()
+        :
+        num_iterations(0),
+        loss(0.0)
+        {}
+        
+        GRT::UINT num_iterations;
+        double loss;
+    };
+    
+    // Mean multinomial cross-entropy of the training samples plus an L2 penalty on the weights (not the biases). The
+    // parameters are the K x (N + 1) weight matrix stored feature-major, weight n of class k at [n * K + k] and the
+    // biases at [N * K + k], so both the logits and the gradient accumulate in loops over the classes that vectorise.
+    // The sums over the samples are made with parallel_block_sum
+    class softmax_objective
+    {
+    public:
+        softmax_objective(const std::vector<double> &inputs, const std::vector<GRT::UINT> &targets, GRT::UINT N, GRT::UINT K, double regularisation)
+        :
+        inputs(inputs),
+        targets(targets),
+        M((GRT::UINT)targets.size()),
+        N(N),
+        K(K),
+        regularisation(regularisation),
+        logits(get_num_workers(get_num_blocks(M)) * K)
+        {}
+        
+        GRT::UINT get_num_parameters() const { return (N + 1) * K; }
+        
+        double evaluate(const std::vector<double> &parameters, std::vector<double> &gradient);
+    
+    private:
+        void evaluate_block(const double *parameters, GRT::UINT begin, GRT::UINT end, double *partial, double *output) const;
+        
+        const std::vector<double> &inputs;
+        const std::vector<GRT::UINT> &targets;
+        const GRT::UINT M;
+        const GRT::UINT N;
+        const GRT::UINT K;
+        const double regularisation;
+        
+        // The gradient followed by the loss, per block and summed
+        std::vector<double> block_sums;
+        std::vector<double> sums;
+        std::vector<double> logits;
+    };
+    
+    double softmax_objective::evaluate(const std::vector<double> &parameters, std::vector<double> &gradient)
+    {
+        const GRT::UINT P = get_num_parameters();
+        
+        parallel_block_sum(M, P + 1, block_sums, sums, [&](GRT::UINT begin, GRT::UINT end, double *partial, unsigned int worker)
+        {
+            evaluate_block(&parameters[0], begin, end, partial, &logits[worker * K]);
+        });
+        
+        double loss = sums[P] / M;
+        
+        gradient.assign(sums.begin(), sums.begin() + P);
+        
+        for (GRT::UINT p = 0; p < P; ++p)
+        {
+            gradient[p] /= M;
+        }
+        
+        for (GRT::UINT p = 0; p < N * K; ++p)
+        {
+            loss += 0.5 * regularisation * parameters[p] * parameters[p];
+            gradient[p] += regularisation * parameters[p];
+        }
+        
+        return loss;
+    }
+    
+    void softmax_objective::evaluate_block(const double *parameters, GRT::UINT begin, GRT::UINT end, double *partial, double *output) const
+    {
+        const double *biases = parameters + N * K;
+        double *gradient = partial;
+        double loss = 0.0;
+        
+        for (GRT::UINT i = begin; i < end; ++i)
+        {
+            const double *x = &inputs[i * N];
+            
+            std::copy(biases, biases + K, output);
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                const double value = x[n];
+                const double *weights = parameters + n * K;
+                
+                for (GRT::UINT k = 0; k < K; ++k)
+                {
+                    output[k] += value * weights[k];
+                }
+            }
+            
+            // -log p(target) = log(sum(exp(z))) - z[target], with the maximum logit subtracted before exponentiating
+            const double max_logit = *std::max_element(output, output + K);
+            const double target_logit = output[targets[i]];
+            double sum = 0.0;
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                output[k] = exp(output[k] - max_logit);
+                sum += output[k];
+            }
+            
+            loss += log(sum) + max_logit - target_logit;
+            
+            // The gradient of the sample's loss with respect to the logits is p - y
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                output[k] /= sum;
+            }
+            
+            output[targets[i]] -= 1.0;
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                const double value = x[n];
+                double *weights = gradient + n * K;
+                
+                for (GRT::UINT k = 0; k < K; ++k)
+                {
+                    weights[k] += value * output[k];
+                }
+            }
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                gradient[N * K + k] += output[k];
+            }
+        }
+        
+        partial[get_num_parameters()] = loss;
+    }
+    
+    inline double softmax_dot(const std::vector<double> &a, const std::vector<double> &b)
+    {
+        double sum = 0.0;
+        
+        for (GRT::UINT p = 0; p < a.size(); ++p)
+        {
+            sum += a[p] * b[p];
+        }
+        
+        return sum;
+    }
+    
+    // Minimises the objective from the given parameters with L-BFGS and a backtracking line search. Stops after
+    // max_iterations, once an iteration lowers the loss by no more than min_change relative to the loss, or once no
+    // step along the search direction lowers the loss
+    softmax_training_result softmax_minimise(softmax_objective &objective, std::vector<double> &parameters, GRT::UINT max_iterations, double min_change)
+    {
+        const GRT::UINT P = objective.get_num_parameters();
+        std::vector<double> gradient(P);
+        std::vector<double> direction(P);
+        std::vector<double> next_parameters(P);
+        std::vector<double> next_gradient(P);
+        std::vector<std::vector<double> > steps;
+        std::vector<std::vector<double> > changes;
+        std::vector<double> curvatures;
+        std::vector<double> alphas(k_softmax_history_size);
+        softmax_training_result result;
+        
+        result.loss = objective.evaluate(parameters, gradient);
+        
+        while (result.num_iterations < max_iterations)
+        {
+            // Two-loop recursion for the product of the inverse Hessian approximation and the negative gradient
+            for (GRT::UINT p = 0; p < P; ++p)
+            {
+                direction[p] = -gradient[p];
+            }
+            
+            for (GRT::UINT j = (GRT::UINT)steps.size(); j-- > 0;)
+            {
+                alphas[j] = curvatures[j] * softmax_dot(steps[j], direction);
+                
+                for (GRT::UINT p = 0; p < P; ++p)
+                {
+                    direction[p] -= alphas[j] * changes[j][p];
+                }
+            }
+            
+            if (!steps.empty())
+            {
+                const double scale = softmax_dot(steps.back(), changes.back()) / softmax_dot(changes.back(), changes.back());
+                
+                for (GRT::UINT p = 0; p < P; ++p)
+                {
+                    direction[p] *= scale;
+                }
+            }
+            
+            for (GRT::UINT j = 0; j < steps.size(); ++j)
+            {
+                const double beta = curvatures[j] * softmax_dot(changes[j], direction);
+                
+                for (GRT::UINT p = 0; p < P; ++p)
+                {
+                    direction[p] += (alphas[j] - beta) * steps[j][p];
+                }
+            }
+            
+            double slope = softmax_dot(gradient, direction);
+            
+            if (slope >= 0.0)
+            {
+                // Not a descent direction, restart from steepest descent
+                steps.clear();
+                changes.clear();
+                curvatures.clear();
+                
+                for (GRT::UINT p = 0; p < P; ++p)
+                {
+                    direction[p] = -gradient[p];
+                }
+                
+                slope = -softmax_dot(gradient, gradient);
+            }
+            
+            if (slope == 0.0)
+            {
+                break;
+            }
+            
+            // Without curvature information the first step is scaled to unit length
+            double step = steps.empty() ? std::min(1.0, 1.0 / sqrt(-slope)) : 1.0;
+            double next_loss = result.loss;
+            bool decreased = false;
+            
+            for (GRT::UINT attempt = 0; attempt < k_softmax_max_line_search_steps && !decreased; ++attempt, step *= 0.5)
+            {
+                for (GRT::UINT p = 0; p < P; ++p)
+                {
+                    next_parameters[p] = parameters[p] + step * direction[p];
+                }
+                
+                next_loss = objective.evaluate(next_parameters, next_gradient);
+                decreased = next_loss <= result.loss + k_softmax_sufficient_decrease * step * slope;
+            }
+            
+            if (!decreased)
+            {
+                break;
+            }
+            
+            std::vector<double> parameter_step(P);
+            std::vector<double> gradient_change(P);
+            
+            for (GRT::UINT p = 0; p < P; ++p)
+            {
+                parameter_step[p] = next_parameters[p] - parameters[p];
+                gradient_change[p] = next_gradient[p] - gradient[p];
+            }
+            
+            const double curvature = softmax_dot(parameter_step, gradient_change);
+            
+            // Only pairs with positive curvature keep the inverse Hessian approximation positive definite
+            if (curvature > std::numeric_limits<double>::epsilon() * softmax_dot(gradient_change, gradient_change))
+            {
+                if (steps.size() == k_softmax_history_size)
+                {
+                    steps.erase(steps.begin());
+                    changes.erase(changes.begin());
+                    curvatures.erase(curvatures.begin());
+                }
+                
+                steps.push_back(parameter_step);
+                changes.push_back(gradient_change);
+                curvatures.push_back(1.0 / curvature);
+            }
+            
+            const double change = result.loss - next_loss;
+            
+            parameters.swap(next_parameters);
+            gradient.swap(next_gradient);
+            result.loss = next_loss;
+            result.num_iterations++;
+            
+            if (change <= min_change * std::max(1.0, fabs(next_loss)))
+            {
+                break;
+            }
+        }
+        
+        return result;
+    }
+    
+    // GRT::Softmax that can also be trained as one multinomial logistic regression over all the classes by full-batch
+    // L-BFGS, instead of GRT's per-sample updates of an independent logistic model for each class. Either model
+    // predicts from one dense matrix of all the classes' weights, a multinomial model's likelihoods are the softmax of
+    // its logits and a GRT model's are its sigmoids normalised as GRT computes them
+    class ml_softmax_model : public GRT::Softmax
+    {
+    public:
+        ml_softmax_model()
+        :
+        solver(SOFTMAX_SOLVER_LBFGS),
+        regularisation(k_softmax_default_regularisation),
+        multinomial(false)
+        {}
+        
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool saveModelToFile(fstream &file) const;
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        using GRT::Softmax::train_;
+        using GRT::Softmax::predict_;
+        using GRT::Softmax::saveModelToFile;
+        using GRT::Softmax::loadModelFromFile;
+        
+        bool set_solver(int solver)
+        {
+            if (solver < 0 || solver >= SOFTMAX_NUM_SOLVERS)
+            {
+                return false;
+            }
+            this->solver = (softmax_solver)solver;
+            return true;
+        }
+        
+        bool set_regularisation(double regularisation)
+        {
+            if (regularisation < 0)
+            {
+                return false;
+            }
+            this->regularisation = regularisation;
+            return true;
+        }
+        
+        softmax_solver get_solver() const { return solver; }
+        double get_regularisation() const { return regularisation; }
+        double get_learning_rate() const { return learningRate; }
+        double get_min_change() const { return minChange; }
+        GRT::UINT get_max_iterations() const { return maxNumIterations; }
+        bool get_multinomial() const { return multinomial; }
+        const softmax_training_result &get_training_result() const { return training_result; }
+    
+    protected:
+        bool train_multinomial(GRT::ClassificationData &trainingData);
+        void build_inference();
+        
+        softmax_solver solver;
+        double regularisation;
+        bool multinomial;
+        softmax_training_result training_result;
+        
+        // Weights feature-major, weight n of class k at [n * numClasses + k], followed by the biases
+        std::vector<double> weights;
+        std::vector<double> outputs;
+        
+        static const std::string multinomial_model_header;
+    };
+    
+    // Multinomial models are saved as this header followed by a GRT Softmax model, GRT only loads the models it trained
+    const std::string ml_softmax_model::multinomial_model_header = "ML_SOFTMAX_MULTINOMIAL_MODEL_FILE_V1.0";
+    
+    bool ml_softmax_model::train_(GRT::ClassificationData &trainingData)
+    {
+        clear();
+        
+        if (solver == SOFTMAX_SOLVER_LBFGS)
+        {
+            return train_multinomial(trainingData);
+        }
+        
+        if (!GRT::Softmax::train_(trainingData))
+        {
+            return false;
+        }
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_softmax_model::train_multinomial(GRT::ClassificationData &trainingData)
+    {
+        const GRT::UINT M = trainingData.getNumSamples();
+        const GRT::UINT N = trainingData.getNumDimensions();
+        const GRT::UINT K = trainingData.getNumClasses();
+        
+        if (M == 0)
+        {
+            errorLog << "train_(ClassificationData &labelledTrainingData) - Training data has zero samples!" << endl;
+            return false;
+        }
+        
+        numInputDimensions = N;
+        numClasses = K;
+        classLabels = trainingData.getClassLabels();
+        ranges = trainingData.getRanges();
+        
+        if (useScaling)
+        {
+            trainingData.scale(ranges, 0, 1);
+        }
+        
+        std::vector<double> inputs(M * N);
+        std::vector<GRT::UINT> targets(M);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            targets[i] = (GRT::UINT)(std::find(classLabels.begin(), classLabels.end(), trainingData[i].getClassLabel()) - classLabels.begin());
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                inputs[i * N + n] = trainingData[i][n];
+            }
+        }
+        
+        // The loss is convex, so training starts from zero weights
+        softmax_objective objective(inputs, targets, N, K, regularisation);
+        std::vector<double> parameters(objective.get_num_parameters(), 0.0);
+        
+        training_result = softmax_minimise(objective, parameters, maxNumIterations, minChange);
+        
+        models.resize(K);
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            models[k].classLabel = classLabels[k];
+            models[k].N = N;
+            models[k].w.resize(N);
+            models[k].w0 = parameters[N * K + k];
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                models[k].w[n] = parameters[n * K + k];
+            }
+        }
+        
+        trained = true;
+        multinomial = true;
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_softmax_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (weights.empty())
+        {
+            return GRT::Softmax::predict_(inputVector);
+        }
+        
+        predictedClassLabel = 0;
+        maxLikelihood = 0;
+        
+        if (!trained)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - Model Not Trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - The size of the input vector (" << inputVector.size() << ") does not match the num features in the model (" << numInputDimensions << endl;
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+            {
+                inputVector[n] = scale(inputVector[n], ranges[n].minValue, ranges[n].maxValue, 0, 1);
+            }
+        }
+        
+        const GRT::UINT K = numClasses;
+        const double *biases = &weights[numInputDimensions * K];
+        double *output = &outputs[0];
+        
+        std::copy(biases, biases + K, output);
+        
+        for (GRT::UINT n = 0; n < numInputDimensions; ++n)
+        {
+            const double value = inputVector[n];
+            const double *weight = &weights[n * K];
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                output[k] += value * weight[k];
+            }
+        }
+        
+        const GRT::UINT bestIndex = (GRT::UINT)(std::max_element(output, output + K) - output);
+        double sum = 0;
+        
+        if (multinomial)
+        {
+            const double max_logit = output[bestIndex];
+            
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                output[k] = exp(output[k] - max_logit);
+                sum += output[k];
+            }
+        }
+        else
+        {
+            for (GRT::UINT k = 0; k < K; ++k)
+            {
+                output[k] = 1.0 / (1.0 + exp(-output[k]));
+                sum += output[k];
+            }
+        }
+        
+        classDistances.assign(output, output + K);
+        classLikelihoods.assign(output, output + K);
+        
+        // GRT outputs the NULL class when none of its models found a positive class
+        if (!multinomial && sum <= 1.0e-5)
+        {
+            predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+            maxLikelihood = output[bestIndex];
+            return true;
+        }
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            classLikelihoods[k] /= sum;
+        }
+        
+        if (multinomial)
+        {
+            classDistances = classLikelihoods;
+        }
+        
+        maxLikelihood = classLikelihoods[bestIndex];
+        
+        if (useNullRejection && maxLikelihood <= nullRejectionCoeff)
+        {
+            predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+        }
+        else
+        {
+            predictedClassLabel = models[bestIndex].classLabel;
+        }
+        
+        return true;
+    }
+    
+    bool ml_softmax_model::saveModelToFile(fstream &file) const
+    {
+        if (multinomial)
+        {
+            if (!file.is_open())
+            {
+                return false;
+            }
+            
+            file << multinomial_model_header << std::endl;
+        }
+        
+        const std::streamsize precision = file.precision(17);
+        const bool success = GRT::Softmax::saveModelToFile(file);
+        
+        file.precision(precision);
+        
+        return success;
+    }
+    
+    bool ml_softmax_model::loadModelFromFile(fstream &file)
+    {
+        clear();
+        
+        const std::streampos start = file.tellg();
+        std::string word;
+        bool is_multinomial = false;
+        
+        if (file >> word && word == multinomial_model_header)
+        {
+            is_multinomial = true;
+        }
+        else
+        {
+            file.clear();
+            file.seekg(start);
+        }
+        
+        if (!GRT::Softmax::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        multinomial = is_multinomial;
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_softmax_model::clear()
+    {
+        multinomial = false;
+        weights.clear();
+        outputs.clear();
+        
+        return GRT::Softmax::clear();
+    }
+    
+    void ml_softmax_model::build_inference()
+    {
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT K = (GRT::UINT)models.size();
+        
+        weights.clear();
+        outputs.clear();
+        
+        if (K == 0 || K != numClasses)
+        {
+            return;
+        }
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            if (models[k].w.size() != N)
+            {
+                return;
+            }
+        }
+        
+        weights.resize((N + 1) * K);
+        outputs.resize(K);
+        
+        for (GRT::UINT k = 0; k < K; ++k)
+        {
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                weights[n * K + k] = models[k].w[n];
+            }
+            
+            weights[N * K + k] = models[k].w0;
+        }
+    }
+    
     class ml_softmax : ml_classification
     {
         FLEXT_HEADER_S(ml_softmax, ml_classification, setup);
-        
+    
     public:
         ml_softmax()
         {
             post("Softmax algorithm based on the GRT library version " + GRT::GRTBase::getGRTVersion());
             set_scaling(default_scaling);
+            help.append_attributes(attribute_help);
         }
-        
+    
     protected:
         static void setup(t_classid c)
         {
+            // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "solver", set_solver);
+            FLEXT_CADDATTR_SET(c, "max_iterations", set_max_iterations);
+            FLEXT_CADDATTR_SET(c, "min_change", set_min_change);
+            FLEXT_CADDATTR_SET(c, "training_rate", set_training_rate);
+            FLEXT_CADDATTR_SET(c, "regularisation", set_regularisation);
+            
+            // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "solver", get_solver);
+            FLEXT_CADDATTR_GET(c, "max_iterations", get_max_iterations);
+            FLEXT_CADDATTR_GET(c, "min_change", get_min_change);
+            FLEXT_CADDATTR_GET(c, "training_rate", get_training_rate);
+            FLEXT_CADDATTR_GET(c, "regularisation", get_regularisation);
+            
             // Associate this Flext class with a certain help file prefix
             DefineHelp(c, ml_object_name.c_str());
         }
         
+        // Flext attribute setters
+        void set_solver(int solver);
+        void set_max_iterations(int max_iterations);
+        void set_min_change(float min_change);
+        void set_training_rate(float training_rate);
+        void set_regularisation(float regularisation);
+        
+        // Flext attribute getters
+        void get_solver(int &solver) const;
+        void get_max_iterations(int &max_iterations) const;
+        void get_min_change(float &min_change) const;
+        void get_training_rate(float &training_rate) const;
+        void get_regularisation(float &regularisation) const;
+        
+        // Method overrides
+        bool get_training_summary(GRT::UINT num_samples, double seconds, std::stringstream &summary) const;
+        
         // Pure virtual method implementations
         GRT::Classifier &get_Classifier_instance();
         const GRT::Classifier &get_Classifier_instance() const;
-        
+    
     private:
+        // Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_solver, set_solver);
+        FLEXT_CALLVAR_I(get_max_iterations, set_max_iterations);
+        FLEXT_CALLVAR_F(get_min_change, set_min_change);
+        FLEXT_CALLVAR_F(get_training_rate, set_training_rate);
+        FLEXT_CALLVAR_F(get_regularisation, set_regularisation);
+        
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        GRT::Softmax softmax;
+        ml_softmax_model softmax;
+        
+        static const std::string attribute_help;
     };
     
+    // Flext attribute setters
+    void ml_softmax::set_solver(int solver)
+    {
+        bool success = softmax.set_solver(solver);
+        
+        if (success == false)
+        {
+            error("invalid solver: " + std::to_string(solver) + ", must be " + std::to_string(SOFTMAX_SOLVER_SGD) + ":SGD or " + std::to_string(SOFTMAX_SOLVER_LBFGS) + ":LBFGS");
+        }
+    }
+    
+    void ml_softmax::set_max_iterations(int max_iterations)
+    {
+        bool success = max_iterations > 0 && softmax.setMaxNumIterations(max_iterations);
+        
+        if (success == false)
+        {
+            error("unable to set max_iterations, hint: should be greater than 0");
+        }
+    }
+    
+    void ml_softmax::set_min_change(float min_change)
+    {
+        bool success = softmax.setMinChange(min_change);
+        
+        if (success == false)
+        {
+            error("unable to set min_change, hint: should be greater than 0");
+        }
+    }
+    
+    void ml_softmax::set_training_rate(float training_rate)
+    {
+        bool success = softmax.setLearningRate(training_rate);
+        
+        if (success == false)
+        {
+            error("unable to set training_rate, hint: should be greater than 0");
+        }
+    }
+    
+    void ml_softmax::set_regularisation(float regularisation)
+    {
+        bool success = softmax.set_regularisation(regularisation);
+        
+        if (success == false)
+        {
+            error("unable to set regularisation, hint: should be 0 or greater");
+        }
+    }
+    
+    // Flext attribute getters
+    void ml_softmax::get_solver(int &solver) const
+    {
+        solver = softmax.get_solver();
+    }
+    
+    void ml_softmax::get_max_iterations(int &max_iterations) const
+    {
+        max_iterations = softmax.get_max_iterations();
+    }
+    
+    void ml_softmax::get_min_change(float &min_change) const
+    {
+        min_change = softmax.get_min_change();
+    }
+    
+    void ml_softmax::get_training_rate(float &training_rate) const
+    {
+        training_rate = softmax.get_learning_rate();
+    }
+    
+    void ml_softmax::get_regularisation(float &regularisation) const
+    {
+        regularisation = softmax.get_regularisation();
+    }
+    
+    // Method overrides
+    bool ml_softmax::get_training_summary(GRT::UINT, double, std::stringstream &summary) const
+    {
+        summary << ", " << softmax.getNumClasses() << " classes";
+        
+        if (softmax.get_multinomial())
+        {
+            const softmax_training_result &result = softmax.get_training_result();
+            
+            summary << ", " << result.num_iterations << " L-BFGS iterations, mean cross-entropy " << result.loss;
+        }
+        
+        return true;
+    }
+    
     // Implement pure virtual methods
     GRT::Classifier &ml_softmax::get_Classifier_instance()
     {
@@ -62,6 +861,13 @@ namespace ml
         return softmax;
     }
     
+    const std::string ml_softmax::attribute_help =
+    "solver:\tinteger selecting the training algorithm, 0:SGD trains an independent logistic model for each class with GRT's per-sample stochastic gradient descent, 1:LBFGS trains one multinomial logistic regression over all the classes with full-batch L-BFGS, its models are saved in their own model format (default LBFGS)\n"
+    "max_iterations:\tinteger (n > 0) setting the maximum number of training iterations, epochs for SGD and L-BFGS iterations for LBFGS (default 1000)\n"
+    "min_change:\tfloating point value setting the minimum change that must be achieved between two training iterations for the training to continue, relative to the loss for LBFGS (default 1.0e-10)\n"
+    "training_rate:\tfloating point value used to update the weights at each step of the stochastic gradient descent, SGD only (default 0.1)\n"
+    "regularisation:\tfloating point value (>= 0) weighting the L2 penalty on the weights that keeps them finite when the classes are separable, LBFGS only (default 1.0e-4)\n";
+    
     typedef class ml_softmax ml0x2esoftmax;
     
 #ifdef BUILD_AS_LIBRARY
@@ -93,6 +93,1021 @@ namespace ml
         return GRT::SVM::LINEAR_KERNEL;
     }
     
+    // Dense inference engine for trained libsvm models
+    //
+    // libsvm evaluates each kernel value node-by-node from sparse svm_node lists. Here the support vectors are
+    // copied into one contiguous feature-major float matrix (row per feature, column per support vector) with their
+    // squared norms cached, so that a kernel row reduces to axpy passes over tiles of support vectors which the
+    // compiler vectorises for both SSE and NEON. All scratch buffers are sized in build(), predict() never allocates
+    const GRT::UINT k_svm_tile_size = 128;
+    const double k_svm_min_probability = 1e-7;
+    
+    class svm_dense_engine
+    {
+    public:
+        svm_dense_engine()
+        : built(false), probabilities(false), svm_type(0), kernel_type(0), degree(0), gamma(0), coef0(0),
+        num_dimensions(0), num_classes(0), num_support_vectors(0), num_decision_values(0), query_capacity(0)
+        {
+        }
+        
+        bool build(const GRT::svm_model *model, GRT::UINT num_dimensions, const std::vector<GRT::MinMax> &ranges, bool scaling);
+        void clear();
+        
+        // Returns a buffer for num_queries unscaled input vectors of get_num_dimensions() values each
+        float *get_query_buffer(GRT::UINT num_queries);
+        
+        // Evaluates the queries previously written to the query buffer
+        void predict(GRT::UINT num_queries);
+        
+        bool is_built() const { return built; }
+        bool has_probabilities() const { return probabilities; }
+        GRT::UINT get_num_dimensions() const { return num_dimensions; }
+        GRT::UINT get_num_classes() const { return num_classes; }
+        GRT::UINT get_num_support_vectors() const { return num_support_vectors; }
+        int get_label(GRT::UINT class_index) const { return labels[class_index]; }
+        
+        double get_predicted_label(GRT::UINT query) const { return predicted_labels[query]; }
+        const double *get_decision_values(GRT::UINT query) const { return &decision_values[query * num_decision_values]; }
+        const double *get_probabilities(GRT::UINT query) const { return &probability_estimates[query * num_classes]; }
+        
+    private:
+        void reserve_queries(GRT::UINT num_queries);
+        void compute_kernel_rows(GRT::UINT num_queries);
+        double predict_values(const double *kernel_row, double *dec_values);
+        double predict_probability(const double *kernel_row, double *dec_values, double *prob_estimates);
+        void multiclass_probability(double *prob_estimates);
+        
+        bool built;
+        bool probabilities;
+        int svm_type;
+        int kernel_type;
+        int degree;
+        double gamma;
+        double coef0;
+        GRT::UINT num_dimensions;
+        GRT::UINT num_classes;
+        GRT::UINT num_support_vectors;
+        GRT::UINT num_decision_values;
+        GRT::UINT query_capacity;
+        
+        // Model
+        std::vector<float> support_vectors;
+        std::vector<double> support_vector_norms;
+        std::vector<double> coefficients;
+        std::vector<double> rho;
+        std::vector<double> prob_a;
+        std::vector<double> prob_b;
+        std::vector<int> labels;
+        std::vector<GRT::UINT> class_starts;
+        std::vector<GRT::UINT> class_counts;
+        std::vector<double> scale_gain;
+        std::vector<double> scale_offset;
+        
+        // Preallocated scratch
+        std::vector<float> queries;
+        std::vector<double> query_norms;
+        std::vector<float> dot_products;
+        std::vector<double> kernel_values;
+        std::vector<double> decision_values;
+        std::vector<double> probability_estimates;
+        std::vector<double> predicted_labels;
+        std::vector<GRT::UINT> votes;
+        std::vector<double> pairwise_probabilities;
+        std::vector<double> q_matrix;
+        std::vector<double> q_p;
+    };
+    
+    static inline double svm_powi(double base, int times)
+    {
+        double tmp = base;
+        double ret = 1.0;
+        
+        for (int t = times; t > 0; t /= 2)
+        {
+            if (t % 2 == 1)
+            {
+                ret *= tmp;
+            }
+            tmp = tmp * tmp;
+        }
+        return ret;
+    }
+    
+    static inline double svm_sigmoid_predict(double decision_value, double a, double b)
+    {
+        double fApB = decision_value * a + b;
+        
+        // 1-p used later; avoid catastrophic cancellation
+        if (fApB >= 0)
+        {
+            return exp(-fApB) / (1.0 + exp(-fApB));
+        }
+        return 1.0 / (1 + exp(fApB));
+    }
+    
+    bool svm_dense_engine::build(const GRT::svm_model *model, GRT::UINT num_dimensions, const std::vector<GRT::MinMax> &ranges, bool scaling)
+    {
+        clear();
+        
+        if (model == NULL || model->l <= 0 || model->nr_class <= 0 || num_dimensions == 0)
+        {
+            return false;
+        }
+        
+        if (model->param.kernel_type == GRT::PRECOMPUTED)
+        {
+            return false;
+        }
+        
+        if (scaling && ranges.size() != num_dimensions)
+        {
+            return false;
+        }
+        
+        const bool classification = model->param.svm_type == GRT::C_SVC || model->param.svm_type == GRT::NU_SVC;
+        
+        svm_type = model->param.svm_type;
+        kernel_type = model->param.kernel_type;
+        degree = model->param.degree;
+        gamma = model->param.gamma;
+        coef0 = model->param.coef0;
+        
+        this->num_dimensions = num_dimensions;
+        num_classes = model->nr_class;
+        num_support_vectors = model->l;
+        num_decision_values = classification ? num_classes * (num_classes - 1) / 2 : 1;
+        probabilities = classification && model->probA != NULL && model->probB != NULL;
+        
+        support_vectors.assign(num_dimensions * num_support_vectors, 0.0f);
+        support_vector_norms.assign(num_support_vectors, 0.0);
+        
+        for (GRT::UINT sv = 0; sv < num_support_vectors; ++sv)
+        {
+            // libsvm nodes are sparse and 1-indexed, missing indices are zero
+            for (const GRT::svm_node *node = model->SV[sv]; node->index != -1; ++node)
+            {
+                if (node->index < 1 || (GRT::UINT)node->index > num_dimensions)
+                {
+                    clear();
+                    return false;
+                }
+                support_vectors[(node->index - 1) * num_support_vectors + sv] = (float)node->value;
+                support_vector_norms[sv] += node->value * node->value;
+            }
+        }
+        
+        const GRT::UINT num_coefficient_rows = num_classes - 1;
+        
+        coefficients.resize(num_coefficient_rows * num_support_vectors);
+        
+        for (GRT::UINT row = 0; row < num_coefficient_rows; ++row)
+        {
+            std::copy(model->sv_coef[row], model->sv_coef[row] + num_support_vectors, &coefficients[row * num_support_vectors]);
+        }
+        
+        rho.assign(model->rho, model->rho + num_decision_values);
+        
+        if (probabilities)
+        {
+            prob_a.assign(model->probA, model->probA + num_decision_values);
+            prob_b.assign(model->probB, model->probB + num_decision_values);
+        }
+        
+        labels.assign(num_classes, 0);
+        class_starts.assign(num_classes, 0);
+        class_counts.assign(num_classes, 0);
+        
+        if (model->label != NULL)
+        {
+            std::copy(model->label, model->label + num_classes, labels.begin());
+        }
+        
+        if (classification && model->nSV != NULL)
+        {
+            for (GRT::UINT index = 0; index < num_classes; ++index)
+            {
+                class_counts[index] = model->nSV[index];
+                class_starts[index] = index == 0 ? 0 : class_starts[index - 1] + class_counts[index - 1];
+            }
+        }
+        
+        // Fold GRT's [min, max] -> [-1, 1] input scaling into a per-dimension gain and offset
+        scale_gain.assign(num_dimensions, 1.0);
+        scale_offset.assign(num_dimensions, 0.0);
+        
+        if (scaling)
+        {
+            for (GRT::UINT dimension = 0; dimension < num_dimensions; ++dimension)
+            {
+                const double min_value = ranges[dimension].minValue;
+                const double max_value = ranges[dimension].maxValue;
+                
+                if (min_value == max_value)
+                {
+                    scale_gain[dimension] = 0.0;
+                    scale_offset[dimension] = SVM_MIN_SCALE_RANGE;
+                }
+                else
+                {
+                    scale_gain[dimension] = (SVM_MAX_SCALE_RANGE - SVM_MIN_SCALE_RANGE) / (max_value - min_value);
+                    scale_offset[dimension] = SVM_MIN_SCALE_RANGE - min_value * scale_gain[dimension];
+                }
+            }
+        }
+        
+        dot_products.assign(k_svm_tile_size, 0.0f);
+        votes.assign(num_classes, 0);
+        pairwise_probabilities.assign(num_classes * num_classes, 0.0);
+        q_matrix.assign(num_classes * num_classes, 0.0);
+        q_p.assign(num_classes, 0.0);
+        
+        reserve_queries(1);
+        
+        built = true;
+        
+        return true;
+    }
+    
+    void svm_dense_engine::clear()
+    {
+        built = false;
+        probabilities = false;
+        num_dimensions = 0;
+        num_classes = 0;
+        num_support_vectors = 0;
+        num_decision_values = 0;
+        query_capacity = 0;
+        
+        support_vectors.clear();
+        support_vector_norms.clear();
+        coefficients.clear();
+        rho.clear();
+        prob_a.clear();
+        prob_b.clear();
+        labels.clear();
+        class_starts.clear();
+        class_counts.clear();
+        scale_gain.clear();
+        scale_offset.clear();
+        queries.clear();
+        query_norms.clear();
+        kernel_values.clear();
+        decision_values.clear();
+        probability_estimates.clear();
+        predicted_labels.clear();
+    }
+    
+    void svm_dense_engine::reserve_queries(GRT::UINT num_queries)
+    {
+        if (num_queries <= query_capacity)
+        {
+            return;
+        }
+        
+        query_capacity = num_queries;
+        queries.resize(query_capacity * num_dimensions);
+        query_norms.resize(query_capacity);
+        kernel_values.resize(query_capacity * num_support_vectors);
+        decision_values.resize(query_capacity * num_decision_values);
+        probability_estimates.resize(query_capacity * num_classes);
+        predicted_labels.resize(query_capacity);
+    }
+    
+    float *svm_dense_engine::get_query_buffer(GRT::UINT num_queries)
+    {
+        reserve_queries(num_queries);
+        return &queries[0];
+    }
+    
+    void svm_dense_engine::predict(GRT::UINT num_queries)
+    {
+        if (!built || num_queries == 0 || num_queries > query_capacity)
+        {
+            return;
+        }
+        
+        for (GRT::UINT query = 0; query < num_queries; ++query)
+        {
+            float *x = &queries[query * num_dimensions];
+            double norm = 0.0;
+            
+            for (GRT::UINT dimension = 0; dimension < num_dimensions; ++dimension)
+            {
+                x[dimension] = (float)(x[dimension] * scale_gain[dimension] + scale_offset[dimension]);
+                norm += (double)x[dimension] * x[dimension];
+            }
+            query_norms[query] = norm;
+        }
+        
+        compute_kernel_rows(num_queries);
+        
+        for (GRT::UINT query = 0; query < num_queries; ++query)
+        {
+            const double *kernel_row = &kernel_values[query * num_support_vectors];
+            double *dec_values = &decision_values[query * num_decision_values];
+            
+            if (probabilities)
+            {
+                predicted_labels[query] = predict_probability(kernel_row, dec_values, &probability_estimates[query * num_classes]);
+            }
+            else
+            {
+                predicted_labels[query] = predict_values(kernel_row, dec_values);
+            }
+        }
+    }
+    
+    // Kernel rows are computed one tile of support vectors at a time so that the tile stays in cache across a batch
+    void svm_dense_engine::compute_kernel_rows(GRT::UINT num_queries)
+    {
+        float *dots = &dot_products[0];
+        
+        for (GRT::UINT tile_start = 0; tile_start < num_support_vectors; tile_start += k_svm_tile_size)
+        {
+            const GRT::UINT tile_size = std::min(k_svm_tile_size, num_support_vectors - tile_start);
+            const double *sv_norms = &support_vector_norms[tile_start];
+            
+            for (GRT::UINT query = 0; query < num_queries; ++query)
+            {
+                const float *x = &queries[query * num_dimensions];
+                double *kernel_row = &kernel_values[query * num_support_vectors + tile_start];
+                
+                std::fill(dots, dots + tile_size, 0.0f);
+                
+                for (GRT::UINT dimension = 0; dimension < num_dimensions; ++dimension)
+                {
+                    const float x_d = x[dimension];
+                    const float *sv_row = &support_vectors[dimension * num_support_vectors + tile_start];
+                    
+                    for (GRT::UINT index = 0; index < tile_size; ++index)
+                    {
+                        dots[index] += x_d * sv_row[index];
+                    }
+                }
+                
+                switch (kernel_type)
+                {
+                    case GRT::LINEAR:
+                        for (GRT::UINT index = 0; index < tile_size; ++index)
+                        {
+                            kernel_row[index] = dots[index];
+                        }
+                        break;
+                        
+                    case GRT::POLY:
+                        for (GRT::UINT index = 0; index < tile_size; ++index)
+                        {
+                            kernel_row[index] = svm_powi(gamma * dots[index] + coef0, degree);
+                        }
+                        break;
+                        
+                    case GRT::RBF:
+                        for (GRT::UINT index = 0; index < tile_size; ++index)
+                        {
+                            double distance = query_norms[query] + sv_norms[index] - 2.0 * dots[index];
+                            kernel_row[index] = exp(-gamma * (distance > 0.0 ? distance : 0.0));
+                        }
+                        break;
+                        
+                    case GRT::SIGMOID:
+                        for (GRT::UINT index = 0; index < tile_size; ++index)
+                        {
+                            kernel_row[index] = tanh(gamma * dots[index] + coef0);
+                        }
+                        break;
+                        
+                    default:
+                        std::fill(kernel_row, kernel_row + tile_size, 0.0);
+                        break;
+                }
+            }
+        }
+    }
+    
+    // Mirrors svm_predict_values() in libsvm
+    double svm_dense_engine::predict_values(const double *kernel_row, double *dec_values)
+    {
+        if (svm_type == GRT::ONE_CLASS || svm_type == GRT::EPSILON_SVR || svm_type == GRT::NU_SVR)
+        {
+            const double *coef = &coefficients[0];
+            double sum = 0.0;
+            
+            for (GRT::UINT index = 0; index < num_support_vectors; ++index)
+            {
+                sum += coef[index] * kernel_row[index];
+            }
+            sum -= rho[0];
+            *dec_values = sum;
+            
+            if (svm_type == GRT::ONE_CLASS)
+            {
+                return sum > 0 ? 1 : -1;
+            }
+            return sum;
+        }
+        
+        std::fill(votes.begin(), votes.end(), 0);
+        
+        GRT::UINT p = 0;
+        
+        for (GRT::UINT i = 0; i < num_classes; ++i)
+        {
+            for (GRT::UINT j = i + 1; j < num_classes; ++j)
+            {
+                const GRT::UINT si = class_starts[i];
+                const GRT::UINT sj = class_starts[j];
+                const GRT::UINT ci = class_counts[i];
+                const GRT::UINT cj = class_counts[j];
+                const double *coef1 = &coefficients[(j - 1) * num_support_vectors];
+                const double *coef2 = &coefficients[i * num_support_vectors];
+                double sum = 0.0;
+                
+                for (GRT::UINT k = 0; k < ci; ++k)
+                {
+                    sum += coef1[si + k] * kernel_row[si + k];
+                }
+                for (GRT::UINT k = 0; k < cj; ++k)
+                {
+                    sum += coef2[sj + k] * kernel_row[sj + k];
+                }
+                sum -= rho[p];
+                dec_values[p] = sum;
+                
+                if (dec_values[p] > 0)
+                {
+                    ++votes[i];
+                }
+                else
+                {
+                    ++votes[j];
+                }
+                ++p;
+            }
+        }
+        
+        GRT::UINT vote_max_index = 0;
+        
+        for (GRT::UINT i = 1; i < num_classes; ++i)
+        {
+            if (votes[i] > votes[vote_max_index])
+            {
+                vote_max_index = i;
+            }
+        }
+        
+        return labels[vote_max_index];
+    }
+    
+    // Mirrors svm_predict_probability() in libsvm
+    double svm_dense_engine::predict_probability(const double *kernel_row, double *dec_values, double *prob_estimates)
+    {
+        predict_values(kernel_row, dec_values);
+        
+        GRT::UINT k = 0;
+        
+        for (GRT::UINT i = 0; i < num_classes; ++i)
+        {
+            for (GRT::UINT j = i + 1; j < num_classes; ++j)
+            {
+                double probability = svm_sigmoid_predict(dec_values[k], prob_a[k], prob_b[k]);
+                probability = std::min(std::max(probability, k_svm_min_probability), 1 - k_svm_min_probability);
+                pairwise_probabilities[i * num_classes + j] = probability;
+                pairwise_probabilities[j * num_classes + i] = 1 - probability;
+                ++k;
+            }
+        }
+        
+        multiclass_probability(prob_estimates);
+        
+        GRT::UINT prob_max_index = 0;
+        
+        for (GRT::UINT i = 1; i < num_classes; ++i)
+        {
+            if (prob_estimates[i] > prob_estimates[prob_max_index])
+            {
+                prob_max_index = i;
+            }
+        }
+        
+        return labels[prob_max_index];
+    }
+    
+    // Pairwise coupling, method 2 from Wu, Lin, and Weng, as implemented by multiclass_probability() in libsvm
+    void svm_dense_engine::multiclass_probability(double *p)
+    {
+        const GRT::UINT k = num_classes;
+        const GRT::UINT max_iter = std::max<GRT::UINT>(100, k);
+        const double eps = 0.005 / k;
+        const double *r = &pairwise_probabilities[0];
+        double *Q = &q_matrix[0];
+        double *Qp = &q_p[0];
+        
+        for (GRT::UINT t = 0; t < k; ++t)
+        {
+            p[t] = 1.0 / k;
+            Q[t * k + t] = 0;
+            
+            for (GRT::UINT j = 0; j < t; ++j)
+            {
+                Q[t * k + t] += r[j * k + t] * r[j * k + t];
+                Q[t * k + j] = Q[j * k + t];
+            }
+            for (GRT::UINT j = t + 1; j < k; ++j)
+            {
+                Q[t * k + t] += r[j * k + t] * r[j * k + t];
+                Q[t * k + j] = -r[j * k + t] * r[t * k + j];
+            }
+        }
+        
+        for (GRT::UINT iter = 0; iter < max_iter; ++iter)
+        {
+            // stopping condition, recalculate QP,pQP for numerical accuracy
+            double pQp = 0;
+            
+            for (GRT::UINT t = 0; t < k; ++t)
+            {
+                Qp[t] = 0;
+                for (GRT::UINT j = 0; j < k; ++j)
+                {
+                    Qp[t] += Q[t * k + j] * p[j];
+                }
+                pQp += p[t] * Qp[t];
+            }
+            
+            double max_error = 0;
+            
+            for (GRT::UINT t = 0; t < k; ++t)
+            {
+                double error = fabs(Qp[t] - pQp);
+                if (error > max_error)
+                {
+                    max_error = error;
+                }
+            }
+            
+            if (max_error < eps)
+            {
+                break;
+            }
+            
+            for (GRT::UINT t = 0; t < k; ++t)
+            {
+                double diff = (-Qp[t] + pQp) / Q[t * k + t];
+                p[t] += diff;
+                pQp = (pQp + diff * (diff * Q[t * k + t] + 2 * Qp[t])) / (1 + diff) / (1 + diff);
+                
+                for (GRT::UINT j = 0; j < k; ++j)
+                {
+                    Qp[j] = (Qp[j] + diff * Q[t * k + j]) / (1 + diff);
+                    p[j] /= (1 + diff);
+                }
+            }
+        }
+    }
+    
+    // Budgeted support vector reduction
+    //
+    // For RBF kernels pairs of support vectors from the same class are merged into a single vector z = h*a + (1-h)*b
+    // (Wang, Crammer and Vucetic, "Breaking the curse of kernelization", JMLR 2012). The merged coefficients are the
+    // projection of the pair onto z, and each merge picks the partner that minimises the weight degradation of the
+    // decision functions. libsvm's one-vs-one models share support vectors between decision functions, so
+    // coefficients are handled as vectors of the num_classes - 1 entries of sv_coef. Other kernels have no closed
+    // form merge and fall back to removing the support vector with the smallest coefficients
+    const GRT::UINT k_svm_merge_iterations = 20;
+    const double k_svm_golden_ratio = 0.6180339887498949;
+    
+    struct svm_reduced_set
+    {
+        GRT::UINT num_dimensions;
+        GRT::UINT num_coefficients;
+        std::vector<double> vectors;
+        std::vector<double> coefficients;
+        std::vector<GRT::UINT> classes;
+        std::vector<bool> alive;
+        
+        double *vector(GRT::UINT index) { return &vectors[index * num_dimensions]; }
+        double *coefficient(GRT::UINT index) { return &coefficients[index * num_coefficients]; }
+        
+        double coefficient_norm(GRT::UINT index)
+        {
+            const double *alpha = coefficient(index);
+            double norm = 0.0;
+            
+            for (GRT::UINT c = 0; c < num_coefficients; ++c)
+            {
+                norm += fabs(alpha[c]);
+            }
+            return norm;
+        }
+    };
+    
+    // Maximises m * K^((1-h)^2) + (1-m) * K^(h^2) over h in [0, 1] by golden section search
+    static double svm_merge_position(double m, double kernel)
+    {
+        const double log_kernel = log(std::max(kernel, DBL_MIN));
+        double lower = 0.0;
+        double upper = 1.0;
+        
+        for (GRT::UINT iteration = 0; iteration < k_svm_merge_iterations; ++iteration)
+        {
+            const double h1 = upper - k_svm_golden_ratio * (upper - lower);
+            const double h2 = lower + k_svm_golden_ratio * (upper - lower);
+            const double f1 = m * exp(log_kernel * (1 - h1) * (1 - h1)) + (1 - m) * exp(log_kernel * h1 * h1);
+            const double f2 = m * exp(log_kernel * (1 - h2) * (1 - h2)) + (1 - m) * exp(log_kernel * h2 * h2);
+            
+            if (f1 < f2)
+            {
+                lower = h1;
+            }
+            else
+            {
+                upper = h2;
+            }
+        }
+        return (lower + upper) / 2;
+    }
+    
+    // GRT::SVM with a dense inference engine that is rebuilt whenever a model is trained or loaded
+    class ml_svm_model : public GRT::SVM
+    {
+    public:
+        bool train_(GRT::ClassificationData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        // Classifies the queries written to get_dense_engine().get_query_buffer(), applying NULL rejection
+        bool predict_dense(GRT::UINT num_queries);
+        
+        // Reduces the number of support vectors to at most budget, see svm_reduced_set
+        bool compress(GRT::UINT budget);
+        
+        GRT::UINT get_dense_label(GRT::UINT query) const { return dense_labels[query]; }
+        svm_dense_engine &get_dense_engine() { return engine; }
+        const svm_dense_engine &get_dense_engine() const { return engine; }
+        
+        using GRT::SVM::train_;
+        using GRT::SVM::predict_;
+        using GRT::SVM::loadModelFromFile;
+        
+    protected:
+        bool build_dense_engine();
+        
+        svm_dense_engine engine;
+        std::vector<GRT::UINT> dense_labels;
+    };
+    
+    bool ml_svm_model::build_dense_engine()
+    {
+        if (!trained || !engine.build(model, numInputDimensions, ranges, useScaling))
+        {
+            engine.clear();
+            return false;
+        }
+        
+        classLikelihoods.assign(engine.get_num_classes(), 0.0);
+        classDistances.assign(engine.get_num_classes(), 0.0);
+        
+        return true;
+    }
+    
+    bool ml_svm_model::train_(GRT::ClassificationData &trainingData)
+    {
+        engine.clear();
+        
+        if (!GRT::SVM::train_(trainingData))
+        {
+            return false;
+        }
+        build_dense_engine();
+        
+        return true;
+    }
+    
+    bool ml_svm_model::loadModelFromFile(fstream &file)
+    {
+        engine.clear();
+        
+        if (!GRT::SVM::loadModelFromFile(file))
+        {
+            return false;
+        }
+        build_dense_engine();
+        
+        return true;
+    }
+    
+    bool ml_svm_model::clear()
+    {
+        engine.clear();
+        return GRT::SVM::clear();
+    }
+    
+    bool ml_svm_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        // Kernels the dense engine doesn't handle (e.g. precomputed) go through libsvm
+        if (!engine.is_built())
+        {
+            return GRT::SVM::predict_(inputVector);
+        }
+        
+        if (inputVector.size() != engine.get_num_dimensions())
+        {
+            return false;
+        }
+        
+        float *query = engine.get_query_buffer(1);
+        
+        for (GRT::UINT index = 0; index < inputVector.size(); ++index)
+        {
+            query[index] = (float)inputVector[index];
+        }
+        
+        return predict_dense(1);
+    }
+    
+    bool ml_svm_model::predict_dense(GRT::UINT num_queries)
+    {
+        if (!trained || !engine.is_built() || num_queries == 0)
+        {
+            return false;
+        }
+        
+        if (dense_labels.size() < num_queries)
+        {
+            dense_labels.resize(num_queries);
+        }
+        
+        engine.predict(num_queries);
+        
+        const GRT::UINT num_classes = engine.get_num_classes();
+        
+        for (GRT::UINT query = 0; query < num_queries; ++query)
+        {
+            GRT::UINT label = (GRT::UINT)engine.get_predicted_label(query);
+            
+            if (engine.has_probabilities())
+            {
+                const double *probabilities = engine.get_probabilities(query);
+                double max_probability = 0;
+                
+                for (GRT::UINT k = 0; k < num_classes; ++k)
+                {
+                    max_probability = std::max(max_probability, probabilities[k]);
+                }
+                
+                if (useNullRejection && max_probability < classificationThreshold)
+                {
+                    label = GRT_DEFAULT_NULL_CLASS_LABEL;
+                }
+                
+                // GRT's prediction state reflects the last query in the batch
+                if (query == num_queries - 1)
+                {
+                    std::copy(probabilities, probabilities + num_classes, classLikelihoods.begin());
+                    maxLikelihood = max_probability;
+                }
+            }
+            
+            dense_labels[query] = label;
+        }
+        
+        predictedClassLabel = dense_labels[num_queries - 1];
+        
+        return true;
+    }
+    
+    bool ml_svm_model::compress(GRT::UINT budget)
+    {
+        if (!trained || model == NULL || model->l <= 0)
+        {
+            return false;
+        }
+        
+        if (model->param.svm_type != GRT::C_SVC && model->param.svm_type != GRT::NU_SVC)
+        {
+            return false;
+        }
+        
+        const GRT::UINT num_classes = model->nr_class;
+        const GRT::UINT num_support_vectors = model->l;
+        
+        if (budget < num_classes || model->param.kernel_type == GRT::PRECOMPUTED)
+        {
+            return false;
+        }
+        
+        if (budget >= num_support_vectors)
+        {
+            return true;
+        }
+        
+        svm_reduced_set set;
+        
+        set.num_dimensions = numInputDimensions;
+        set.num_coefficients = num_classes - 1;
+        set.vectors.assign(num_support_vectors * set.num_dimensions, 0.0);
+        set.coefficients.resize(num_support_vectors * set.num_coefficients);
+        set.classes.resize(num_support_vectors);
+        set.alive.assign(num_support_vectors, true);
+        
+        std::vector<GRT::UINT> class_counts(model->nSV, model->nSV + num_classes);
+        
+        for (GRT::UINT sv = 0, class_index = 0, class_end = class_counts[0]; sv < num_support_vectors; ++sv)
+        {
+            while (sv >= class_end && class_index < num_classes - 1)
+            {
+                class_end += class_counts[++class_index];
+            }
+            set.classes[sv] = class_index;
+            
+            for (const GRT::svm_node *node = model->SV[sv]; node->index != -1; ++node)
+            {
+                if (node->index < 1 || (GRT::UINT)node->index > set.num_dimensions)
+                {
+                    return false;
+                }
+                set.vector(sv)[node->index - 1] = node->value;
+            }
+            
+            for (GRT::UINT c = 0; c < set.num_coefficients; ++c)
+            {
+                set.coefficient(sv)[c] = model->sv_coef[c][sv];
+            }
+        }
+        
+        const bool merge = model->param.kernel_type == GRT::RBF;
+        const double gamma = model->param.gamma;
+        std::vector<double> merged_coefficients(set.num_coefficients);
+        std::vector<double> best_coefficients(set.num_coefficients);
+        
+        for (GRT::UINT num_alive = num_support_vectors; num_alive > budget; --num_alive)
+        {
+            // The support vector contributing least to the decision functions, from a class that can spare one
+            GRT::UINT a = num_support_vectors;
+            double a_norm = DBL_MAX;
+            
+            for (GRT::UINT sv = 0; sv < num_support_vectors; ++sv)
+            {
+                if (set.alive[sv] && class_counts[set.classes[sv]] > 1)
+                {
+                    const double norm = set.coefficient_norm(sv);
+                    
+                    if (norm < a_norm)
+                    {
+                        a = sv;
+                        a_norm = norm;
+                    }
+                }
+            }
+            
+            if (a == num_support_vectors)
+            {
+                break;
+            }
+            
+            --class_counts[set.classes[a]];
+            set.alive[a] = false;
+            
+            if (!merge)
+            {
+                continue;
+            }
+            
+            const double *alpha_a = set.coefficient(a);
+            const double *x_a = set.vector(a);
+            GRT::UINT best_b = num_support_vectors;
+            double best_h = 0.0;
+            double best_degradation = DBL_MAX;
+            
+            for (GRT::UINT b = 0; b < num_support_vectors; ++b)
+            {
+                if (!set.alive[b] || set.classes[b] != set.classes[a])
+                {
+                    continue;
+                }
+                
+                const double *alpha_b = set.coefficient(b);
+                const double *x_b = set.vector(b);
+                double distance = 0.0;
+                
+                for (GRT::UINT dimension = 0; dimension < set.num_dimensions; ++dimension)
+                {
+                    const double delta = x_a[dimension] - x_b[dimension];
+                    distance += delta * delta;
+                }
+                
+                const double kernel = exp(-gamma * distance);
+                const double b_norm = set.coefficient_norm(b);
+                const double m = a_norm + b_norm > 0 ? a_norm / (a_norm + b_norm) : 0.5;
+                const double h = svm_merge_position(m, kernel);
+                const double k_az = pow(kernel, (1 - h) * (1 - h));
+                const double k_bz = pow(kernel, h * h);
+                double degradation = 0.0;
+                
+                // ||alpha_a phi(a) + alpha_b phi(b) - alpha_z phi(z)||^2 summed over the decision functions
+                for (GRT::UINT c = 0; c < set.num_coefficients; ++c)
+                {
+                    merged_coefficients[c] = alpha_a[c] * k_az + alpha_b[c] * k_bz;
+                    degradation += alpha_a[c] * alpha_a[c] + alpha_b[c] * alpha_b[c] + 2 * alpha_a[c] * alpha_b[c] * kernel - merged_coefficients[c] * merged_coefficients[c];
+                }
+                
+                if (degradation < best_degradation)
+                {
+                    best_degradation = degradation;
+                    best_b = b;
+                    best_h = h;
+                    best_coefficients.swap(merged_coefficients);
+                }
+            }
+            
+            if (best_b == num_support_vectors)
+            {
+                continue;
+            }
+            
+            // z replaces b, a is dropped
+            double *x_b = set.vector(best_b);
+            
+            for (GRT::UINT dimension = 0; dimension < set.num_dimensions; ++dimension)
+            {
+                x_b[dimension] = best_h * x_a[dimension] + (1 - best_h) * x_b[dimension];
+            }
+            std::copy(best_coefficients.begin(), best_coefficients.end(), set.coefficient(best_b));
+        }
+        
+        // Write the reduced set back in libsvm's layout: SVs grouped by class, one contiguous node block (free_sv = 1)
+        GRT::UINT num_reduced = 0;
+        
+        for (GRT::UINT sv = 0; sv < num_support_vectors; ++sv)
+        {
+            num_reduced += set.alive[sv] ? 1 : 0;
+        }
+        
+        GRT::svm_node *nodes = (GRT::svm_node *)malloc(num_reduced * (set.num_dimensions + 1) * sizeof(GRT::svm_node));
+        GRT::svm_node **support_vectors = (GRT::svm_node **)malloc(num_reduced * sizeof(GRT::svm_node *));
+        double **sv_coef = (double **)malloc(set.num_coefficients * sizeof(double *));
+        
+        for (GRT::UINT c = 0; c < set.num_coefficients; ++c)
+        {
+            sv_coef[c] = (double *)malloc(num_reduced * sizeof(double));
+        }
+        
+        GRT::UINT reduced = 0;
+        
+        for (GRT::UINT class_index = 0; class_index < num_classes; ++class_index)
+        {
+            model->nSV[class_index] = 0;
+            
+            for (GRT::UINT sv = 0; sv < num_support_vectors; ++sv)
+            {
+                if (!set.alive[sv] || set.classes[sv] != class_index)
+                {
+                    continue;
+                }
+                
+                GRT::svm_node *node = &nodes[reduced * (set.num_dimensions + 1)];
+                support_vectors[reduced] = node;
+                
+                for (GRT::UINT dimension = 0; dimension < set.num_dimensions; ++dimension)
+                {
+                    node[dimension].index = dimension + 1;
+                    node[dimension].value = set.vector(sv)[dimension];
+                }
+                node[set.num_dimensions].index = -1;
+                node[set.num_dimensions].value = 0;
+                
+                for (GRT::UINT c = 0; c < set.num_coefficients; ++c)
+                {
+                    sv_coef[c][reduced] = set.coefficient(sv)[c];
+                }
+                
+                ++model->nSV[class_index];
+                ++reduced;
+            }
+        }
+        
+        if (model->free_sv && model->l > 0 && model->SV != NULL)
+        {
+            free((void *)model->SV[0]);
+        }
+        free(model->SV);
+        
+        for (GRT::UINT c = 0; c < set.num_coefficients; ++c)
+        {
+            free(model->sv_coef[c]);
+        }
+        free(model->sv_coef);
+        
+        model->SV = support_vectors;
+        model->sv_coef = sv_coef;
+        model->l = num_reduced;
+        model->free_sv = 1;
+        
+        return build_dense_engine();
+    }
+    
     class ml_svm : ml_classification
     {
         FLEXT_HEADER_S(ml_svm, ml_classification, setup);
@@ -141,11 +1156,14 @@ namespace ml
             FLEXT_CADDATTR_GET(c, "mode", get_kfold_value);
             
             FLEXT_CADDMETHOD_(c, 0, "cross_validation", cross_validation);
+            FLEXT_CADDMETHOD_(c, 0, "compress", compress);
             
             DefineHelp(c, ml_object_name.c_str());
         }
         
+        void map(int argc, const t_atom *argv);
         void cross_validation();
+        void compress(int argc, const t_atom *argv);
         
         // Flext attribute setters
         void set_type(int type); // svm type
@@ -185,6 +1203,7 @@ namespace ml
     private:
         // Flext method wrappers
         FLEXT_CALLBACK(cross_validation);
+        FLEXT_CALLBACK_V(compress);
         
         // Flext attribute wrappers
         FLEXT_CALLVAR_I(get_type, set_type);
@@ -205,8 +1224,13 @@ namespace ml
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        GRT::SVM svm;
+        double get_accuracy(const GRT::ClassificationData &data);
         
+        ml_svm_model svm;
+        AtomList probs_list;
+        AtomList labels_list;
+        
+        static const t_symbol *s_compress;
         static const std::string attribute_help;
         static const std::string method_help;
     };
@@ -377,12 +1401,193 @@ namespace ml
         error("function not implemented");
     }
     
+    void ml_svm::map(int argc, const t_atom *argv)
+    {
+        svm_dense_engine &engine = svm.get_dense_engine();
+        
+        if (!engine.is_built())
+        {
+            ml_classification::map(argc, argv);
+            return;
+        }
+        
+        const GRT::UINT numInputDimensions = engine.get_num_dimensions();
+        
+        if (argc <= 0 || (unsigned)argc % numInputDimensions != 0)
+        {
+            std::stringstream ss;
+            ss << "invalid input length, expected " << numInputDimensions << " or a multiple of " << numInputDimensions << ", got " << argc;
+            error(ss.str());
+            return;
+        }
+        
+        const GRT::UINT numQueries = argc / numInputDimensions;
+        float *queries = engine.get_query_buffer(numQueries);
+        
+        for (uint32_t index = 0; index < (uint32_t)argc; ++index)
+        {
+            queries[index] = GetAFloat(argv[index]);
+        }
+        
+        bool success = svm.predict_dense(numQueries);
+        
+        if (success == false)
+        {
+            error("unable to map input");
+            return;
+        }
+        
+        // A list of several concatenated feature vectors is classified as one batch and gives a list of labels
+        if (numQueries > 1)
+        {
+            if (labels_list.Count() != (int)numQueries)
+            {
+                labels_list(numQueries);
+            }
+            
+            for (GRT::UINT query = 0; query < numQueries; ++query)
+            {
+                SetInt(labels_list[query], svm.get_dense_label(query));
+            }
+            
+            ToOutList(0, labels_list);
+            return;
+        }
+        
+        if (probs && engine.has_probabilities())
+        {
+            const GRT::UINT numClasses = engine.get_num_classes();
+            const double *probabilities = engine.get_probabilities(0);
+            
+            if (probs_list.Count() != (int)numClasses * 2)
+            {
+                probs_list(numClasses * 2);
+            }
+            
+            for (GRT::UINT count = 0; count < numClasses; ++count)
+            {
+                SetInt(probs_list[count * 2], engine.get_label(count));
+                SetFloat(probs_list[count * 2 + 1], probabilities[count]);
+            }
+            
+            ToOutAnything(1, s_probs, probs_list);
+        }
+        
+        ToOutInt(0, svm.get_dense_label(0));
+    }
+    
     void ml_svm::cross_validation()
     {
         double result = svm.getCrossValidationResult();
         ToOutDouble(0, result);
     }
     
+    void ml_svm::compress(int argc, const t_atom *argv)
+    {
+        if (argc < 1 || argc > 2 || !IsFloat(argv[0]) || (argc == 2 && !IsSymbol(argv[1])))
+        {
+            error("invalid arguments, expected compress <budget> [held-out data path]");
+            return;
+        }
+        
+        const int budget = GetAInt(argv[0]);
+        
+        if (budget < 1)
+        {
+            error("budget must be greater than zero");
+            return;
+        }
+        
+        if (!svm.getTrained() || !svm.get_dense_engine().is_built())
+        {
+            error("model has not been trained, use 'train' to train the model");
+            return;
+        }
+        
+        GRT::ClassificationData held_out_data;
+        const GRT::ClassificationData *test_data = &classification_data;
+        
+        if (argc == 2)
+        {
+            if (!held_out_data.loadDatasetFromFile(GetString(argv[1])))
+            {
+                error("unable to read held-out data from path: " + std::string(GetString(argv[1])));
+                return;
+            }
+            test_data = &held_out_data;
+        }
+        
+        if (test_data->getNumSamples() == 0)
+        {
+            error("no observations to measure accuracy against, use 'add' or give the path of a held-out data file");
+            return;
+        }
+        
+        if (test_data->getNumDimensions() != svm.get_dense_engine().get_num_dimensions())
+        {
+            error("held-out data dimensions do not match the model");
+            return;
+        }
+        
+        const GRT::UINT numSupportVectors = svm.get_dense_engine().get_num_support_vectors();
+        const double accuracyBefore = get_accuracy(*test_data);
+        
+        if (!svm.compress(budget))
+        {
+            error("compression failed, hint: budget must be at least the number of classes and type must be C-SVC or nu-SVC");
+            return;
+        }
+        
+        const double accuracyAfter = get_accuracy(*test_data);
+        const GRT::UINT numReduced = svm.get_dense_engine().get_num_support_vectors();
+        
+        std::stringstream ss;
+        ss << "support vectors reduced from " << numSupportVectors << " to " << numReduced << ", accuracy " << accuracyBefore * 100.0 << "% -> " << accuracyAfter * 100.0 << "%";
+        post(ss.str());
+        
+        t_atom result[3];
+        
+        SetInt(result[0], numReduced);
+        SetFloat(result[1], accuracyBefore);
+        SetFloat(result[2], accuracyAfter);
+        
+        ToOutAnything(1, s_compress, 3, result);
+    }
+    
+    double ml_svm::get_accuracy(const GRT::ClassificationData &data)
+    {
+        svm_dense_engine &engine = svm.get_dense_engine();
+        const GRT::UINT numSamples = data.getNumSamples();
+        const GRT::UINT numDimensions = engine.get_num_dimensions();
+        const GRT::UINT batchSize = 256;
+        GRT::UINT numCorrect = 0;
+        
+        for (GRT::UINT start = 0; start < numSamples; start += batchSize)
+        {
+            const GRT::UINT numQueries = std::min(batchSize, numSamples - start);
+            float *queries = engine.get_query_buffer(numQueries);
+            
+            for (GRT::UINT query = 0; query < numQueries; ++query)
+            {
+                const GRT::ClassificationSample &sample = data[start + query];
+                
+                for (GRT::UINT dimension = 0; dimension < numDimensions; ++dimension)
+                {
+                    queries[query * numDimensions + dimension] = (float)sample[dimension];
+                }
+            }
+            
+            svm.predict_dense(numQueries);
+            
+            for (GRT::UINT query = 0; query < numQueries; ++query)
+            {
+                numCorrect += svm.get_dense_label(query) == data[start + query].getClassLabel() ? 1 : 0;
+            }
+        }
+        
+        return (double)numCorrect / numSamples;
+    }
+    
     // Implement pure virtual methods
     GRT::Classifier &ml_svm::get_Classifier_instance()
     {
@@ -394,6 +1599,8 @@ namespace ml
         return svm;
     }
     
+    const t_symbol *ml_svm::s_compress = flext::MakeSymbol("compress");
+    
     const std::string ml_svm::attribute_help =
     "type:\tset type of SVM (default 0)\n"
     "	0 -- C-SVC		(multi-class classification)\n"
@@ -418,7 +1625,9 @@ namespace ml
     "shrinking:\twhether to use the shrinking heuristics, 0 or 1 (default 1)\n";
     
     const std::string ml_svm::method_help =
-    "cross_validation:\t\tperform cross-validation\n";
+    "map:\tclassify the input feature vector, a list of several concatenated feature vectors is classified as a batch and outputs a list of class labels\n"
+    "cross_validation:\t\tperform cross-validation\n"
+    "compress:\treduce the trained model to at most <budget> support vectors by merging (RBF kernel) or pruning them, an optional second argument gives the path of a held-out data file, otherwise accuracy is measured on the training data. Outputs the new number of support vectors and the accuracy before and after\n";
     
     typedef class ml_svm ml0x2esvm;
 
@@ -17,6 +17,7 @@
  */
 
 #include "ml_base.h"
+#include "ml_minmax_detector.h"
 
 #include "GRT.h"
 
@@ -28,17 +29,24 @@ namespace ml
     const t_symbol *s_min  = flext::MakeSymbol("min");
     const t_symbol *s_max  = flext::MakeSymbol("max");
     
+    // Number of extrema of each kind per list the output is sized for up front
+    const uint32_t k_minmax_list_reserve = 256;
+    
     class ml_minmax : ml_base
     {
         FLEXT_HEADER_S(ml_minmax, ml_base, setup);
         
     public:
         ml_minmax()
-        : delta(1e-6)
+        : block_start(0)
         {
             post("Peak / valley detection based on Eli Billauer's peakdet");
             FLEXT_ADDMETHOD(0, input);
             help.append_attributes(attribute_help);
+            help.append_methods(method_help);
+            
+            minima.reserve(1 + 2 * k_minmax_list_reserve);
+            maxima.reserve(1 + 2 * k_minmax_list_reserve);
         }
         
     protected:
@@ -48,11 +56,14 @@ namespace ml
             
             FLEXT_CADDATTR_SET(c, "delta", set_delta);
             FLEXT_CADDATTR_GET(c, "delta", get_delta);
-                        
+            
+            FLEXT_CADDMETHOD_(c, 0, "reset", reset);
+            
             DefineHelp(c, ml_object_name.c_str());
         }
         
         void input(int argc, t_atom *argv);
+        void reset();
         
         // Flext attribute setters
         void set_delta(float delta);
@@ -65,6 +76,7 @@ namespace ml
         
         // Flext method wrappers
         FLEXT_CALLBACK_V(input);
+        FLEXT_CALLBACK(reset);
         
         // Flext attribute wrappers
         FLEXT_CALLVAR_F(get_delta, set_delta);
@@ -72,159 +84,80 @@ namespace ml
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        double delta;
-        
-        // Utility methods
-        void detect_minmax(
-                           const std::vector<double> &data,
-                           std::vector<uint32_t> &maxima_locations,
-                           std::vector<uint32_t> &minima_locations
-                           );
+        // State carries over from one list to the next, positions are counted from the last reset
+        ml_minmax_detector detector;
+        uint64_t block_start;
         
-        void populate_locations(
-                                const std::vector<double> &data,
-                                const std::vector<uint32_t> &locations,
-                                AtomList &atomList
-                                );
+        // Output lists, reused for every input
+        std::vector<t_atom> minima;
+        std::vector<t_atom> maxima;
         
         static const std::string attribute_help;
+        static const std::string method_help;
     };
     
     void ml_minmax::set_delta(float delta)
     {
-        if (delta <= 0)
+        if (!detector.set_delta(delta))
         {
             error("minmax delta must be positive and non-zero");
             return;
         }
-        
-        this->delta = delta;
     }
     
     // Flext attribute getters
     void ml_minmax::get_delta(float &delta) const
     {
-        delta = this->delta;
+        delta = detector.get_delta();
     }
     
     void ml_minmax::input(int argc, t_atom *argv)
     {
-        AtomList maxima;
-        AtomList minima;
         t_atom min_a;
         t_atom max_a;
-        std::vector<double> data;
-        std::vector<uint32_t> maxima_locations;
-        std::vector<uint32_t> minima_locations;
         
         SetSymbol(min_a, s_min);
         SetSymbol(max_a, s_max);
         
-        maxima.Append(max_a);
-        minima.Append(min_a);
-        
-        for (uint32_t index = 0; index < (unsigned)argc; ++index)
-        {
-            double value = GetAFloat(argv[index]);
-            data.push_back(value);
-        }
+        minima.assign(1, min_a);
+        maxima.assign(1, max_a);
+        block_start = detector.get_position();
         
-        detect_minmax(data, maxima_locations, minima_locations);
-        populate_locations(data, minima_locations, minima);
-        populate_locations(data, maxima_locations, maxima);
-        
-        ToOutList(0, minima);
-        ToOutList(0, maxima);
-    }
-    
-    void ml_minmax::detect_minmax(
-                                  const std::vector<double> &data,
-                                  std::vector<uint32_t> &maxima_locations,
-                                  std::vector<uint32_t> &minima_locations
-                                  )
-    {
-        double  max = DBL_MIN;
-        double  min = DBL_MAX;
-        uint32_t max_pos = 0;
-        uint32_t min_pos = 0;
-        bool    is_detecting_max = false;
-        
-        if (!maxima_locations.empty())
-        {
-            std::cout << "error: maxima_locations was non-empty" << std::endl;
-            maxima_locations.clear();
-        }
-        
-        if (!minima_locations.empty())
-        {
-            std::cout << "error: minima_locations was non-empty" << std::endl;
-            minima_locations.clear();
-        }
+        bool is_maximum = false;
+        uint64_t position = 0;
+        double value = 0.0;
         
-        // Use int64_t because the loop body decrements i
-        for(int64_t i = 1; i < data.size(); ++i)
+        for (uint32_t index = 0; index < (unsigned)argc; ++index)
         {
-            if(data[i] > max)
-            {
-                max_pos = i;
-                max = data[i];
-            }
-            if(data[i] < min)
-            {
-                min_pos = i;
-                min = data[i];
-            }
-            
-            if(is_detecting_max &&
-               data[i] < max - this->delta)
+            if (detector.update(GetAFloat(argv[index]), is_maximum, position, value))
             {
-                maxima_locations.push_back(max_pos);
-                
-                is_detecting_max = false;
+                std::vector<t_atom> &locations = is_maximum ? maxima : minima;
+                t_atom key_a;
+                t_atom value_a;
                 
-                i = max_pos - 1;
+                // Negative for an extremum in an earlier list that is only confirmed by this one
+                SetInt(key_a, (int)(int64_t)(position - block_start));
+                SetFloat(value_a, value);
                 
-                min = data[max_pos];
-                min_pos = max_pos;
-            }
-            else if((!is_detecting_max) &&
-                    data[i] > min + this->delta)
-            {
-                minima_locations.push_back(min_pos);
-                
-                is_detecting_max = true;
-                
-                i = min_pos - 1;
-                
-                max = data[min_pos];
-                max_pos = min_pos;
+                locations.push_back(key_a);
+                locations.push_back(value_a);
             }
         }
+        
+        ToOutList(0, (int)minima.size(), &minima[0]);
+        ToOutList(0, (int)maxima.size(), &maxima[0]);
     }
     
-    void ml_minmax::populate_locations(
-                            const std::vector<double> &data,
-                            const std::vector<uint32_t> &locations,
-                            AtomList &atomList
-                            )
+    void ml_minmax::reset()
     {
-        for (uint32_t index = 0; index < locations.size(); ++index)
-        {
-            t_atom key_a;
-            t_atom value_a;
-            
-            uint32_t key = (double)locations[index];
-            double value = data[key];
-            
-            SetInt(key_a, key);
-            SetFloat(value_a, value);
-            
-            atomList.Append(key_a);
-            atomList.Append(value_a);
-        }
+        detector.reset();
+        block_start = 0;
     }
     
     const std::string ml_minmax::attribute_help = "delta: a float setting the minmax delta. Input values will be considered to be peaks if they are greater than the previous and next value by at least the delta value. (default: 1e-6)";
+    const std::string ml_minmax::method_help =
+    "list:\ta list of values is searched in one pass, outputting 'min' then 'max' followed by index value pairs; the search continues from the previous list, so an extremum in an earlier list that is confirmed by this one has a negative index\n"
+    "reset:\tforget the previous lists and start a new search\n";
     
     typedef class ml_minmax ml0x2eminmax;
     
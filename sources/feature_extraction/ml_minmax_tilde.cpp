@@ -0,0 +1,219 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ml_hop_dsp.h"
+#include "ml_minmax_detector.h"
+
+#include <vector>
+
+namespace ml
+{
+    static const std::string ml_object_name = "ml.minmax~";
+    static const t_symbol *s_min  = flext::MakeSymbol("min");
+    static const t_symbol *s_max  = flext::MakeSymbol("max");
+    
+    struct minmax_tilde_state : ml_hop_state
+    {
+        minmax_tilde_state()
+        :
+        last_extremum_value(0.0)
+        {}
+        
+        ml_minmax_detector detector;
+        double last_extremum_value;
+        
+        // "min" / "max" followed by the index / value pairs found in the current hop, reserved when the state is built
+        // so m_signal never grows them
+        std::vector<t_atom> minima;
+        std::vector<t_atom> maxima;
+    };
+    
+    class ml_minmax_tilde : ml_hop_dsp<minmax_tilde_state>
+    {
+        FLEXT_HEADER_S(ml_minmax_tilde, ml_hop_dsp<minmax_tilde_state>, setup);
+    
+    public:
+        ml_minmax_tilde()
+        :
+        delta(k_minmax_default_delta)
+        {
+            post("Peak / valley detection for signals based on Eli Billauer's peakdet");
+            
+            AddInSignal();
+            AddOutSignal();
+            AddOutSignal();
+            AddOutList();
+            
+            append_help(attribute_help, method_help);
+            
+            reset();
+        }
+    
+    protected:
+        static void setup(t_classid c)
+        {
+            // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "delta", set_delta);
+            
+            // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "delta", get_delta);
+            
+            DefineHelp(c, ml_object_name.c_str());
+        }
+        
+        virtual void m_signal(int n, t_sample *const *insigs, t_sample *const *outsigs);
+        
+        // Flext attribute setters
+        void set_delta(float delta);
+        
+        // Flext attribute getters
+        void get_delta(float &delta) const;
+    
+    private:
+        virtual void build_state(minmax_tilde_state &state) const;
+        static void clear_lists(minmax_tilde_state &state);
+        
+        // Flext attribute wrappers
+        FLEXT_CALLVAR_F(get_delta, set_delta);
+        
+        // Virtual method override
+        virtual const std::string get_object_name(void) const { return ml_object_name; };
+        
+        double delta;
+        
+        static const std::string attribute_help;
+        static const std::string method_help;
+    };
+    
+    void ml_minmax_tilde::m_signal(int n, t_sample *const *insigs, t_sample *const *outsigs)
+    {
+        minmax_tilde_state &state = acquire_state();
+        const t_sample *input = insigs[0];
+        t_sample *extremum = outsigs[0];
+        t_sample *extremum_value_output = outsigs[1];
+        
+        bool is_maximum = false;
+        uint64_t position = 0;
+        double value = 0.0;
+        
+        for (int index = 0; index < n; ++index)
+        {
+            // The input is read before the outputs are written, as they may share a vector
+            const bool found = state.detector.update(input[index], is_maximum, position, value);
+            t_sample direction = 0;
+            
+            if (found)
+            {
+                direction = is_maximum ? 1 : -1;
+                state.last_extremum_value = value;
+                
+                std::vector<t_atom> &locations = is_maximum ? state.maxima : state.minima;
+                
+                if (state.hop > 0 && locations.size() + 2 <= locations.capacity())
+                {
+                    t_atom key_a;
+                    t_atom value_a;
+                    
+                    // Negative for an extremum in the previous hop that is only confirmed in this one
+                    SetInt(key_a, state.get_hop_index(position));
+                    SetFloat(value_a, value);
+                    
+                    locations.push_back(key_a);
+                    locations.push_back(value_a);
+                }
+            }
+            
+            extremum[index] = direction;
+            extremum_value_output[index] = (t_sample)state.last_extremum_value;
+            
+            if (state.end_of_hop())
+            {
+                if (state.minima.size() > 1 || state.maxima.size() > 1)
+                {
+                    ToQueueList(2, (int)state.minima.size(), &state.minima[0]);
+                    ToQueueList(2, (int)state.maxima.size(), &state.maxima[0]);
+                }
+                clear_lists(state);
+                state.interval_start = state.detector.get_position();
+            }
+        }
+    }
+    
+    void ml_minmax_tilde::build_state(minmax_tilde_state &state) const
+    {
+        // Each sample confirms at most one extremum and minima and maxima alternate, plus one carried over from the
+        // previous hop
+        const uint32_t pairs = state.hop / 2 + 2;
+        
+        state.detector.set_delta(delta);
+        state.detector.reset();
+        state.last_extremum_value = 0.0;
+        state.minima.reserve(1 + 2 * pairs);
+        state.maxima.reserve(1 + 2 * pairs);
+        clear_lists(state);
+    }
+    
+    void ml_minmax_tilde::clear_lists(minmax_tilde_state &state)
+    {
+        t_atom min_a;
+        t_atom max_a;
+        
+        SetSymbol(min_a, s_min);
+        SetSymbol(max_a, s_max);
+        
+        state.minima.clear();
+        state.maxima.clear();
+        state.minima.push_back(min_a);
+        state.maxima.push_back(max_a);
+    }
+    
+    // Flext attribute setters
+    void ml_minmax_tilde::set_delta(float delta)
+    {
+        if (delta <= 0)
+        {
+            error("unable to set delta, hint: should be greater than 0");
+            return;
+        }
+        
+        this->delta = delta;
+        reset();
+    }
+    
+    // Flext attribute getters
+    void ml_minmax_tilde::get_delta(float &delta) const
+    {
+        delta = this->delta;
+    }
+    
+    const std::string ml_minmax_tilde::attribute_help =
+    "delta:\tfloating point value (> 0), how far the signal must move back from a maximum or minimum for it to be detected (default 1e-6)\n"
+    "hop:\tinteger setting how often, in samples, the extrema found since the last output are also output from the right outlet as a list of minima index / value pairs prefixed by 'min' and a list of maxima prefixed by 'max', indices counting from the start of the hop, 0 for signal output only (default 0)\n";
+    const std::string ml_minmax_tilde::method_help =
+    "signal:\tthe left outlet outputs 1 for the sample confirming a maximum, -1 for one confirming a minimum and 0 otherwise, the middle outlet outputs the value of the last extremum\n";
+    
+    typedef class ml_minmax_tilde ml0x2eminmax_tilde;
+    
+#ifdef BUILD_AS_LIBRARY
+    FLEXT_LIB_DSP(ml_object_name.c_str(), ml_minmax_tilde);
+#else
+    FLEXT_NEW_DSP(ml_object_name.c_str(), ml0x2eminmax_tilde);
+#endif
+    
+} //namespace ml
+
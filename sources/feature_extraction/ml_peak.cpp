@@ -17,6 +17,7 @@
  */
 
 #include "ml_base.h"
+#include "ml_peak_detector.h"
 
 #include "GRT.h"
 
@@ -24,12 +25,17 @@ namespace ml
 {
     const std::string ml_object_name = "ml.peak";
     
+    // Number of peaks per list the output is sized for up front
+    const uint32_t k_peak_list_reserve = 256;
+    
     class ml_peak : ml_base
     {
         FLEXT_HEADER_S(ml_peak, ml_base, setup);
         
     public:
         ml_peak()
+        :
+        block_start(0)
         {
             post("Peak Detection based on the GRT library version " + GRT::GRTBase::getGRTRevison());
             FLEXT_ADDMETHOD(0, update);
@@ -37,6 +43,8 @@ namespace ml
             
             help.append_attributes(attribute_help);
             help.append_attributes(method_help);
+            
+            peak_list.reserve(2 * k_peak_list_reserve);
         }
         
     protected:
@@ -45,6 +53,8 @@ namespace ml
             FLEXT_CADDATTR_SET(c, "search_window_size", set_search_window_size);
 //            FLEXT_CADDATTR_SET(c, "low_pass_filter_size", set_low_pass_filter_size);
             
+            FLEXT_CADDATTR_GET(c, "search_window_size", get_search_window_size);
+            
             FLEXT_CADDMETHOD_(c, 0, "reset", reset);
             FLEXT_CADDMETHOD_(c, 0, "timeout", timeout);
 //            FLEXT_CADDMETHOD_(c, 0, "peaks", peaks);
@@ -62,9 +72,9 @@ namespace ml
         // Flext attribute setters
 //        void set_low_pass_filter_size(int low_pass_filter_size);
         void set_search_window_size(int search_window_size);
-
         
         // Flext attribute getters
+        void get_search_window_size(int &search_window_size) const;
         
     private:
         
@@ -76,13 +86,20 @@ namespace ml
         
         // Flext attribute wrappers
 //        FLEXT_CALLSET_I(set_low_pass_filter_size);
-        FLEXT_CALLSET_I(set_search_window_size);
+        FLEXT_CALLVAR_I(get_search_window_size, set_search_window_size);
 
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
         GRT::PeakDetection peakDetection;
         
+        // List input is searched by our own detector, whose state carries over from one list to the next
+        ml_peak_detector peak_detector;
+        uint64_t block_start;
+        std::vector<t_atom> peak_list;
+        
+        void append_peak(int64_t index, double value);
+        
         static const std::string attribute_help;
         static const std::string method_help;
 
@@ -101,63 +118,56 @@ namespace ml
     
     void ml_peak::set_search_window_size(int search_window_size)
     {
-        bool success = peakDetection.setSearchWindowSize(search_window_size);
+        bool success = search_window_size > 0 && peakDetection.setSearchWindowSize(search_window_size) && peak_detector.set_search_window_size(search_window_size);
 
         if (!success)
         {
             error("unable to set search window size");
         }
     }
-
     
     // Flext attribute getters
+    void ml_peak::get_search_window_size(int &search_window_size) const
+    {
+        search_window_size = peak_detector.get_search_window_size();
+    }
     
     // Methods
     void ml_peak::peaks(int argc, t_atom *argv)
     {
-        AtomList peaks;
-        bool peakFound = false;
-        
-        
-        // TODO: update this when we the GRT code is complete
-        error("peak detection currently not fully implemented in GRT");
-        return;
+        uint64_t peak_position = 0;
+        double peak_value = 0.0;
         
+        peak_list.clear();
+        block_start = peak_detector.get_position();
         
         for (uint32_t index = 0; index < (unsigned)argc; ++index)
         {
-            float value = GetAFloat(argv[index]);
-        
-            peakFound = peakDetection.update(value);
-
-            if (peakFound)
+            if (peak_detector.update(GetAFloat(argv[index]), peak_position, peak_value))
             {
-                t_atom location_a;
-                t_atom value_a;
-                
-                uint32_t rel_index = 0; // peakDetection.getPeakLocation();
-                uint32_t abs_index = index - rel_index;
-                
-                if (rel_index > index)
-                {
-                    error("peak reported is in previous block");
-                    continue;
-                }
-                
-                SetInt(location_a, abs_index);
-                SetFloat(value_a, GetAFloat(argv[abs_index]));
-                
-                peaks.Append(location_a);
-                peaks.Append(value_a);
+                // Negative for a peak near the end of the previous list that is only confirmed by this one
+                append_peak((int64_t)(peak_position - block_start), peak_value);
             }
         }
         
-        if (peakFound)
+        if (!peak_list.empty())
         {
-            ToOutList(0, peaks);
+            ToOutList(0, (int)peak_list.size(), &peak_list[0]);
         }
     }
     
+    void ml_peak::append_peak(int64_t index, double value)
+    {
+        t_atom location_a;
+        t_atom value_a;
+        
+        SetInt(location_a, (int)index);
+        SetFloat(value_a, value);
+        
+        peak_list.push_back(location_a);
+        peak_list.push_back(value_a);
+    }
+    
     void ml_peak::update(float f)
     {
         // TODO: update this when we the GRT code is complete
@@ -178,6 +188,9 @@ namespace ml
     
     void ml_peak::reset()
     {
+        peak_detector.reset();
+        block_start = 0;
+        
         bool success = peakDetection.reset();
         
         if (!success)
@@ -188,25 +201,25 @@ namespace ml
     
     void ml_peak::timeout()
     {
-        // TODO: update this when we the GRT code is complete
-        error("peak detection currently not fully implemented in GRT");
-        return;
-
+        uint64_t peak_position = 0;
+        double peak_value = 0.0;
         
-        bool success = true;// peakDetection.triggerGateTimeout();
+        peak_list.clear();
         
-        if (!success)
+        if (peak_detector.flush(peak_position, peak_value))
         {
-            error("unable to trigger gate timeout");
+            append_peak((int64_t)(peak_position - block_start), peak_value);
+            ToOutList(0, (int)peak_list.size(), &peak_list[0]);
         }
     }
-
+    
     const std::string ml_peak::attribute_help =
-    "search_window_size: an integer setting the search window size in values (default: 5)\n";
+    "search_window_size: an integer setting the search window size in values, a value in a list is a peak if it is greater than this many values before it and no less than this many values after it (default: 5)\n";
     const std::string ml_peak::method_help =
     "float:\ta floating point value to the inlet updates the current value of the peak detector\n"
+    "list:\ta list of values is searched for peaks in one pass, outputting a list of index value pairs for the peaks found; the search continues from the previous list, so a peak at the end of one list may be output with a negative index by the next\n"
     "reset:\treset the peak detector\n"
-    "timeout:\t (see GRT documentation)\n"
+    "timeout:\tend the current run of list input, outputting any peak still waiting for later values with its index in the last list\n"
     "help:\tpost this usage statement to the console\n";
     
     typedef class ml_peak ml0x2epeak;
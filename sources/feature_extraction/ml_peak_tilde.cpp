@@ -0,0 +1,191 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ml_hop_dsp.h"
+#include "ml_peak_detector.h"
+
+#include <vector>
+
+namespace ml
+{
+    static const std::string ml_object_name = "ml.peak~";
+    
+    struct peak_tilde_state : ml_hop_state
+    {
+        peak_tilde_state()
+        :
+        last_peak_value(0.0)
+        {}
+        
+        ml_peak_detector peak_detector;
+        double last_peak_value;
+        
+        // Index / value pairs of the peaks found in the current hop, reserved when the state is built so m_signal
+        // never grows it
+        std::vector<t_atom> peak_list;
+    };
+    
+    class ml_peak_tilde : ml_hop_dsp<peak_tilde_state>
+    {
+        FLEXT_HEADER_S(ml_peak_tilde, ml_hop_dsp<peak_tilde_state>, setup);
+    
+    public:
+        ml_peak_tilde()
+        :
+        search_window_size(k_peak_default_search_window_size)
+        {
+            post("Peak detection for signals");
+            
+            AddInSignal();
+            AddOutSignal();
+            AddOutSignal();
+            AddOutList();
+            
+            append_help(attribute_help, method_help);
+            
+            reset();
+        }
+    
+    protected:
+        static void setup(t_classid c)
+        {
+            // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "search_window_size", set_search_window_size);
+            
+            // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "search_window_size", get_search_window_size);
+            
+            DefineHelp(c, ml_object_name.c_str());
+        }
+        
+        virtual void m_signal(int n, t_sample *const *insigs, t_sample *const *outsigs);
+        
+        // Flext attribute setters
+        void set_search_window_size(int search_window_size);
+        
+        // Flext attribute getters
+        void get_search_window_size(int &search_window_size) const;
+    
+    private:
+        virtual void build_state(peak_tilde_state &state) const;
+        
+        // Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_search_window_size, set_search_window_size);
+        
+        // Virtual method override
+        virtual const std::string get_object_name(void) const { return ml_object_name; };
+        
+        uint32_t search_window_size;
+        
+        static const std::string attribute_help;
+        static const std::string method_help;
+    };
+    
+    void ml_peak_tilde::m_signal(int n, t_sample *const *insigs, t_sample *const *outsigs)
+    {
+        peak_tilde_state &state = acquire_state();
+        const t_sample *input = insigs[0];
+        t_sample *trigger = outsigs[0];
+        t_sample *peak_value_output = outsigs[1];
+        
+        uint64_t peak_position = 0;
+        double peak_value = 0.0;
+        
+        for (int index = 0; index < n; ++index)
+        {
+            // The input is read before the outputs are written, as they may share a vector
+            const bool found = state.peak_detector.update(input[index], peak_position, peak_value);
+            
+            if (found)
+            {
+                state.last_peak_value = peak_value;
+                
+                if (state.hop > 0 && state.peak_list.size() + 2 <= state.peak_list.capacity())
+                {
+                    t_atom location_a;
+                    t_atom value_a;
+                    
+                    // Negative for a peak in the previous hop that is only confirmed in this one
+                    SetInt(location_a, state.get_hop_index(peak_position));
+                    SetFloat(value_a, peak_value);
+                    
+                    state.peak_list.push_back(location_a);
+                    state.peak_list.push_back(value_a);
+                }
+            }
+            
+            trigger[index] = found ? 1 : 0;
+            peak_value_output[index] = (t_sample)state.last_peak_value;
+            
+            if (state.end_of_hop())
+            {
+                if (!state.peak_list.empty())
+                {
+                    ToQueueList(2, (int)state.peak_list.size(), &state.peak_list[0]);
+                }
+                state.peak_list.clear();
+                state.interval_start = state.peak_detector.get_position();
+            }
+        }
+    }
+    
+    void ml_peak_tilde::build_state(peak_tilde_state &state) const
+    {
+        state.peak_detector.set_search_window_size(search_window_size);
+        state.last_peak_value = 0.0;
+        
+        // Peaks are more than search_window_size samples apart, and one may be carried over from the previous hop
+        state.peak_list.clear();
+        state.peak_list.reserve(2 * (state.hop / (search_window_size + 1) + 2));
+    }
+    
+    // Flext attribute setters
+    void ml_peak_tilde::set_search_window_size(int search_window_size)
+    {
+        if (search_window_size <= 0)
+        {
+            error("unable to set search_window_size, hint: should be greater than 0");
+            return;
+        }
+        
+        this->search_window_size = search_window_size;
+        reset();
+    }
+    
+    // Flext attribute getters
+    void ml_peak_tilde::get_search_window_size(int &search_window_size) const
+    {
+        search_window_size = this->search_window_size;
+    }
+    
+    const std::string ml_peak_tilde::attribute_help =
+    "search_window_size:\tinteger setting the number of samples either side of a peak it must not be exceeded by (default " + std::to_string(k_peak_default_search_window_size) + ")\n"
+    "hop:\tinteger setting how often, in samples, the peaks found since the last output are also output as a list of index / value pairs from the right outlet, indices counting from the start of the hop, 0 for signal output only (default 0)\n";
+    const std::string ml_peak_tilde::method_help =
+    "signal:\tthe left outlet outputs 1 for the sample confirming a peak, search_window_size samples after it, and 0 otherwise, the middle outlet outputs the value of the last peak\n";
+    
+    typedef class ml_peak_tilde ml0x2epeak_tilde;
+    
+#ifdef BUILD_AS_LIBRARY
+    FLEXT_LIB_DSP(ml_object_name.c_str(), ml_peak_tilde);
+#else
+    FLEXT_NEW_DSP(ml_object_name.c_str(), ml0x2epeak_tilde);
+#endif
+    
+} //namespace ml
+
@@ -0,0 +1,171 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ml_hop_dsp.h"
+#include "ml_zerox_counter.h"
+
+namespace ml
+{
+    static const std::string ml_object_name = "ml.zerox~";
+    
+    struct zerox_tilde_state : ml_hop_state
+    {
+        ml_zerox_counter counter;
+    };
+    
+    class ml_zerox_tilde : ml_hop_dsp<zerox_tilde_state>
+    {
+        FLEXT_HEADER_S(ml_zerox_tilde, ml_hop_dsp<zerox_tilde_state>, setup);
+    
+    public:
+        ml_zerox_tilde()
+        :
+        search_window_size(k_zerox_default_search_window_size),
+        dead_zone_threshold(0.0)
+        {
+            post("Zero crossing counter for signals");
+            
+            AddInSignal();
+            AddOutSignal();
+            AddOutFloat();
+            
+            append_help(attribute_help, method_help);
+            
+            reset();
+        }
+    
+    protected:
+        static void setup(t_classid c)
+        {
+            // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "search_window_size", set_search_window_size);
+            FLEXT_CADDATTR_SET(c, "dead_zone_threshold", set_dead_zone_threshold);
+            
+            // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "search_window_size", get_search_window_size);
+            FLEXT_CADDATTR_GET(c, "dead_zone_threshold", get_dead_zone_threshold);
+            
+            DefineHelp(c, ml_object_name.c_str());
+        }
+        
+        virtual void m_signal(int n, t_sample *const *insigs, t_sample *const *outsigs);
+        
+        // Flext attribute setters
+        void set_search_window_size(int search_window_size);
+        void set_dead_zone_threshold(float dead_zone_threshold);
+        
+        // Flext attribute getters
+        void get_search_window_size(int &search_window_size) const;
+        void get_dead_zone_threshold(float &dead_zone_threshold) const;
+    
+    private:
+        virtual void build_state(zerox_tilde_state &state) const;
+        
+        // Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_search_window_size, set_search_window_size);
+        FLEXT_CALLVAR_F(get_dead_zone_threshold, set_dead_zone_threshold);
+        
+        // Virtual method override
+        virtual const std::string get_object_name(void) const { return ml_object_name; };
+        
+        uint32_t search_window_size;
+        double dead_zone_threshold;
+        
+        static const std::string attribute_help;
+        static const std::string method_help;
+    };
+    
+    void ml_zerox_tilde::m_signal(int n, t_sample *const *insigs, t_sample *const *outsigs)
+    {
+        zerox_tilde_state &state = acquire_state();
+        const t_sample *input = insigs[0];
+        t_sample *output = outsigs[0];
+        
+        for (int index = 0; index < n; ++index)
+        {
+            // The input is read before the output is written, as they may share a vector
+            const uint32_t count = state.counter.update(input[index]);
+            
+            output[index] = (t_sample)count;
+            
+            if (state.end_of_hop())
+            {
+                ToQueueFloat(1, (float)count);
+            }
+        }
+    }
+    
+    void ml_zerox_tilde::build_state(zerox_tilde_state &state) const
+    {
+        state.counter.set_search_window_size(search_window_size);
+        state.counter.set_dead_zone_threshold(dead_zone_threshold);
+    }
+    
+    // Flext attribute setters
+    void ml_zerox_tilde::set_search_window_size(int search_window_size)
+    {
+        if (search_window_size <= 0)
+        {
+            error("unable to set search_window_size, hint: should be greater than 0");
+            return;
+        }
+        
+        this->search_window_size = search_window_size;
+        reset();
+    }
+    
+    void ml_zerox_tilde::set_dead_zone_threshold(float dead_zone_threshold)
+    {
+        if (dead_zone_threshold < 0)
+        {
+            error("unable to set dead_zone_threshold, hint: should be 0 or greater");
+            return;
+        }
+        
+        this->dead_zone_threshold = dead_zone_threshold;
+        reset();
+    }
+    
+    // Flext attribute getters
+    void ml_zerox_tilde::get_search_window_size(int &search_window_size) const
+    {
+        search_window_size = this->search_window_size;
+    }
+    
+    void ml_zerox_tilde::get_dead_zone_threshold(float &dead_zone_threshold) const
+    {
+        dead_zone_threshold = this->dead_zone_threshold;
+    }
+    
+    const std::string ml_zerox_tilde::attribute_help =
+    "search_window_size:\tinteger setting the number of samples over which zero crossings are counted (default " + std::to_string(k_zerox_default_search_window_size) + ")\n"
+    "dead_zone_threshold:\tfloating point value (>= 0), the signal must pass from above it to below its negative, or back, for a crossing to count (default 0)\n"
+    "hop:\tinteger setting how often, in samples, the current count is also output as a float from the right outlet, 0 for signal output only (default 0)\n";
+    const std::string ml_zerox_tilde::method_help =
+    "signal:\tthe left outlet outputs the number of zero crossings in the last search_window_size samples of the input, for every sample\n";
+    
+    typedef class ml_zerox_tilde ml0x2ezerox_tilde;
+    
+#ifdef BUILD_AS_LIBRARY
+    FLEXT_LIB_DSP(ml_object_name.c_str(), ml_zerox_tilde);
+#else
+    FLEXT_NEW_DSP(ml_object_name.c_str(), ml0x2ezerox_tilde);
+#endif
+    
+} //namespace ml
+
@@ -27,6 +27,7 @@ namespace ml
 {
     // Utility function declarations
     void post_prefixed_message(const std::string object_name, const std::string &message, void(*post_function)(const char *,...));
+    void post_prefixed_lines(const std::string object_name, const std::string &message);
 
     // ml_help implementation
     std::string ml_help::full_message(void) const
@@ -49,13 +50,7 @@ namespace ml
     // ml_base implementation
     void ml_base::post(const std::string &message) const
     {
-        std::stringstream message_lines(message);
-        std::string line;
-        
-        while(std::getline(message_lines, line, '\n'))
-        {
-            post_prefixed_message(get_object_name(), line, flext::post);
-        }
+        post_prefixed_lines(get_object_name(), message);
     }
     
     void ml_base::error(const std::string &message) const
@@ -63,10 +58,32 @@ namespace ml
         post_prefixed_message(get_object_name(), message, flext::error);
     }
     
+    // ml_base_dsp implementation
+    void ml_base_dsp::post(const std::string &message) const
+    {
+        post_prefixed_lines(get_object_name(), message);
+    }
+    
+    void ml_base_dsp::error(const std::string &message) const
+    {
+        post_prefixed_message(get_object_name(), message, flext::error);
+    }
+    
     // Utility function definitions
     void post_prefixed_message(const std::string object_name, const std::string &message, void(*post_function)(const char *,...))
     {
         std::string full_message = object_name + ML_POST_SEPARATOR + message;
         post_function(full_message.c_str());
     }
+    
+    void post_prefixed_lines(const std::string object_name, const std::string &message)
+    {
+        std::stringstream message_lines(message);
+        std::string line;
+        
+        while(std::getline(message_lines, line, '\n'))
+        {
+            post_prefixed_message(object_name, line, flext::post);
+        }
+    }
 }
\ No newline at end of file
@@ -56,6 +56,21 @@ namespace ml
     private:
         virtual const std::string get_object_name(void) const = 0;
     };
+    
+    // As ml_base, for objects that process signals
+    class ml_base_dsp:
+    public flext_dsp
+    {
+    public:
+        void post(const std::string &message) const;
+        void error(const std::string &message) const;
+        
+    protected:
+        ml_help help;
+        
+    private:
+        virtual const std::string get_object_name(void) const = 0;
+    };
 }
 
 #endif
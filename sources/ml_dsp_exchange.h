@@ -0,0 +1,88 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ml_ml_dsp_exchange_h
+#define ml_ml_dsp_exchange_h
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace ml
+{
+    // Hands the state a signal object's m_signal works on from the threads that set its attributes to the audio thread.
+    // There are two instances of the state: the one the audio thread is using and a spare. update() rebuilds the spare
+    // on the calling thread, where it may allocate, and publishes it. acquire(), called by the audio thread at the start
+    // of each block, picks up the published state and gives its previous one back as the spare, only exchanging
+    // pointers, so the audio thread never allocates, frees or waits. Calls to update() are serialised with a mutex
+    // that the audio thread never takes
+    template <typename state_type>
+    class ml_dsp_exchange
+    {
+    public:
+        ml_dsp_exchange()
+        :
+        current(&instances[0]),
+        pending(NULL),
+        spare(&instances[1])
+        {}
+
+        // Audio thread only
+        state_type &acquire()
+        {
+            state_type *next = pending.exchange(NULL);
+
+            if (next != NULL)
+            {
+                spare.store(current);
+                current = next;
+            }
+
+            return *current;
+        }
+
+        // Calls build(state) on a state the audio thread is not using, for it to use from its next block
+        template <typename build_type>
+        void update(build_type build)
+        {
+            std::lock_guard<std::mutex> lock(update_mutex);
+
+            // A state published but not yet picked up is rebuilt in place, otherwise the spare is used once the audio
+            // thread, which may be in the middle of acquire(), has given it back
+            state_type *next = pending.exchange(NULL);
+
+            while (next == NULL && (next = spare.exchange(NULL)) == NULL)
+            {
+                std::this_thread::yield();
+            }
+
+            build(*next);
+            pending.store(next);
+        }
+
+    private:
+        state_type instances[2];
+        state_type *current;
+        std::atomic<state_type *> pending;
+        std::atomic<state_type *> spare;
+        std::mutex update_mutex;
+    };
+}
+
+#endif
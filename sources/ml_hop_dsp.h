@@ -0,0 +1,153 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ml_ml_hop_dsp_h
+#define ml_ml_hop_dsp_h
+
+#include "ml_base.h"
+#include "ml_dsp_exchange.h"
+
+#include <stdint.h>
+
+namespace ml
+{
+    // Hop bookkeeping the state of an ml_hop_dsp starts from, the state types add what their detector needs
+    struct ml_hop_state
+    {
+        ml_hop_state()
+        :
+        hop(0),
+        hop_counter(0),
+        interval_start(0)
+        {}
+
+        // Counts a sample, returning true when it completes a hop. Never true when hop is 0
+        bool end_of_hop()
+        {
+            if (hop == 0 || ++hop_counter < hop)
+            {
+                return false;
+            }
+            hop_counter = 0;
+            return true;
+        }
+
+        // Index of a detector position counting from the start of the current hop, negative for one in an earlier hop
+        int get_hop_index(uint64_t position) const
+        {
+            return (int)((int64_t)(position - interval_start));
+        }
+
+        // Control output every hop samples, 0 for none
+        uint32_t hop;
+        uint32_t hop_counter;
+
+        // Detector position of the first sample of the current hop
+        uint64_t interval_start;
+    };
+
+    // Base for signal objects that, besides their signal output, output what they found every hop samples from the
+    // audio thread. It holds the hop attribute and the reset method, and hands the state m_signal works on over
+    // through an ml_dsp_exchange: reset(), which every attribute setter calls, rebuilds a state off the audio thread
+    // with its hop bookkeeping restarted and build_state() filling in the rest, and m_signal picks it up with
+    // acquire_state() at the start of its next block. Derived constructors call reset() once their attributes are set
+    template <typename state_type>
+    class ml_hop_dsp : public ml_base_dsp
+    {
+        FLEXT_HEADER_TS(ml_hop_dsp, ml_base_dsp, setup);
+
+    public:
+        ml_hop_dsp()
+        :
+        hop(0)
+        {}
+
+    protected:
+        static void setup(t_classid c)
+        {
+            FLEXT_CADDATTR_SET(c, "hop", set_hop);
+            FLEXT_CADDATTR_GET(c, "hop", get_hop);
+
+            FLEXT_CADDMETHOD_(c, 0, "reset", reset);
+        }
+
+        // Methods
+        void reset()
+        {
+            state_exchange.update([this](state_type &state)
+            {
+                state.hop = hop;
+                state.hop_counter = 0;
+                state.interval_start = 0;
+                build_state(state);
+            });
+        }
+
+        // Flext attribute setters
+        void set_hop(int hop)
+        {
+            if (hop < 0)
+            {
+                error("unable to set hop, hint: should be 0 or greater");
+                return;
+            }
+
+            this->hop = hop;
+            reset();
+        }
+
+        // Flext attribute getters
+        void get_hop(int &hop) const
+        {
+            hop = this->hop;
+        }
+
+        // Appends an object's help followed by the lines every ml_hop_dsp shares, its own help describing hop
+        void append_help(const std::string &attribute_help, const std::string &method_help)
+        {
+            help.append_attributes(attribute_help);
+            help.append_attributes("setting an attribute forgets the samples seen so far, from the next signal block\n");
+            help.append_methods(method_help);
+            help.append_methods("reset:\tforget the samples seen so far, from the next signal block\n");
+        }
+
+        // Audio thread only
+        state_type &acquire_state()
+        {
+            return state_exchange.acquire();
+        }
+
+    private:
+        // Sets up a state for the current attribute values, its hop bookkeeping already restarted
+        virtual void build_state(state_type &state) const = 0;
+
+        // Flext method wrappers
+        FLEXT_CALLBACK(reset);
+
+        // Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_hop, set_hop);
+
+        // Attribute value, only used outside the audio thread
+        uint32_t hop;
+
+        ml_dsp_exchange<state_type> state_exchange;
+    };
+}
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef ml_ml_linalg_h
+#define ml_ml_linalg_h
+
+#include "GRT.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace ml
+{
+    // Factorises the symmetric positive definite N x N row-major matrix a into L L^T, leaving L in the lower triangle and
+    // zeroing the upper one. Only the lower triangle of a is read. Returns false if a is not positive definite
+    inline bool cholesky_decompose(std::vector<double> &a, GRT::UINT N)
+    {
+        for (GRT::UINT j = 0; j < N; ++j)
+        {
+            double *row_j = &a[j * N];
+            double diagonal = row_j[j];
+            
+            for (GRT::UINT k = 0; k < j; ++k)
+            {
+                diagonal -= row_j[k] * row_j[k];
+            }
+            
+            if (!(diagonal > 0.0))
+            {
+                return false;
+            }
+            
+            row_j[j] = sqrt(diagonal);
+            
+            for (GRT::UINT i = j + 1; i < N; ++i)
+            {
+                double *row_i = &a[i * N];
+                double value = row_i[j];
+                
+                for (GRT::UINT k = 0; k < j; ++k)
+                {
+                    value -= row_i[k] * row_j[k];
+                }
+                
+                row_i[j] = value / row_j[j];
+            }
+            
+            std::fill(row_j + j + 1, row_j + N, 0.0);
+        }
+        
+        return true;
+    }
+    
+    // Overwrites b with the solution x of L L^T x = b, for L from cholesky_decompose()
+    inline void cholesky_solve(const std::vector<double> &L, std::vector<double> &b, GRT::UINT N)
+    {
+        for (GRT::UINT i = 0; i < N; ++i)
+        {
+            const double *row_i = &L[i * N];
+            double value = b[i];
+            
+            for (GRT::UINT k = 0; k < i; ++k)
+            {
+                value -= row_i[k] * b[k];
+            }
+            
+            b[i] = value / row_i[i];
+        }
+        
+        for (GRT::UINT i = N; i-- > 0;)
+        {
+            double value = b[i];
+            
+            for (GRT::UINT k = i + 1; k < N; ++k)
+            {
+                value -= L[k * N + i] * b[k];
+            }
+            
+            b[i] = value / L[i * N + i];
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ml_ml_minmax_detector_h
+#define ml_ml_minmax_detector_h
+
+#include <limits>
+
+#include <stdint.h>
+
+namespace ml
+{
+    const double k_minmax_default_delta = 1e-6;
+
+    // Streaming peak / valley detector after Eli Billauer's peakdet. Once the values have risen more than delta above
+    // the lowest value since the last maximum, that lowest value is a minimum, and once they have fallen more than
+    // delta below the highest value since the last minimum, that highest value is a maximum, so minima and maxima
+    // alternate. Each value is looked at once, in O(1), and the detector keeps its state between calls, so a stream
+    // split into blocks gives the same extrema as one long block. Positions count the values processed since the last
+    // reset
+    class ml_minmax_detector
+    {
+    public:
+        ml_minmax_detector(double delta = k_minmax_default_delta)
+        :
+        delta(delta)
+        {
+            reset();
+        }
+
+        bool set_delta(double delta)
+        {
+            if (delta <= 0)
+            {
+                return false;
+            }
+            this->delta = delta;
+            return true;
+        }
+
+        double get_delta() const { return delta; }
+        uint64_t get_position() const { return position; }
+
+        void reset()
+        {
+            position = 0;
+            min = std::numeric_limits<double>::infinity();
+            max = -std::numeric_limits<double>::infinity();
+            min_position = 0;
+            max_position = 0;
+            detecting_max = false;
+        }
+
+        // Processes the value at the current position. Returns true when it confirms an extremum, setting whether it
+        // is a maximum, its position and its value
+        bool update(double value, bool &is_maximum, uint64_t &extremum_position, double &extremum_value)
+        {
+            bool found = false;
+
+            if (value > max)
+            {
+                max = value;
+                max_position = position;
+            }
+
+            if (value < min)
+            {
+                min = value;
+                min_position = position;
+            }
+
+            if (detecting_max)
+            {
+                if (value < max - delta)
+                {
+                    found = true;
+                    is_maximum = true;
+                    extremum_position = max_position;
+                    extremum_value = max;
+
+                    // Every value since the maximum is within delta of it, so this is the lowest since
+                    detecting_max = false;
+                    min = value;
+                    min_position = position;
+                }
+            }
+            else if (value > min + delta)
+            {
+                found = true;
+                is_maximum = false;
+                extremum_position = min_position;
+                extremum_value = min;
+
+                detecting_max = true;
+                max = value;
+                max_position = position;
+            }
+
+            ++position;
+
+            return found;
+        }
+
+    private:
+        double delta;
+        uint64_t position;
+
+        double min;
+        double max;
+        uint64_t min_position;
+        uint64_t max_position;
+        bool detecting_max;
+    };
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include "ml_ml.h"
 
 #include <string>
+#include <sstream>
 
 namespace ml
 {
@@ -369,6 +370,23 @@ namespace ml
         error("function not implemented");
     }
     
+    bool ml::get_training_summary(GRT::UINT, double, std::stringstream &) const
+    {
+        return false;
+    }
+    
+    void ml::post_training_summary(GRT::UINT num_samples, double seconds) const
+    {
+        std::stringstream summary;
+        
+        summary << "trained on " << num_samples << " samples in " << seconds << "s";
+        
+        if (get_training_summary(num_samples, seconds, summary))
+        {
+            post(summary.str());
+        }
+    }
+    
     void ml::map(int argc, const t_atom *argv)
     {
         error("function not implemented");
@@ -432,17 +450,21 @@ namespace ml
         FLEXT_SETUP(ml_mlp);
         FLEXT_SETUP(ml_linreg);
         FLEXT_SETUP(ml_logreg);
+        FLEXT_SETUP(ml_mdreg);
         FLEXT_SETUP(ml_peak);
         FLEXT_SETUP(ml_minmax);
         FLEXT_SETUP(ml_anbc);
         FLEXT_SETUP(ml_softmax);
         FLEXT_SETUP(ml_randforest);
         FLEXT_SETUP(ml_mindist);
-//        FLEXT_SETUP(ml_lda);
+        FLEXT_SETUP(ml_lda);
         FLEXT_SETUP(ml_knn);
         FLEXT_SETUP(ml_gmm);
         FLEXT_SETUP(ml_dtree);
         FLEXT_SETUP(ml_zerox);
+        FLEXT_SETUP(ml_zerox_tilde);
+        FLEXT_SETUP(ml_peak_tilde);
+        FLEXT_SETUP(ml_minmax_tilde);
     }
 #endif
     
@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <map>
+#include <sstream>
 
 #include <stdint.h>
 
@@ -59,6 +60,11 @@ namespace ml
         virtual void map(int argc, const t_atom *argv);
         virtual void usage() const;
         
+        // Appends details of the last training run to the sample count and time post_training_summary() posts. Objects
+        // that report training override it and return true, otherwise nothing is posted
+        virtual bool get_training_summary(GRT::UINT num_samples, double seconds, std::stringstream &summary) const;
+        void post_training_summary(GRT::UINT num_samples, double seconds) const;
+        
         void record(bool state);
         void any(const t_symbol *s, int argc, const t_atom *argv);
         
@@ -0,0 +1,135 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ml_ml_parallel_h
+#define ml_ml_parallel_h
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ml
+{
+    // Number of worker threads used for num_tasks independent tasks, never more than there are tasks or cores, nor
+    // more than max_workers unless it is 0
+    inline unsigned int get_num_workers(unsigned int num_tasks, unsigned int max_workers = 0)
+    {
+        unsigned int num_cores = std::thread::hardware_concurrency();
+
+        if (num_cores == 0)
+        {
+            num_cores = 1;
+        }
+
+        if (max_workers > 0)
+        {
+            num_cores = std::min(num_cores, max_workers);
+        }
+
+        return std::max(1u, std::min(num_tasks, num_cores));
+    }
+
+    // Calls task(index, worker) for every index in [0, num_tasks) using a pool of worker threads that take the next
+    // index as they become free. worker is in [0, get_num_workers(num_tasks, max_workers)) so callers can give each
+    // worker its own scratch space. Tasks that run parallel_for themselves should share the cores out through
+    // max_workers. Returns once every task has completed. Tasks must not call into flext or Max/Pd
+    template <typename task_type>
+    void parallel_for(unsigned int num_tasks, task_type task, unsigned int max_workers = 0)
+    {
+        const unsigned int num_workers = get_num_workers(num_tasks, max_workers);
+
+        if (num_workers <= 1)
+        {
+            for (unsigned int index = 0; index < num_tasks; ++index)
+            {
+                task(index, 0u);
+            }
+            return;
+        }
+
+        std::atomic<unsigned int> next_index(0);
+        std::vector<std::thread> workers;
+
+        workers.reserve(num_workers - 1);
+
+        auto worker_loop = [&](unsigned int worker)
+        {
+            for (unsigned int index = next_index++; index < num_tasks; index = next_index++)
+            {
+                task(index, worker);
+            }
+        };
+
+        for (unsigned int worker = 1; worker < num_workers; ++worker)
+        {
+            workers.push_back(std::thread(worker_loop, worker));
+        }
+
+        // The calling thread is worker 0
+        worker_loop(0);
+
+        for (unsigned int worker = 0; worker < workers.size(); ++worker)
+        {
+            workers[worker].join();
+        }
+    }
+
+    // Number of samples in each block of parallel_block_sum
+    const unsigned int k_parallel_block_size = 512;
+
+    inline unsigned int get_num_blocks(unsigned int num_samples)
+    {
+        return (num_samples + k_parallel_block_size - 1) / k_parallel_block_size;
+    }
+
+    // Sums num_values results over the samples [0, num_samples). The samples are split into blocks of
+    // k_parallel_block_size, which are the tasks given to parallel_for, and block_task(begin, end, partial, worker) adds
+    // the results of samples [begin, end) into partial, the block's num_values zeroed values in block_sums. The blocks
+    // are then added up in order, so sum does not depend on the number of workers. block_sums belongs to the caller so
+    // that repeated sums do not allocate
+    template <typename block_task_type>
+    void parallel_block_sum(unsigned int num_samples, unsigned int num_values, std::vector<double> &block_sums, std::vector<double> &sum, block_task_type block_task, unsigned int max_workers = 0)
+    {
+        const unsigned int num_blocks = get_num_blocks(num_samples);
+
+        block_sums.assign(num_blocks * num_values, 0.0);
+        sum.assign(num_values, 0.0);
+
+        parallel_for(num_blocks, [&](unsigned int block, unsigned int worker)
+        {
+            const unsigned int begin = block * k_parallel_block_size;
+            const unsigned int end = std::min(num_samples, begin + k_parallel_block_size);
+
+            block_task(begin, end, &block_sums[block * num_values], worker);
+        }, max_workers);
+
+        for (unsigned int block = 0; block < num_blocks; ++block)
+        {
+            const double *partial = &block_sums[block * num_values];
+
+            for (unsigned int index = 0; index < num_values; ++index)
+            {
+                sum[index] += partial[index];
+            }
+        }
+    }
+}
+
+#endif
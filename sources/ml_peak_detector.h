@@ -0,0 +1,172 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ml_ml_peak_detector_h
+#define ml_ml_peak_detector_h
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace ml
+{
+    const uint32_t k_peak_default_search_window_size = 5;
+
+    // Streaming peak detector. The value at a position is a peak if it is greater than each of the
+    // search_window_size values before it and no less than each of the search_window_size values after it, so the
+    // first value of a plateau is the peak. Values are processed one at a time in a single pass, in amortised O(1) per
+    // value, and the detector keeps its state between calls, so a stream split into blocks gives the same peaks as one
+    // long block, including peaks confirmed only by values in the next block. Positions count the values processed
+    // since the last reset. Memory is only allocated when the window size changes
+    class ml_peak_detector
+    {
+    public:
+        ml_peak_detector(uint32_t search_window_size = k_peak_default_search_window_size)
+        {
+            set_search_window_size(search_window_size);
+        }
+
+        bool set_search_window_size(uint32_t search_window_size)
+        {
+            if (search_window_size == 0)
+            {
+                return false;
+            }
+            this->search_window_size = search_window_size;
+            history.resize(search_window_size + 1);
+            reset();
+            return true;
+        }
+
+        uint32_t get_search_window_size() const { return search_window_size; }
+        uint64_t get_position() const { return position; }
+
+        void reset()
+        {
+            position = 0;
+            clear_history();
+        }
+
+        // Processes the value at the current position. Returns true when that value confirms the peak
+        // search_window_size positions earlier, setting its position and value
+        bool update(double value, uint64_t &peak_position, double &peak_value)
+        {
+            bool found = false;
+
+            if (has_candidate)
+            {
+                if (value > candidate_value)
+                {
+                    has_candidate = false;
+                }
+                else if (position - candidate_position == search_window_size)
+                {
+                    peak_position = candidate_position;
+                    peak_value = candidate_value;
+                    has_candidate = false;
+                    found = true;
+                }
+            }
+
+            // history holds the decreasing maxima of the last search_window_size values, the front being the largest
+            while (history_size > 0 && history[history_front].position + search_window_size < position)
+            {
+                pop_front();
+            }
+
+            if (!has_candidate && (history_size == 0 || value > history[history_front].value))
+            {
+                has_candidate = true;
+                candidate_position = position;
+                candidate_value = value;
+            }
+
+            while (history_size > 0 && history[back_index()].value <= value)
+            {
+                --history_size;
+            }
+
+            history_size++;
+            history[back_index()].position = position;
+            history[back_index()].value = value;
+
+            ++position;
+
+            return found;
+        }
+
+        // Ends the current run of values, as when the input times out: returns true if a peak was still waiting for
+        // search_window_size later values, setting its position and value, and forgets the values seen so far.
+        // Positions carry on counting
+        bool flush(uint64_t &peak_position, double &peak_value)
+        {
+            const bool found = has_candidate;
+
+            if (found)
+            {
+                peak_position = candidate_position;
+                peak_value = candidate_value;
+            }
+            clear_history();
+
+            return found;
+        }
+
+    private:
+        struct entry
+        {
+            uint64_t position;
+            double value;
+        };
+
+        void clear_history()
+        {
+            has_candidate = false;
+            candidate_position = 0;
+            candidate_value = 0.0;
+            history_front = 0;
+            history_size = 0;
+        }
+
+        uint32_t back_index() const
+        {
+            return (history_front + history_size - 1) % (uint32_t)history.size();
+        }
+
+        void pop_front()
+        {
+            history_front = (history_front + 1) % (uint32_t)history.size();
+            --history_size;
+        }
+
+        uint32_t search_window_size;
+        uint64_t position;
+
+        bool has_candidate;
+        uint64_t candidate_position;
+        double candidate_value;
+
+        // Ring buffer of search_window_size + 1 entries
+        std::vector<entry> history;
+        uint32_t history_front;
+        uint32_t history_size;
+    };
+}
+
+#endif
@@ -0,0 +1,644 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ml_ml_tree_h
+#define ml_ml_tree_h
+
+#include "GRT.h"
+#include "ml_parallel.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <stdint.h>
+
+namespace ml
+{
+    const GRT::UINT k_tree_max_bins = 256;
+    
+    // Labelled samples shared read-only by every tree being built. Inputs are stored row-major and labels as indices
+    // into the model's class labels, so trees are grown from index vectors rather than copies of the data. When binned,
+    // each feature is also quantised into at most k_tree_max_bins quantile bins stored column-major as uint8_t, so that
+    // split search needs one pass over a node's samples per feature
+    struct tree_dataset
+    {
+        tree_dataset() : num_samples(0), num_dimensions(0), num_classes(0) {}
+
+        // num_bins of 0 leaves the data unbinned
+        void assign(const GRT::ClassificationData &data, const std::vector<GRT::UINT> &class_labels, GRT::UINT num_bins)
+        {
+            num_samples = data.getNumSamples();
+            num_dimensions = data.getNumDimensions();
+            num_classes = (GRT::UINT)class_labels.size();
+            inputs.resize(num_samples * num_dimensions);
+            classes.resize(num_samples);
+
+            for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+            {
+                const GRT::VectorDouble &input = data[sample].getSample();
+                const GRT::UINT label = data[sample].getClassLabel();
+
+                std::copy(input.begin(), input.end(), inputs.begin() + sample * num_dimensions);
+                classes[sample] = (GRT::UINT)(std::find(class_labels.begin(), class_labels.end(), label) - class_labels.begin());
+            }
+
+            cuts.clear();
+            bins.clear();
+
+            if (num_bins == 0)
+            {
+                return;
+            }
+
+            cuts.resize(num_dimensions);
+            bins.resize(num_samples * num_dimensions);
+
+            parallel_for(num_dimensions, [&](unsigned int feature, unsigned int)
+            {
+                std::vector<double> values(num_samples);
+
+                for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+                {
+                    values[sample] = get_value(sample, feature);
+                }
+
+                get_cuts(values, std::min(num_bins, k_tree_max_bins), cuts[feature]);
+
+                const std::vector<double> &feature_cuts = cuts[feature];
+                uint8_t *feature_bins = &bins[feature * num_samples];
+
+                for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+                {
+                    feature_bins[sample] = (uint8_t)(std::upper_bound(feature_cuts.begin(), feature_cuts.end(), get_value(sample, feature)) - feature_cuts.begin());
+                }
+            });
+        }
+
+        bool is_binned() const
+        {
+            return !bins.empty();
+        }
+
+        double get_value(GRT::UINT sample, GRT::UINT dimension) const
+        {
+            return inputs[sample * num_dimensions + dimension];
+        }
+
+        // Bin of a value is the number of cuts at or below it, so value < cuts[feature][bin - 1] exactly when the
+        // value's bin is below bin and cuts double as GRT thresholds
+        GRT::UINT get_num_bins(GRT::UINT feature) const
+        {
+            return (GRT::UINT)cuts[feature].size() + 1;
+        }
+
+        const uint8_t *get_bins(GRT::UINT feature) const
+        {
+            return &bins[feature * num_samples];
+        }
+
+        GRT::UINT num_samples;
+        GRT::UINT num_dimensions;
+        GRT::UINT num_classes;
+        std::vector<double> inputs;
+        std::vector<GRT::UINT> classes;
+        std::vector< std::vector<double> > cuts;
+        std::vector<uint8_t> bins;
+
+    private:
+        // Places up to num_bins - 1 cuts at quantiles of values, halfway between neighbouring distinct values so that
+        // equal values always share a bin. values is sorted in place
+        static void get_cuts(std::vector<double> &values, GRT::UINT num_bins, std::vector<double> &cuts)
+        {
+            std::sort(values.begin(), values.end());
+            cuts.clear();
+
+            const size_t num_values = values.size();
+            size_t num_distinct = num_values > 0;
+
+            for (size_t value = 1; value < num_values; ++value)
+            {
+                num_distinct += values[value] != values[value - 1];
+            }
+
+            if (num_distinct <= num_bins)
+            {
+                for (size_t value = 1; value < num_values; ++value)
+                {
+                    if (values[value] != values[value - 1])
+                    {
+                        add_cut(values[value - 1], values[value], cuts);
+                    }
+                }
+                return;
+            }
+
+            for (GRT::UINT bin = 1; bin < num_bins; ++bin)
+            {
+                const size_t position = (size_t)((double)bin * num_values / num_bins);
+                const size_t first = std::lower_bound(values.begin(), values.end(), values[position]) - values.begin();
+
+                if (first > 0)
+                {
+                    add_cut(values[first - 1], values[first], cuts);
+                }
+            }
+        }
+
+        static void add_cut(double lower, double upper, std::vector<double> &cuts)
+        {
+            double cut = 0.5 * (lower + upper);
+
+            // Adjacent doubles can round the midpoint down onto lower
+            if (cut <= lower)
+            {
+                cut = upper;
+            }
+
+            if (cuts.empty() || cut > cuts.back())
+            {
+                cuts.push_back(cut);
+            }
+        }
+    };
+
+    struct tree_settings
+    {
+        GRT::UINT num_random_splits;
+        GRT::UINT min_samples_per_node;
+        GRT::UINT max_depth;
+        bool remove_features_at_each_split;
+    };
+
+    // Grows GRT::DecisionTreeNode trees over a tree_dataset, choosing at each node the split with the lowest weighted
+    // Gini impurity. On a binned dataset every bin boundary of every feature is scored from one class histogram per
+    // feature. Otherwise each feature is tried at num_random_splits random thresholds, as GRT's BEST_RANDOM_SPLIT
+    // training mode does. A builder holds scratch space so give each thread its own, the dataset may be shared
+    class tree_builder
+    {
+    public:
+        tree_builder(const tree_dataset &dataset, const tree_settings &settings)
+        :
+        dataset(dataset),
+        settings(settings),
+        counts(dataset.num_classes),
+        left_counts(dataset.num_classes),
+        right_counts(dataset.num_classes),
+        feature_used(dataset.num_dimensions, 0)
+        {
+            if (dataset.is_binned())
+            {
+                histogram.resize(k_tree_max_bins * dataset.num_classes);
+            }
+        }
+
+        // Builds a tree from the samples listed in indices, which may repeat as in a bootstrap. indices is reordered
+        // in place as nodes are split. Returns NULL if indices is empty, the caller owns the returned tree
+        GRT::DecisionTreeNode *build(std::vector<GRT::UINT> &indices, GRT::Random &random)
+        {
+            if (indices.empty())
+            {
+                return NULL;
+            }
+
+            std::fill(feature_used.begin(), feature_used.end(), 0);
+
+            return build_node(&indices[0], &indices[0] + indices.size(), NULL, 0, random);
+        }
+
+    private:
+        GRT::DecisionTreeNode *build_node(GRT::UINT *begin, GRT::UINT *end, GRT::DecisionTreeNode *parent, GRT::UINT depth, GRT::Random &random)
+        {
+            const GRT::UINT num_samples = (GRT::UINT)(end - begin);
+            GRT::VectorDouble class_probabilities(dataset.num_classes, 0.0);
+            GRT::UINT num_classes_present = 0;
+
+            std::fill(counts.begin(), counts.end(), 0);
+
+            for (const GRT::UINT *sample = begin; sample != end; ++sample)
+            {
+                ++counts[dataset.classes[*sample]];
+            }
+
+            for (GRT::UINT label = 0; label < dataset.num_classes; ++label)
+            {
+                class_probabilities[label] = counts[label] / (double)num_samples;
+                num_classes_present += counts[label] > 0;
+            }
+
+            GRT::DecisionTreeNode *node = new GRT::DecisionTreeNode;
+            GRT::UINT feature = 0;
+            double threshold = 0.0;
+
+            node->initNode(parent, depth);
+
+            if (num_classes_present == 1 || num_samples < settings.min_samples_per_node || depth >= settings.max_depth || !find_split(begin, end, random, feature, threshold))
+            {
+                node->setIsLeafNode(true);
+                node->set(num_samples, 0, 0.0, class_probabilities);
+                return node;
+            }
+
+            node->set(num_samples, feature, threshold, class_probabilities);
+
+            // GRT sends samples at or above the threshold to the right child
+            GRT::UINT *middle = std::partition(begin, end, [&](GRT::UINT sample) { return dataset.get_value(sample, feature) < threshold; });
+
+            feature_used[feature] = settings.remove_features_at_each_split;
+
+            node->setLeftChild(build_node(begin, middle, node, depth + 1, random));
+            node->setRightChild(build_node(middle, end, node, depth + 1, random));
+
+            feature_used[feature] = 0;
+
+            return node;
+        }
+
+        // Finds the lowest impurity split that leaves samples on both sides, false if there is none
+        bool find_split(const GRT::UINT *begin, const GRT::UINT *end, GRT::Random &random, GRT::UINT &best_feature, double &best_threshold)
+        {
+            if (dataset.is_binned())
+            {
+                return find_histogram_split(begin, end, best_feature, best_threshold);
+            }
+
+            return find_random_split(begin, end, random, best_feature, best_threshold);
+        }
+
+        bool find_histogram_split(const GRT::UINT *begin, const GRT::UINT *end, GRT::UINT &best_feature, double &best_threshold)
+        {
+            const GRT::UINT num_samples = (GRT::UINT)(end - begin);
+            const GRT::UINT num_classes = dataset.num_classes;
+            double best_score = 0.0;
+            bool found = false;
+
+            for (GRT::UINT feature = 0; feature < dataset.num_dimensions; ++feature)
+            {
+                if (feature_used[feature])
+                {
+                    continue;
+                }
+
+                const GRT::UINT num_bins = dataset.get_num_bins(feature);
+                const uint8_t *bins = dataset.get_bins(feature);
+
+                if (num_bins < 2)
+                {
+                    continue;
+                }
+
+                std::fill(histogram.begin(), histogram.begin() + num_bins * num_classes, 0);
+
+                for (const GRT::UINT *sample = begin; sample != end; ++sample)
+                {
+                    ++histogram[bins[*sample] * num_classes + dataset.classes[*sample]];
+                }
+
+                GRT::UINT num_left = 0;
+
+                std::fill(left_counts.begin(), left_counts.end(), 0);
+
+                // Moving one bin at a time to the left side, split between bin and bin + 1
+                for (GRT::UINT bin = 0; bin + 1 < num_bins; ++bin)
+                {
+                    const GRT::UINT *bin_counts = &histogram[bin * num_classes];
+
+                    for (GRT::UINT label = 0; label < num_classes; ++label)
+                    {
+                        left_counts[label] += bin_counts[label];
+                        num_left += bin_counts[label];
+                    }
+
+                    const GRT::UINT num_right = num_samples - num_left;
+
+                    if (num_left == 0)
+                    {
+                        continue;
+                    }
+
+                    if (num_right == 0)
+                    {
+                        break;
+                    }
+
+                    // Minimising weighted Gini impurity is maximising sum(left^2) / num_left + sum(right^2) / num_right
+                    double left_sum = 0.0;
+                    double right_sum = 0.0;
+
+                    for (GRT::UINT label = 0; label < num_classes; ++label)
+                    {
+                        const double left = left_counts[label];
+                        const double right = counts[label] - left_counts[label];
+
+                        left_sum += left * left;
+                        right_sum += right * right;
+                    }
+
+                    const double score = left_sum / num_left + right_sum / num_right;
+
+                    if (!found || score > best_score)
+                    {
+                        best_score = score;
+                        best_feature = feature;
+                        best_threshold = dataset.cuts[feature][bin];
+                        found = true;
+                    }
+                }
+            }
+
+            return found;
+        }
+
+        bool find_random_split(const GRT::UINT *begin, const GRT::UINT *end, GRT::Random &random, GRT::UINT &best_feature, double &best_threshold)
+        {
+            const double num_samples = (double)(end - begin);
+            double best_impurity = 0.0;
+            bool found = false;
+
+            for (GRT::UINT feature = 0; feature < dataset.num_dimensions; ++feature)
+            {
+                if (feature_used[feature])
+                {
+                    continue;
+                }
+
+                double min_value = dataset.get_value(*begin, feature);
+                double max_value = min_value;
+
+                for (const GRT::UINT *sample = begin; sample != end; ++sample)
+                {
+                    const double value = dataset.get_value(*sample, feature);
+                    min_value = std::min(min_value, value);
+                    max_value = std::max(max_value, value);
+                }
+
+                if (min_value == max_value)
+                {
+                    continue;
+                }
+
+                for (GRT::UINT split = 0; split < settings.num_random_splits; ++split)
+                {
+                    const double threshold = random.getRandomNumberUniform(min_value, max_value);
+                    GRT::UINT num_left = 0;
+
+                    std::fill(left_counts.begin(), left_counts.end(), 0);
+
+                    for (const GRT::UINT *sample = begin; sample != end; ++sample)
+                    {
+                        if (dataset.get_value(*sample, feature) < threshold)
+                        {
+                            ++left_counts[dataset.classes[*sample]];
+                            ++num_left;
+                        }
+                    }
+
+                    const GRT::UINT num_right = (GRT::UINT)num_samples - num_left;
+
+                    if (num_left == 0 || num_right == 0)
+                    {
+                        continue;
+                    }
+
+                    for (GRT::UINT label = 0; label < dataset.num_classes; ++label)
+                    {
+                        right_counts[label] = counts[label] - left_counts[label];
+                    }
+
+                    const double impurity = (num_left * get_gini(left_counts, num_left) + num_right * get_gini(right_counts, num_right)) / num_samples;
+
+                    if (!found || impurity < best_impurity)
+                    {
+                        best_impurity = impurity;
+                        best_feature = feature;
+                        best_threshold = threshold;
+                        found = true;
+                    }
+                }
+            }
+
+            return found;
+        }
+
+        static double get_gini(const std::vector<GRT::UINT> &class_counts, GRT::UINT total)
+        {
+            double sum_of_squares = 0.0;
+
+            for (GRT::UINT label = 0; label < class_counts.size(); ++label)
+            {
+                const double probability = class_counts[label] / (double)total;
+                sum_of_squares += probability * probability;
+            }
+
+            return 1.0 - sum_of_squares;
+        }
+
+        const tree_dataset &dataset;
+        const tree_settings settings;
+
+        // Per-class sample counts of the node being built and of the left and right sides of a candidate split. counts
+        // is only valid until the node's children are built
+        std::vector<GRT::UINT> counts;
+        std::vector<GRT::UINT> left_counts;
+        std::vector<GRT::UINT> right_counts;
+
+        // Per-bin class counts of one feature over the node's samples, bin-major
+        std::vector<GRT::UINT> histogram;
+
+        // Features split on by the node's ancestors, skipped when remove_features_at_each_split is set
+        std::vector<char> feature_used;
+    };
+
+    // Number of trees tree_flat_forest walks in lockstep, so that their independent node loads overlap
+    const GRT::UINT k_tree_group_size = 4;
+
+    // Trained GRT decision trees compiled into one struct-of-arrays node table for prediction. Nodes of each tree are
+    // stored depth first, a node's two children are adjacent in children and leaves point to themselves, so a query
+    // walks every tree of a group for the group's depth with no test for having reached a leaf. The next node is picked
+    // by indexing children with the comparison instead of branching on it
+    class tree_flat_forest
+    {
+    public:
+        tree_flat_forest() : num_classes(0) {}
+
+        void clear()
+        {
+            features.clear();
+            thresholds.clear();
+            children.clear();
+            leaves.clear();
+            distributions.clear();
+            roots.clear();
+            depths.clear();
+            num_classes = 0;
+        }
+
+        bool is_empty() const
+        {
+            return roots.empty();
+        }
+
+        // Replaces the table with the given trees, false if any of them is missing
+        bool compile(const std::vector<const GRT::DecisionTreeNode *> &trees, GRT::UINT num_classes)
+        {
+            clear();
+
+            this->num_classes = num_classes;
+
+            for (GRT::UINT tree = 0; tree < trees.size(); ++tree)
+            {
+                if (trees[tree] == NULL)
+                {
+                    clear();
+                    return false;
+                }
+
+                GRT::UINT depth = 0;
+
+                roots.push_back(add_node(trees[tree], 0, depth));
+                depths.push_back(depth);
+            }
+
+            return true;
+        }
+
+        // Averages the class distributions of the leaves x reaches in every tree into likelihoods and returns the index
+        // of the most likely class, ties going to the lowest index as in GRT
+        GRT::UINT predict(const double *x, double *likelihoods) const
+        {
+            const GRT::UINT num_trees = (GRT::UINT)roots.size();
+
+            std::fill(likelihoods, likelihoods + num_classes, 0.0);
+
+            for (GRT::UINT first = 0; first < num_trees; first += k_tree_group_size)
+            {
+                const GRT::UINT group_size = std::min(k_tree_group_size, num_trees - first);
+                GRT::UINT nodes[k_tree_group_size];
+                GRT::UINT depth = 0;
+
+                for (GRT::UINT lane = 0; lane < group_size; ++lane)
+                {
+                    nodes[lane] = roots[first + lane];
+                    depth = std::max(depth, depths[first + lane]);
+                }
+
+                for (GRT::UINT level = 0; level < depth; ++level)
+                {
+                    for (GRT::UINT lane = 0; lane < group_size; ++lane)
+                    {
+                        const GRT::UINT node = nodes[lane];
+                        nodes[lane] = children[2 * node + (x[features[node]] >= thresholds[node])];
+                    }
+                }
+
+                for (GRT::UINT lane = 0; lane < group_size; ++lane)
+                {
+                    const double *distribution = &distributions[leaves[nodes[lane]]];
+
+                    for (GRT::UINT label = 0; label < num_classes; ++label)
+                    {
+                        likelihoods[label] += distribution[label];
+                    }
+                }
+            }
+
+            GRT::UINT best = 0;
+
+            for (GRT::UINT label = 0; label < num_classes; ++label)
+            {
+                likelihoods[label] /= num_trees;
+
+                if (likelihoods[label] > likelihoods[best])
+                {
+                    best = label;
+                }
+            }
+
+            return best;
+        }
+
+    private:
+        // GRT::Node keeps its children protected without accessors, name them through a derived class
+        struct node_access : GRT::Node
+        {
+            static GRT::Node *GRT::Node::*get_left() { return &node_access::leftChild; }
+            static GRT::Node *GRT::Node::*get_right() { return &node_access::rightChild; }
+        };
+
+        // Appends node and its subtree depth first, returning node's index. depth is raised to the number of
+        // comparisons on the longest path below node
+        GRT::UINT add_node(const GRT::DecisionTreeNode *node, GRT::UINT level, GRT::UINT &depth)
+        {
+            const GRT::UINT index = (GRT::UINT)features.size();
+            const GRT::DecisionTreeNode *left = (const GRT::DecisionTreeNode *)(node->*node_access::get_left());
+            const GRT::DecisionTreeNode *right = (const GRT::DecisionTreeNode *)(node->*node_access::get_right());
+
+            features.push_back(0);
+            thresholds.push_back(0.0);
+            children.push_back(index);
+            children.push_back(index);
+            leaves.push_back(0);
+
+            // GRT treats an inner node without both children as a failed prediction, keep it as a leaf
+            if (node->getIsLeafNode() || left == NULL || right == NULL)
+            {
+                const GRT::VectorDouble class_probabilities = node->getClassProbabilities();
+
+                leaves[index] = (GRT::UINT)distributions.size();
+
+                // Trees loaded from older GRT forests may have fewer classes than the model, missing classes are 0
+                for (GRT::UINT label = 0; label < num_classes; ++label)
+                {
+                    distributions.push_back(label < class_probabilities.size() ? class_probabilities[label] : 0.0);
+                }
+
+                depth = std::max(depth, level);
+                return index;
+            }
+
+            // Children are added before indexing the arrays they grow
+            const GRT::UINT left_index = add_node(left, level + 1, depth);
+            const GRT::UINT right_index = add_node(right, level + 1, depth);
+
+            features[index] = node->getFeatureIndex();
+            thresholds[index] = node->getThreshold();
+            children[2 * index] = left_index;
+            children[2 * index + 1] = right_index;
+
+            return index;
+        }
+
+        GRT::UINT num_classes;
+
+        // Per node: the feature and threshold compared, the left and right child and, for leaves, the offset of the
+        // leaf's class distribution. Leaves compare feature 0 and lead back to themselves
+        std::vector<GRT::UINT> features;
+        std::vector<double> thresholds;
+        std::vector<GRT::UINT> children;
+        std::vector<GRT::UINT> leaves;
+
+        // num_classes probabilities per leaf
+        std::vector<double> distributions;
+
+        // Root node and depth of each tree
+        std::vector<GRT::UINT> roots;
+        std::vector<GRT::UINT> depths;
+    };
+}
+
+#endif
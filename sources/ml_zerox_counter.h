@@ -0,0 +1,118 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ml_ml_zerox_counter_h
+#define ml_ml_zerox_counter_h
+
+#include <algorithm>
+#include <vector>
+
+#include <stdint.h>
+
+namespace ml
+{
+    const uint32_t k_zerox_default_search_window_size = 1024;
+
+    // Streaming zero crossing counter. A crossing is counted when the values go from above dead_zone_threshold to
+    // below -dead_zone_threshold or back, so noise within the dead zone around zero does not count. update() returns
+    // the number of crossings within the last search_window_size values in O(1), keeping one flag per value of the
+    // window. Memory is only allocated when the window size changes
+    class ml_zerox_counter
+    {
+    public:
+        ml_zerox_counter(uint32_t search_window_size = k_zerox_default_search_window_size, double dead_zone_threshold = 0.0)
+        :
+        dead_zone_threshold(dead_zone_threshold)
+        {
+            set_search_window_size(search_window_size);
+        }
+
+        bool set_search_window_size(uint32_t search_window_size)
+        {
+            if (search_window_size == 0)
+            {
+                return false;
+            }
+            crossings.resize(search_window_size);
+            reset();
+            return true;
+        }
+
+        bool set_dead_zone_threshold(double dead_zone_threshold)
+        {
+            if (dead_zone_threshold < 0)
+            {
+                return false;
+            }
+            this->dead_zone_threshold = dead_zone_threshold;
+            return true;
+        }
+
+        uint32_t get_search_window_size() const { return (uint32_t)crossings.size(); }
+        double get_dead_zone_threshold() const { return dead_zone_threshold; }
+
+        void reset()
+        {
+            std::fill(crossings.begin(), crossings.end(), 0);
+            head = 0;
+            count = 0;
+            sign = 0;
+        }
+
+        uint32_t update(double value)
+        {
+            uint8_t crossing = 0;
+
+            if (value > dead_zone_threshold)
+            {
+                crossing = sign < 0;
+                sign = 1;
+            }
+            else if (value < -dead_zone_threshold)
+            {
+                crossing = sign > 0;
+                sign = -1;
+            }
+
+            count += crossing;
+            count -= crossings[head];
+            crossings[head] = crossing;
+
+            if (++head == crossings.size())
+            {
+                head = 0;
+            }
+
+            return count;
+        }
+
+    private:
+        double dead_zone_threshold;
+
+        // Ring buffer of 1 for each value of the window that completed a crossing
+        std::vector<uint8_t> crossings;
+        uint32_t head;
+        uint32_t count;
+
+        // Side of the dead zone the values were last on, 0 before they have left it
+        int sign;
+    };
+}
+
+#endif
@@ -17,40 +17,625 @@
  */
 
 #include "ml_regression.h"
+#include "ml_parallel.h"
+#include "ml_linalg.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace ml
 {
     static const std::string ml_object_name = "ml.linreg";
     
+    enum linreg_solver
+    {
+        LINREG_SOLVER_GRADIENT,
+        LINREG_SOLVER_CHOLESKY,
+        LINREG_SOLVER_QR,
+        LINREG_NUM_SOLVERS
+    };
+    
+    // Prior variance of every coefficient when recursive least squares starts without a ridge term, and the least prior
+    // variance of the bias, which like batch ridge leaves it effectively unpenalised
+    const double k_linreg_recursive_initial_variance = 1.0e6;
+    
+    // Columns of the QR factorisation whose diagonal is this small relative to the largest are treated as dependent and
+    // given a zero coefficient
+    const double k_linreg_rank_tolerance = 1.0e-12;
+    
+    // GRT::LinearRegression that solves for its coefficients exactly, either from the normal equations with a Cholesky
+    // factorisation or, more robustly for badly conditioned inputs, from a Householder QR factorisation of the inputs,
+    // instead of by gradient descent. It can also update the coefficients sample by sample with recursive least
+    // squares. The coefficients are stored in GRT's model, so predictions and model files are GRT's own
+    class ml_linreg_model : public GRT::LinearRegression
+    {
+    public:
+        ml_linreg_model()
+        :
+        solver(LINREG_SOLVER_CHOLESKY),
+        ridge(0.0),
+        forgetting_factor(1.0)
+        {}
+        
+        bool train_(GRT::RegressionData &trainingData);
+        bool clear();
+        
+        using GRT::LinearRegression::train_;
+        
+        // Recursive least squares update with one sample in O(d^2) for d inputs, leaving the model trained. Works on
+        // unscaled values, so it turns scaling off
+        bool update(const GRT::VectorDouble &input, const GRT::VectorDouble &target);
+        void reset_recursive() { covariance.clear(); }
+        
+        bool set_solver(int solver)
+        {
+            if (solver < 0 || solver >= LINREG_NUM_SOLVERS)
+            {
+                return false;
+            }
+            this->solver = (linreg_solver)solver;
+            return true;
+        }
+        
+        bool set_ridge(double ridge)
+        {
+            if (ridge < 0)
+            {
+                return false;
+            }
+            this->ridge = ridge;
+            return true;
+        }
+        
+        bool set_forgetting_factor(double forgetting_factor)
+        {
+            if (forgetting_factor <= 0 || forgetting_factor > 1)
+            {
+                return false;
+            }
+            this->forgetting_factor = forgetting_factor;
+            return true;
+        }
+        
+        linreg_solver get_solver() const { return solver; }
+        double get_ridge() const { return ridge; }
+        double get_forgetting_factor() const { return forgetting_factor; }
+    
+    protected:
+        bool solve_cholesky(const std::vector<double> &inputs, const std::vector<double> &targets, std::vector<double> &coefficients) const;
+        void solve_qr(const std::vector<double> &inputs, const std::vector<double> &targets, std::vector<double> &coefficients) const;
+        void store_coefficients(const std::vector<double> &coefficients);
+        
+        linreg_solver solver;
+        double ridge;
+        double forgetting_factor;
+        
+        // Recursive least squares state, the coefficients' (numInputDimensions + 1)^2 covariance with the bias first
+        std::vector<double> coefficients;
+        std::vector<double> covariance;
+        std::vector<double> gain;
+    };
+    
+    bool ml_linreg_model::train_(GRT::RegressionData &trainingData)
+    {
+        if (solver == LINREG_SOLVER_GRADIENT)
+        {
+            reset_recursive();
+            return GRT::LinearRegression::train_(trainingData);
+        }
+        
+        clear();
+        
+        const GRT::UINT M = trainingData.getNumSamples();
+        const GRT::UINT N = trainingData.getNumInputDimensions();
+        const GRT::UINT T = trainingData.getNumTargetDimensions();
+        
+        if (M == 0)
+        {
+            errorLog << "train_(RegressionData &trainingData) - Training data has zero samples!" << endl;
+            return false;
+        }
+        
+        if (T != 1)
+        {
+            errorLog << "train_(RegressionData &trainingData) - The number of target dimensions is not 1!" << endl;
+            return false;
+        }
+        
+        numInputDimensions = N;
+        numOutputDimensions = 1;
+        inputVectorRanges = trainingData.getInputRanges();
+        targetVectorRanges = trainingData.getTargetRanges();
+        
+        if (useScaling)
+        {
+            trainingData.scale(inputVectorRanges, targetVectorRanges, 0.0, 1.0);
+        }
+        
+        std::vector<double> inputs(M * N);
+        std::vector<double> targets(M);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            const GRT::VectorDouble &input = trainingData[i].getInputVector();
+            
+            std::copy(input.begin(), input.end(), inputs.begin() + i * N);
+            targets[i] = trainingData[i].getTargetVector()[0];
+        }
+        
+        std::vector<double> solution;
+        
+        if (solver == LINREG_SOLVER_CHOLESKY && !solve_cholesky(inputs, targets, solution))
+        {
+            errorLog << "train_(RegressionData &trainingData) - The normal equations are singular, set a ridge term or use the QR solver!" << endl;
+            return false;
+        }
+        
+        if (solver == LINREG_SOLVER_QR)
+        {
+            solve_qr(inputs, targets, solution);
+        }
+        
+        store_coefficients(solution);
+        
+        totalSquaredTrainingError = 0;
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            double error = targets[i] - solution[0];
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                error -= solution[n + 1] * inputs[i * N + n];
+            }
+            
+            totalSquaredTrainingError += error * error;
+        }
+        
+        rootMeanSquaredTrainingError = sqrt(totalSquaredTrainingError / M);
+        
+        return true;
+    }
+    
+    // Accumulates X^T X and X^T y for the inputs X with a leading column of ones with parallel_block_sum, adds the ridge
+    // term to every coefficient but the bias and solves by Cholesky
+    bool ml_linreg_model::solve_cholesky(const std::vector<double> &inputs, const std::vector<double> &targets, std::vector<double> &coefficients) const
+    {
+        const GRT::UINT M = (GRT::UINT)targets.size();
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT P = N + 1;
+        const GRT::UINT stride = P * P + P;
+        std::vector<double> block_sums;
+        std::vector<double> gram;
+        std::vector<double> rows(get_num_workers(get_num_blocks(M)) * P);
+        
+        // X^T X followed by X^T y
+        parallel_block_sum(M, stride, block_sums, gram, [&](GRT::UINT begin, GRT::UINT end, double *partial, unsigned int worker)
+        {
+            double *moments = partial + P * P;
+            double *row = &rows[worker * P];
+            
+            for (GRT::UINT i = begin; i < end; ++i)
+            {
+                row[0] = 1.0;
+                std::copy(&inputs[i * N], &inputs[i * N] + N, row + 1);
+                
+                // Lower triangle only, the matrix is symmetric
+                for (GRT::UINT j = 0; j < P; ++j)
+                {
+                    const double value = row[j];
+                    double *gram_row = partial + j * P;
+                    
+                    for (GRT::UINT k = 0; k <= j; ++k)
+                    {
+                        gram_row[k] += value * row[k];
+                    }
+                    
+                    moments[j] += value * targets[i];
+                }
+            }
+        });
+        
+        coefficients.assign(gram.begin() + P * P, gram.end());
+        gram.resize(P * P);
+        
+        for (GRT::UINT j = 1; j < P; ++j)
+        {
+            gram[j * P + j] += ridge;
+        }
+        
+        if (!cholesky_decompose(gram, P))
+        {
+            return false;
+        }
+        
+        cholesky_solve(gram, coefficients, P);
+        
+        return true;
+    }
+    
+    // Least squares by Householder QR of the inputs with a leading column of ones, stored column-major and extended by
+    // sqrt(ridge) rows for the ridge term. Solving R b = Q^T y avoids squaring the condition number as the normal
+    // equations do, and dependent columns are detected from R's diagonal and dropped
+    void ml_linreg_model::solve_qr(const std::vector<double> &inputs, const std::vector<double> &targets, std::vector<double> &coefficients) const
+    {
+        const GRT::UINT M = (GRT::UINT)targets.size();
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT P = N + 1;
+        const GRT::UINT R = ridge > 0 ? M + N : M;
+        std::vector<double> columns(P * R, 0.0);
+        std::vector<double> rhs(R, 0.0);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            columns[i] = 1.0;
+            rhs[i] = targets[i];
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                columns[(n + 1) * R + i] = inputs[i * N + n];
+            }
+        }
+        
+        if (ridge > 0)
+        {
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                columns[(n + 1) * R + M + n] = sqrt(ridge);
+            }
+        }
+        
+        std::vector<double> diagonal(P, 0.0);
+        
+        for (GRT::UINT j = 0; j < P && j < R; ++j)
+        {
+            double *column = &columns[j * R];
+            double norm = 0.0;
+            
+            for (GRT::UINT i = j; i < R; ++i)
+            {
+                norm += column[i] * column[i];
+            }
+            
+            norm = sqrt(norm);
+            
+            if (norm == 0.0)
+            {
+                continue;
+            }
+            
+            // Householder vector v = x + sign(x_j) |x| e_j stored over the column, R's diagonal is -sign(x_j) |x|
+            const double alpha = column[j] > 0.0 ? -norm : norm;
+            
+            column[j] -= alpha;
+            diagonal[j] = alpha;
+            
+            const double scale = 1.0 / (-alpha * column[j]);
+            
+            for (GRT::UINT k = j + 1; k < P; ++k)
+            {
+                double *other = &columns[k * R];
+                double dot = 0.0;
+                
+                for (GRT::UINT i = j; i < R; ++i)
+                {
+                    dot += column[i] * other[i];
+                }
+                
+                dot *= scale;
+                
+                for (GRT::UINT i = j; i < R; ++i)
+                {
+                    other[i] -= dot * column[i];
+                }
+            }
+            
+            double dot = 0.0;
+            
+            for (GRT::UINT i = j; i < R; ++i)
+            {
+                dot += column[i] * rhs[i];
+            }
+            
+            dot *= scale;
+            
+            for (GRT::UINT i = j; i < R; ++i)
+            {
+                rhs[i] -= dot * column[i];
+            }
+        }
+        
+        double largest = 0.0;
+        
+        for (GRT::UINT j = 0; j < P; ++j)
+        {
+            largest = std::max(largest, fabs(diagonal[j]));
+        }
+        
+        coefficients.assign(P, 0.0);
+        
+        for (GRT::UINT j = P; j-- > 0;)
+        {
+            if (fabs(diagonal[j]) <= k_linreg_rank_tolerance * largest)
+            {
+                continue;
+            }
+            
+            double value = rhs[j];
+            
+            for (GRT::UINT k = j + 1; k < P; ++k)
+            {
+                value -= columns[k * R + j] * coefficients[k];
+            }
+            
+            coefficients[j] = value / diagonal[j];
+        }
+    }
+    
+    bool ml_linreg_model::update(const GRT::VectorDouble &input, const GRT::VectorDouble &target)
+    {
+        const GRT::UINT N = (GRT::UINT)input.size();
+        const GRT::UINT P = N + 1;
+        
+        if (target.size() != 1)
+        {
+            errorLog << "update(const VectorDouble &input, const VectorDouble &target) - The number of target dimensions is not 1!" << endl;
+            return false;
+        }
+        
+        if (covariance.size() != P * P)
+        {
+            const double variance = ridge > 0 ? 1.0 / ridge : k_linreg_recursive_initial_variance;
+            
+            coefficients.assign(P, 0.0);
+            covariance.assign(P * P, 0.0);
+            gain.resize(P);
+            
+            covariance[0] = std::max(variance, k_linreg_recursive_initial_variance);
+            
+            for (GRT::UINT j = 1; j < P; ++j)
+            {
+                covariance[j * P + j] = variance;
+            }
+            
+            // Carry on from a model trained or loaded without scaling, as its prior mean
+            if (trained && !useScaling && numInputDimensions == N && w.size() == N)
+            {
+                coefficients[0] = w0;
+                std::copy(w.begin(), w.end(), coefficients.begin() + 1);
+            }
+        }
+        
+        // gain = P x / (lambda + x^T P x), where x has a leading 1 for the bias
+        double error = target[0] - coefficients[0];
+        double denominator = forgetting_factor;
+        
+        for (GRT::UINT j = 0; j < P; ++j)
+        {
+            const double *row = &covariance[j * P];
+            double value = row[0];
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                value += row[n + 1] * input[n];
+            }
+            
+            gain[j] = value;
+            denominator += value * (j == 0 ? 1.0 : input[j - 1]);
+        }
+        
+        for (GRT::UINT n = 0; n < N; ++n)
+        {
+            error -= coefficients[n + 1] * input[n];
+        }
+        
+        // P = (P - P x x^T P / denominator) / lambda
+        const double inverse_factor = 1.0 / forgetting_factor;
+        
+        for (GRT::UINT j = 0; j < P; ++j)
+        {
+            double *row = &covariance[j * P];
+            const double value = gain[j] / denominator;
+            
+            for (GRT::UINT k = 0; k < P; ++k)
+            {
+                row[k] = (row[k] - value * gain[k]) * inverse_factor;
+            }
+        }
+        
+        for (GRT::UINT j = 0; j < P; ++j)
+        {
+            coefficients[j] += gain[j] / denominator * error;
+        }
+        
+        useScaling = false;
+        numInputDimensions = N;
+        numOutputDimensions = 1;
+        store_coefficients(coefficients);
+        
+        return true;
+    }
+    
+    void ml_linreg_model::store_coefficients(const std::vector<double> &coefficients)
+    {
+        w0 = coefficients[0];
+        w.assign(coefficients.begin() + 1, coefficients.end());
+        regressionData.resize(1);
+        trained = true;
+    }
+    
+    bool ml_linreg_model::clear()
+    {
+        reset_recursive();
+        
+        return GRT::LinearRegression::clear();
+    }
+    
     class ml_linreg : ml_regression
     {
         FLEXT_HEADER_S(ml_linreg, ml_regression, setup);
-        
+    
     public:
         ml_linreg()
+        :
+        recursive(false)
         {
             post("Linear Regression based on the GRT library version" + GRT::GRTBase::getGRTVersion());
             set_scaling(default_scaling);
+            help.append_attributes(attribute_help);
         }
-        
+    
     protected:
         static void setup(t_classid c)
         {
+            // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "solver", set_solver);
+            FLEXT_CADDATTR_SET(c, "ridge", set_ridge);
+            FLEXT_CADDATTR_SET(c, "recursive", set_recursive);
+            FLEXT_CADDATTR_SET(c, "forgetting_factor", set_forgetting_factor);
+            
+            // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "solver", get_solver);
+            FLEXT_CADDATTR_GET(c, "ridge", get_ridge);
+            FLEXT_CADDATTR_GET(c, "recursive", get_recursive);
+            FLEXT_CADDATTR_GET(c, "forgetting_factor", get_forgetting_factor);
+            
             DefineHelp(c, ml_object_name.c_str());
         }
         
+        // Method overrides
+        void add(int argc, const t_atom *argv);
+        
+        // Flext attribute setters
+        void set_solver(int solver);
+        void set_ridge(float ridge);
+        void set_recursive(bool recursive);
+        void set_forgetting_factor(float forgetting_factor);
+        
+        // Flext attribute getters
+        void get_solver(int &solver) const;
+        void get_ridge(float &ridge) const;
+        void get_recursive(bool &recursive) const;
+        void get_forgetting_factor(float &forgetting_factor) const;
+        
         // Implement pure virtual methods
         GRT::Regressifier &get_Regressifier_instance();
         const GRT::Regressifier &get_Regressifier_instance() const;
-
+    
     private:
+        // Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_solver, set_solver);
+        FLEXT_CALLVAR_F(get_ridge, set_ridge);
+        FLEXT_CALLVAR_B(get_recursive, set_recursive);
+        FLEXT_CALLVAR_F(get_forgetting_factor, set_forgetting_factor);
+        
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        GRT::LinearRegression regressifier;
+        ml_linreg_model regressifier;
+        bool recursive;
         
+        static const std::string attribute_help;
     };
     
+    // Method overrides
+    void ml_linreg::add(int argc, const t_atom *argv)
+    {
+        const GRT::UINT numSamples = regression_data.getNumSamples();
+        
+        ml_regression::add(argc, argv);
+        
+        const GRT::UINT newNumSamples = regression_data.getNumSamples();
+        
+        if (!recursive || newNumSamples == 0 || newNumSamples == numSamples)
+        {
+            return;
+        }
+        
+        const GRT::RegressionSample &sample = regression_data[newNumSamples - 1];
+        bool success = regressifier.update(sample.getInputVector(), sample.getTargetVector());
+        
+        if (success == false)
+        {
+            error("unable to update model, hint: recursive mode needs exactly one output");
+        }
+    }
+    
+    // Flext attribute setters
+    void ml_linreg::set_solver(int solver)
+    {
+        bool success = regressifier.set_solver(solver);
+        
+        if (success == false)
+        {
+            error("invalid solver: " + std::to_string(solver) + ", must be " + std::to_string(LINREG_SOLVER_GRADIENT) + ":GRADIENT, " + std::to_string(LINREG_SOLVER_CHOLESKY) + ":CHOLESKY or " + std::to_string(LINREG_SOLVER_QR) + ":QR");
+        }
+    }
+    
+    void ml_linreg::set_ridge(float ridge)
+    {
+        bool success = regressifier.set_ridge(ridge);
+        
+        if (success == false)
+        {
+            error("unable to set ridge, hint: should be 0 or greater");
+        }
+    }
+    
+    void ml_linreg::set_recursive(bool recursive)
+    {
+        this->recursive = recursive;
+        regressifier.reset_recursive();
+        
+        if (!recursive)
+        {
+            return;
+        }
+        
+        // Start from the observations added so far
+        for (GRT::UINT index = 0; index < regression_data.getNumSamples(); ++index)
+        {
+            const GRT::RegressionSample &sample = regression_data[index];
+            
+            if (regressifier.update(sample.getInputVector(), sample.getTargetVector()) == false)
+            {
+                error("unable to update model, hint: recursive mode needs exactly one output");
+                return;
+            }
+        }
+    }
+    
+    void ml_linreg::set_forgetting_factor(float forgetting_factor)
+    {
+        bool success = regressifier.set_forgetting_factor(forgetting_factor);
+        
+        if (success == false)
+        {
+            error("unable to set forgetting_factor, hint: should be greater than 0 and at most 1");
+        }
+    }
+    
+    // Flext attribute getters
+    void ml_linreg::get_solver(int &solver) const
+    {
+        solver = regressifier.get_solver();
+    }
+    
+    void ml_linreg::get_ridge(float &ridge) const
+    {
+        ridge = regressifier.get_ridge();
+    }
+    
+    void ml_linreg::get_recursive(bool &recursive) const
+    {
+        recursive = this->recursive;
+    }
+    
+    void ml_linreg::get_forgetting_factor(float &forgetting_factor) const
+    {
+        forgetting_factor = regressifier.get_forgetting_factor();
+    }
+    
     // Implement pure virtual methods
     GRT::Regressifier &ml_linreg::get_Regressifier_instance()
     {
@@ -61,7 +646,13 @@ namespace ml
     {
         return regressifier;
     }
-
+    
+    const std::string ml_linreg::attribute_help =
+    "solver:\tinteger selecting how 'train' finds the coefficients, 0:GRADIENT uses GRT's gradient descent with max_iterations, min_change and training_rate, 1:CHOLESKY solves the normal equations exactly, 2:QR solves the least squares problem exactly and copes with dependent or badly scaled inputs (default CHOLESKY)\n"
+    "ridge:\tfloating point value (>= 0) weighting an L2 penalty on the coefficients, except the bias, for the CHOLESKY and QR solvers; in recursive mode it is the initial precision of every coefficient but the bias, 0 meaning 1.0e-6 (default 0)\n"
+    "recursive:\tinteger (0 or 1), when on every 'add' updates the model by recursive least squares so it is always trained without 'train'; turning it on replays the observations added so far, and scaling is turned off (default 0)\n"
+    "forgetting_factor:\tfloating point value (0 < f <= 1) by which recursive mode discounts older observations at each 'add', 1 weights every observation equally (default 1)\n";
+    
     typedef class ml_linreg ml0x2elinreg;
     
 #ifdef BUILD_AS_LIBRARY
@@ -17,40 +17,538 @@
  */
 
 #include "ml_regression.h"
+#include "ml_parallel.h"
+#include "ml_linalg.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cmath>
 
 namespace ml
 {
     static const std::string ml_object_name = "ml.logreg";
     
+    enum logreg_solver
+    {
+        LOGREG_SOLVER_GRADIENT,
+        LOGREG_SOLVER_NEWTON,
+        LOGREG_NUM_SOLVERS
+    };
+    
+    const double k_logreg_default_regularisation = 1.0e-6;
+    
+    // Limits of the backtracking line search that guards each Newton step
+    const GRT::UINT k_logreg_max_line_search_steps = 30;
+    const double k_logreg_sufficient_decrease = 1.0e-4;
+    
+    // Targets may stray this far outside [0, 1] through rounding before they are rejected
+    const double k_logreg_target_tolerance = 1.0e-9;
+    
+    struct logreg_training_result
+    {
+        logreg_training_result()
+        :
+        num_iterations(0),
+        loss(0.0)
+        {}
+        
+        GRT::UINT num_iterations;
+        double loss;
+    };
+    
+    // GRT::LogisticRegression that fits its coefficients by Newton's method, i.e. iteratively reweighted least squares,
+    // on the mean cross-entropy plus an L2 penalty on the weights, instead of by stochastic gradient descent. The
+    // coefficients are stored in GRT's model, so predictions and model files are GRT's own
+    class ml_logreg_model : public GRT::LogisticRegression
+    {
+    public:
+        ml_logreg_model()
+        :
+        solver(LOGREG_SOLVER_NEWTON),
+        regularisation(k_logreg_default_regularisation)
+        {}
+        
+        bool train_(GRT::RegressionData &trainingData);
+        
+        using GRT::LogisticRegression::train_;
+        
+        bool set_solver(int solver)
+        {
+            if (solver < 0 || solver >= LOGREG_NUM_SOLVERS)
+            {
+                return false;
+            }
+            this->solver = (logreg_solver)solver;
+            return true;
+        }
+        
+        bool set_regularisation(double regularisation)
+        {
+            if (regularisation < 0)
+            {
+                return false;
+            }
+            this->regularisation = regularisation;
+            return true;
+        }
+        
+        logreg_solver get_solver() const { return solver; }
+        double get_regularisation() const { return regularisation; }
+        const logreg_training_result &get_training_result() const { return training_result; }
+    
+    protected:
+        void scale_samples(std::vector<double> &inputs, std::vector<double> &targets);
+        double penalty(const std::vector<double> &coefficients) const;
+        double evaluate(const std::vector<double> &inputs, const std::vector<double> &targets, const std::vector<double> &coefficients, std::vector<double> *gradient, std::vector<double> *hessian) const;
+        bool minimise(const std::vector<double> &inputs, const std::vector<double> &targets, std::vector<double> &coefficients);
+        
+        logreg_solver solver;
+        double regularisation;
+        logreg_training_result training_result;
+    };
+    
+    bool ml_logreg_model::train_(GRT::RegressionData &trainingData)
+    {
+        const GRT::UINT M = trainingData.getNumSamples();
+        const GRT::UINT N = trainingData.getNumInputDimensions();
+        const GRT::UINT T = trainingData.getNumTargetDimensions();
+        
+        training_result = logreg_training_result();
+        
+        if (M == 0)
+        {
+            errorLog << "train_(RegressionData &trainingData) - Training data has zero samples!" << endl;
+            return false;
+        }
+        
+        if (T != 1)
+        {
+            errorLog << "train_(RegressionData &trainingData) - The number of target dimensions is not 1!" << endl;
+            return false;
+        }
+        
+        // Unscaled copies, contiguous and row-major, so the loss of either solver is measured the same way
+        std::vector<double> inputs(M * N);
+        std::vector<double> targets(M);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            const GRT::VectorDouble &input = trainingData[i].getInputVector();
+            
+            std::copy(input.begin(), input.end(), inputs.begin() + i * N);
+            targets[i] = trainingData[i].getTargetVector()[0];
+        }
+        
+        std::vector<double> coefficients(N + 1, 0.0);
+        
+        if (solver == LOGREG_SOLVER_GRADIENT)
+        {
+            if (!GRT::LogisticRegression::train_(trainingData))
+            {
+                return false;
+            }
+            
+            if (useScaling)
+            {
+                scale_samples(inputs, targets);
+            }
+            
+            coefficients[0] = w0;
+            std::copy(w.begin(), w.end(), coefficients.begin() + 1);
+            training_result.loss = evaluate(inputs, targets, coefficients, NULL, NULL) - penalty(coefficients);
+            
+            return true;
+        }
+        
+        clear();
+        
+        numInputDimensions = N;
+        numOutputDimensions = 1;
+        inputVectorRanges = trainingData.getInputRanges();
+        targetVectorRanges = trainingData.getTargetRanges();
+        
+        if (useScaling)
+        {
+            scale_samples(inputs, targets);
+        }
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            if (targets[i] < -k_logreg_target_tolerance || targets[i] > 1.0 + k_logreg_target_tolerance)
+            {
+                errorLog << "train_(RegressionData &trainingData) - The targets must be between 0 and 1, or scaling must be enabled!" << endl;
+                return false;
+            }
+            
+            targets[i] = std::min(1.0, std::max(0.0, targets[i]));
+        }
+        
+        if (!minimise(inputs, targets, coefficients))
+        {
+            errorLog << "train_(RegressionData &trainingData) - The Hessian is singular, increase the regularisation!" << endl;
+            return false;
+        }
+        
+        w0 = coefficients[0];
+        w.assign(coefficients.begin() + 1, coefficients.end());
+        regressionData.resize(1);
+        trained = true;
+        
+        totalSquaredTrainingError = 0;
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            double activation = coefficients[0];
+            
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                activation += coefficients[n + 1] * inputs[i * N + n];
+            }
+            
+            const double error = targets[i] - 1.0 / (1.0 + exp(-activation));
+            
+            totalSquaredTrainingError += error * error;
+        }
+        
+        rootMeanSquaredTrainingError = sqrt(totalSquaredTrainingError / M);
+        
+        return true;
+    }
+    
+    // Scales in place to [0, 1] by the model's ranges, as GRT scales the training data
+    void ml_logreg_model::scale_samples(std::vector<double> &inputs, std::vector<double> &targets)
+    {
+        const GRT::UINT M = (GRT::UINT)targets.size();
+        const GRT::UINT N = numInputDimensions;
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            for (GRT::UINT n = 0; n < N; ++n)
+            {
+                inputs[i * N + n] = scale(inputs[i * N + n], inputVectorRanges[n].minValue, inputVectorRanges[n].maxValue, 0.0, 1.0);
+            }
+            
+            targets[i] = scale(targets[i], targetVectorRanges[0].minValue, targetVectorRanges[0].maxValue, 0.0, 1.0);
+        }
+    }
+    
+    // Half the regularisation times the squared weights, the bias is not penalised
+    double ml_logreg_model::penalty(const std::vector<double> &coefficients) const
+    {
+        double sum = 0.0;
+        
+        for (GRT::UINT j = 1; j < coefficients.size(); ++j)
+        {
+            sum += coefficients[j] * coefficients[j];
+        }
+        
+        return 0.5 * regularisation * sum;
+    }
+    
+    // Mean cross-entropy of the samples for the coefficients (bias first) plus half the regularisation times the
+    // squared weights. The gradient and the lower triangle of the Hessian, X^T S X / M with S = diag(p (1 - p)) plus
+    // the regularisation, are also computed when asked for. The sums over the samples are made with parallel_block_sum
+    double ml_logreg_model::evaluate(const std::vector<double> &inputs, const std::vector<double> &targets, const std::vector<double> &coefficients, std::vector<double> *gradient, std::vector<double> *hessian) const
+    {
+        const GRT::UINT M = (GRT::UINT)targets.size();
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT P = N + 1;
+        const GRT::UINT stride = 1 + (gradient ? P : 0) + (hessian ? P * P : 0);
+        std::vector<double> block_sums;
+        std::vector<double> sums;
+        std::vector<double> rows(get_num_workers(get_num_blocks(M)) * 2 * P);
+        
+        parallel_block_sum(M, stride, block_sums, sums, [&](GRT::UINT begin, GRT::UINT end, double *partial, unsigned int worker)
+        {
+            double *loss = partial;
+            double *block_gradient = loss + 1;
+            double *block_hessian = block_gradient + (gradient ? P : 0);
+            double *row = &rows[worker * 2 * P];
+            double *weighted_row = row + P;
+            
+            for (GRT::UINT i = begin; i < end; ++i)
+            {
+                row[0] = 1.0;
+                std::copy(&inputs[i * N], &inputs[i * N] + N, row + 1);
+                
+                double activation = 0.0;
+                
+                for (GRT::UINT j = 0; j < P; ++j)
+                {
+                    activation += coefficients[j] * row[j];
+                }
+                
+                // log(1 + e^a) - y a and the sigmoid, without overflow for large |a|
+                const double exponential = exp(-fabs(activation));
+                const double probability = activation >= 0.0 ? 1.0 / (1.0 + exponential) : exponential / (1.0 + exponential);
+                
+                *loss += std::max(activation, 0.0) + log1p(exponential) - targets[i] * activation;
+                
+                if (gradient)
+                {
+                    const double residual = probability - targets[i];
+                    
+                    for (GRT::UINT j = 0; j < P; ++j)
+                    {
+                        block_gradient[j] += residual * row[j];
+                    }
+                }
+                
+                if (hessian)
+                {
+                    const double weight = probability * (1.0 - probability);
+                    
+                    for (GRT::UINT j = 0; j < P; ++j)
+                    {
+                        weighted_row[j] = weight * row[j];
+                    }
+                    
+                    // Lower triangle only, the matrix is symmetric
+                    for (GRT::UINT j = 0; j < P; ++j)
+                    {
+                        const double value = row[j];
+                        double *hessian_row = block_hessian + j * P;
+                        
+                        for (GRT::UINT k = 0; k <= j; ++k)
+                        {
+                            hessian_row[k] += value * weighted_row[k];
+                        }
+                    }
+                }
+            }
+        });
+        
+        double loss = sums[0];
+        
+        if (gradient)
+        {
+            gradient->assign(sums.begin() + 1, sums.begin() + 1 + P);
+        }
+        
+        if (hessian)
+        {
+            const GRT::UINT offset = 1 + (gradient ? P : 0);
+            
+            hessian->assign(sums.begin() + offset, sums.begin() + offset + P * P);
+        }
+        
+        const double inverse_M = 1.0 / M;
+        
+        loss = loss * inverse_M + penalty(coefficients);
+        
+        if (gradient)
+        {
+            for (GRT::UINT j = 0; j < P; ++j)
+            {
+                (*gradient)[j] = (*gradient)[j] * inverse_M + (j > 0 ? regularisation * coefficients[j] : 0.0);
+            }
+        }
+        
+        if (hessian)
+        {
+            for (GRT::UINT index = 0; index < P * P; ++index)
+            {
+                (*hessian)[index] *= inverse_M;
+            }
+            
+            for (GRT::UINT j = 1; j < P; ++j)
+            {
+                (*hessian)[j * P + j] += regularisation;
+            }
+        }
+        
+        return loss;
+    }
+    
+    // Newton's method from zero coefficients. Each iteration solves H d = g by Cholesky and backtracks along -d until
+    // the loss decreases sufficiently, which for this convex loss is rarely needed. Stops when the predicted decrease
+    // g^T d / 2 or the actual decrease falls below minChange relative to the loss, or after maxNumEpochs iterations.
+    // Returns false if the Hessian is singular, which needs both no regularisation and degenerate inputs
+    bool ml_logreg_model::minimise(const std::vector<double> &inputs, const std::vector<double> &targets, std::vector<double> &coefficients)
+    {
+        const GRT::UINT P = (GRT::UINT)coefficients.size();
+        std::vector<double> gradient;
+        std::vector<double> hessian;
+        std::vector<double> step;
+        std::vector<double> candidate(P);
+        std::vector<double> candidate_gradient;
+        std::vector<double> candidate_hessian;
+        double loss = evaluate(inputs, targets, coefficients, &gradient, &hessian);
+        
+        GRT::UINT iteration = 0;
+        
+        for (; iteration < maxNumEpochs; ++iteration)
+        {
+            if (!cholesky_decompose(hessian, P))
+            {
+                return false;
+            }
+            
+            step = gradient;
+            cholesky_solve(hessian, step, P);
+            
+            double decrease = 0.0;
+            
+            for (GRT::UINT j = 0; j < P; ++j)
+            {
+                decrease += gradient[j] * step[j];
+            }
+            
+            if (0.5 * decrease <= minChange * std::max(1.0, loss))
+            {
+                break;
+            }
+            
+            double step_size = 1.0;
+            double candidate_loss = loss;
+            bool accepted = false;
+            
+            for (GRT::UINT line_search_step = 0; line_search_step < k_logreg_max_line_search_steps; ++line_search_step)
+            {
+                for (GRT::UINT j = 0; j < P; ++j)
+                {
+                    candidate[j] = coefficients[j] - step_size * step[j];
+                }
+                
+                // The derivatives are wanted at the accepted point, which is almost always the full step
+                candidate_loss = evaluate(inputs, targets, candidate, &candidate_gradient, &candidate_hessian);
+                
+                if (candidate_loss <= loss - k_logreg_sufficient_decrease * step_size * decrease)
+                {
+                    accepted = true;
+                    break;
+                }
+                
+                step_size *= 0.5;
+            }
+            
+            if (!accepted)
+            {
+                break;
+            }
+            
+            const double change = loss - candidate_loss;
+            
+            coefficients.swap(candidate);
+            gradient.swap(candidate_gradient);
+            hessian.swap(candidate_hessian);
+            loss = candidate_loss;
+            
+            if (change <= minChange * std::max(1.0, loss))
+            {
+                ++iteration;
+                break;
+            }
+        }
+        
+        // Reported without the penalty so it compares with the gradient solver's
+        training_result.num_iterations = iteration;
+        training_result.loss = loss - penalty(coefficients);
+        
+        return true;
+    }
+    
     class ml_logreg : ml_regression
     {
         FLEXT_HEADER_S(ml_logreg, ml_regression, setup);
-        
+    
     public:
         ml_logreg()
         {
             post("Logistic Regression based on the GRT library version " + GRT::GRTBase::getGRTVersion());
             set_scaling(default_scaling);
+            help.append_attributes(attribute_help);
         }
-        
+    
     protected:
         static void setup(t_classid c)
         {
+            // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "solver", set_solver);
+            FLEXT_CADDATTR_SET(c, "regularisation", set_regularisation);
+            
+            // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "solver", get_solver);
+            FLEXT_CADDATTR_GET(c, "regularisation", get_regularisation);
+            
             DefineHelp(c, ml_object_name.c_str());
         }
         
+        // Method overrides
+        bool get_training_summary(GRT::UINT num_samples, double seconds, std::stringstream &summary) const;
+        
+        // Flext attribute setters
+        void set_solver(int solver);
+        void set_regularisation(float regularisation);
+        
+        // Flext attribute getters
+        void get_solver(int &solver) const;
+        void get_regularisation(float &regularisation) const;
+        
         // Implement pure virtual methods
         GRT::Regressifier &get_Regressifier_instance();
         const GRT::Regressifier &get_Regressifier_instance() const;
-        
+    
     private:
+        // Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_solver, set_solver);
+        FLEXT_CALLVAR_F(get_regularisation, set_regularisation);
+        
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
-                
-        GRT::LogisticRegression regressifier;
         
+        ml_logreg_model regressifier;
+        
+        static const std::string attribute_help;
     };
     
+    // Method overrides
+    // Reported for either solver so they can be compared on the same data
+    bool ml_logreg::get_training_summary(GRT::UINT, double, std::stringstream &summary) const
+    {
+        const logreg_training_result &result = regressifier.get_training_result();
+        
+        if (regressifier.get_solver() == LOGREG_SOLVER_NEWTON)
+        {
+            summary << ", " << result.num_iterations << " Newton iterations";
+        }
+        summary << ", mean cross-entropy " << result.loss;
+        
+        return true;
+    }
+    
+    // Flext attribute setters
+    void ml_logreg::set_solver(int solver)
+    {
+        bool success = regressifier.set_solver(solver);
+        
+        if (success == false)
+        {
+            error("invalid solver: " + std::to_string(solver) + ", must be " + std::to_string(LOGREG_SOLVER_GRADIENT) + ":GRADIENT or " + std::to_string(LOGREG_SOLVER_NEWTON) + ":NEWTON");
+        }
+    }
+    
+    void ml_logreg::set_regularisation(float regularisation)
+    {
+        bool success = regressifier.set_regularisation(regularisation);
+        
+        if (success == false)
+        {
+            error("unable to set regularisation, hint: should be 0 or greater");
+        }
+    }
+    
+    // Flext attribute getters
+    void ml_logreg::get_solver(int &solver) const
+    {
+        solver = regressifier.get_solver();
+    }
+    
+    void ml_logreg::get_regularisation(float &regularisation) const
+    {
+        regularisation = regressifier.get_regularisation();
+    }
+    
     // Implement pure virtual methods
     GRT::Regressifier &ml_logreg::get_Regressifier_instance()
     {
@@ -62,6 +560,10 @@ namespace ml
         return regressifier;
     }
     
+    const std::string ml_logreg::attribute_help =
+    "solver:\tinteger selecting how 'train' fits the model, 0:GRADIENT uses GRT's stochastic gradient descent with max_iterations, min_change and training_rate, 1:NEWTON uses iteratively reweighted least squares, converging in tens of iterations of at most max_iterations until the cross-entropy changes by less than min_change (default NEWTON)\n"
+    "regularisation:\tfloating point value (>= 0) weighting an L2 penalty on the weights, except the bias, for the NEWTON solver; keeps the weights finite when the classes are separable (default 1.0e-6)\n";
+    
     typedef class ml_logreg ml0x2elogreg;
     
 #ifdef BUILD_AS_LIBRARY
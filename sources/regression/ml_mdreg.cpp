@@ -0,0 +1,763 @@
+/*
+ * ml-lib, a machine learning library for Max and Pure Data
+ * Copyright (C) 2013 Carnegie Mellon University
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of  MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ml_regression.h"
+#include "ml_parallel.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+namespace ml
+{
+    static const std::string ml_object_name = "ml.mdreg";
+    
+    enum mdreg_regressor
+    {
+        MDREG_REGRESSOR_LINEAR,
+        MDREG_REGRESSOR_LOGISTIC,
+        MDREG_REGRESSOR_MLP,
+        MDREG_NUM_REGRESSORS
+    };
+    
+    const GRT::UINT k_mdreg_default_num_hidden = 2;
+    
+    // Reads the coefficients of a trained GRT linear or logistic regression module, which GRT keeps protected, by
+    // copying the module into an instance of a subclass
+    template <typename regressifier_type>
+    class ml_mdreg_coefficients : public regressifier_type
+    {
+    public:
+        // row receives the bias followed by the weights
+        bool read(const GRT::Regressifier *module, double *row)
+        {
+            if (!this->deepCopyFrom(module))
+            {
+                return false;
+            }
+            row[0] = this->w0;
+            std::copy(this->w.begin(), this->w.end(), row + 1);
+            return true;
+        }
+    };
+    
+    // GRT::MLP that starts from weights drawn from its own seed. GRT seeds the weights of every neuron from the clock
+    // when it trains, so outputs trained at the same time would start from the same weights and no run could be
+    // repeated. Training is GRT's online back propagation, one random start over all the samples in a seeded order
+    class ml_mdreg_mlp : public GRT::MLP
+    {
+    public:
+        ml_mdreg_mlp(unsigned long long seed)
+        :
+        seed(seed)
+        {}
+        
+        bool train_(GRT::RegressionData &trainingData);
+        
+        using GRT::MLP::train_;
+    
+    private:
+        void start_layer(std::vector<GRT::Neuron> &layer, GRT::Random &random);
+        
+        unsigned long long seed;
+    };
+    
+    bool ml_mdreg_mlp::train_(GRT::RegressionData &trainingData)
+    {
+        const GRT::UINT M = trainingData.getNumSamples();
+        
+        trained = false;
+        
+        if (M == 0 || !initialized || trainingData.getNumInputDimensions() != numInputNeurons || trainingData.getNumTargetDimensions() != numOutputNeurons)
+        {
+            errorLog << "train_(RegressionData &trainingData) - The MLP is not initialised for the training data!" << endl;
+            return false;
+        }
+        
+        GRT::Random random(seed);
+        std::vector<GRT::UINT> order(M);
+        double last_error = 0.0;
+        
+        start_layer(hiddenLayer, random);
+        start_layer(outputLayer, random);
+        
+        for (GRT::UINT i = 0; i < M; ++i)
+        {
+            order[i] = i;
+        }
+        
+        for (GRT::UINT epoch = 0; epoch < maxNumEpochs; ++epoch)
+        {
+            double error = 0.0;
+            
+            for (GRT::UINT i = 0; i < M; ++i)
+            {
+                std::swap(order[i], order[std::min<GRT::UINT>(random.getRandomNumberInt(0, M), M - 1)]);
+            }
+            
+            for (GRT::UINT i = 0; i < M; ++i)
+            {
+                error += back_prop(trainingData[order[i]].getInputVector(), trainingData[order[i]].getTargetVector(), learningRate, momentum);
+            }
+            
+            if (!std::isfinite(error))
+            {
+                errorLog << "train_(RegressionData &trainingData) - The training error is not finite!" << endl;
+                return false;
+            }
+            
+            totalSquaredTrainingError = error;
+            rootMeanSquaredTrainingError = sqrt(error / M);
+            
+            if (epoch + 1 >= minNumEpochs && fabs(rootMeanSquaredTrainingError - last_error) <= minChange)
+            {
+                break;
+            }
+            last_error = rootMeanSquaredTrainingError;
+        }
+        
+        numInputDimensions = numInputNeurons;
+        numOutputDimensions = numOutputNeurons;
+        inputVectorRanges = trainingData.getInputRanges();
+        targetVectorRanges = trainingData.getTargetRanges();
+        regressionData.resize(numOutputNeurons);
+        trained = true;
+        
+        return true;
+    }
+    
+    // Draws the weights and biases of a layer in GRT's initial range [-0.1, 0.1]
+    void ml_mdreg_mlp::start_layer(std::vector<GRT::Neuron> &layer, GRT::Random &random)
+    {
+        for (GRT::UINT j = 0; j < layer.size(); ++j)
+        {
+            GRT::Neuron &neuron = layer[j];
+            
+            for (GRT::UINT k = 0; k < neuron.weights.size(); ++k)
+            {
+                neuron.weights[k] = random.getRandomNumberUniform(-0.1, 0.1);
+                neuron.previousUpdate[k] = 0.0;
+            }
+            neuron.bias = random.getRandomNumberUniform(-0.1, 0.1);
+            neuron.previousBiasUpdate = 0.0;
+        }
+    }
+    
+    // GRT::MultidimensionalRegression that trains its one module per target dimension concurrently on a pool of
+    // workers, and predicts every output in one pass: the input is scaled once and, when the modules are linear or
+    // logistic, their coefficients are packed into one matrix so all outputs come from a single matrix-vector
+    // product. Other modules are run in turn on the shared scaled input. Model files are GRT's own
+    class ml_mdreg_model : public GRT::MultidimensionalRegression
+    {
+    public:
+        ml_mdreg_model()
+        :
+        regressor(MDREG_REGRESSOR_LINEAR),
+        num_hidden(k_mdreg_default_num_hidden),
+        seed(0),
+        mixed_regressors(false)
+        {}
+        
+        bool train_(GRT::RegressionData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        using GRT::MultidimensionalRegression::train_;
+        using GRT::MultidimensionalRegression::predict_;
+        using GRT::MultidimensionalRegression::loadModelFromFile;
+        
+        bool set_regressor(int regressor);
+        
+        bool set_num_hidden(int num_hidden)
+        {
+            if (num_hidden < 1)
+            {
+                return false;
+            }
+            this->num_hidden = num_hidden;
+            return true;
+        }
+        
+        // Seed for the initial weights of MLP outputs, each output drawing from its own stream, 0 seeds from the clock
+        void set_seed(GRT::UINT seed) { this->seed = seed; }
+        
+        mdreg_regressor get_regressor() const { return regressor; }
+        bool get_mixed_regressors() const { return mixed_regressors; }
+        GRT::UINT get_num_hidden() const { return num_hidden; }
+        GRT::UINT get_seed() const { return seed; }
+    
+    protected:
+        unsigned long long get_base_seed() const;
+        bool read_regressor();
+        void build_inference();
+        
+        mdreg_regressor regressor;
+        GRT::UINT num_hidden;
+        GRT::UINT seed;
+        
+        // Set when the loaded modules are not all of one supported type, so the regressor could not be taken from them
+        bool mixed_regressors;
+        
+        // One row of (bias, weights) per output, empty when the modules cannot be packed
+        std::vector<double> coefficients;
+        std::vector<char> logistic;
+        GRT::VectorDouble scaled_input;
+    };
+    
+    bool ml_mdreg_model::set_regressor(int regressor)
+    {
+        if (regressor < 0 || regressor >= MDREG_NUM_REGRESSORS)
+        {
+            return false;
+        }
+        
+        bool success = false;
+        
+        if (regressor == MDREG_REGRESSOR_LINEAR)
+        {
+            success = setRegressionModule(GRT::LinearRegression());
+        }
+        else if (regressor == MDREG_REGRESSOR_LOGISTIC)
+        {
+            success = setRegressionModule(GRT::LogisticRegression());
+        }
+        else
+        {
+            success = setRegressionModule(GRT::MLP());
+        }
+        
+        if (success)
+        {
+            this->regressor = (mdreg_regressor)regressor;
+            clear();
+        }
+        return success;
+    }
+    
+    bool ml_mdreg_model::train_(GRT::RegressionData &trainingData)
+    {
+        const GRT::UINT M = trainingData.getNumSamples();
+        const GRT::UINT N = trainingData.getNumInputDimensions();
+        const GRT::UINT T = trainingData.getNumTargetDimensions();
+        
+        clear();
+        
+        if (M == 0)
+        {
+            errorLog << "train_(RegressionData &trainingData) - Training data has zero samples!" << endl;
+            return false;
+        }
+        
+        if (regressifier == NULL)
+        {
+            errorLog << "train_(RegressionData &trainingData) - The regression module has not been set!" << endl;
+            return false;
+        }
+        
+        numInputDimensions = N;
+        numOutputDimensions = T;
+        inputVectorRanges = trainingData.getInputRanges();
+        targetVectorRanges = trainingData.getTargetRanges();
+        
+        // The modules see data that is already scaled, so they do not scale themselves
+        if (useScaling)
+        {
+            trainingData.scale(inputVectorRanges, targetVectorRanges, 0.0, 1.0);
+        }
+        
+        // Modules are created here rather than on the workers, as GRT's module factory is shared. MLPs are created
+        // directly, as the factory would give back GRT's clock seeded MLP, each seeded from the base seed plus its output
+        // like the restarts of ml.mlp
+        const unsigned long long base_seed = get_base_seed();
+        
+        regressionModules.assign(T, NULL);
+        
+        for (GRT::UINT target = 0; target < T; ++target)
+        {
+            GRT::Regressifier *module = NULL;
+            
+            if (regressor == MDREG_REGRESSOR_MLP)
+            {
+                ml_mdreg_mlp *mlp = new ml_mdreg_mlp(base_seed + target + 1);
+                
+                mlp->init(N, num_hidden, 1);
+                module = mlp;
+            }
+            else
+            {
+                module = regressifier->deepCopy();
+            }
+            
+            if (module == NULL)
+            {
+                errorLog << "train_(RegressionData &trainingData) - Failed to create the regression module for dimension " << target << "!" << endl;
+                clear();
+                return false;
+            }
+            
+            module->enableScaling(false);
+            module->setMaxNumEpochs(maxNumEpochs);
+            module->setMinChange(minChange);
+            module->setLearningRate(learningRate);
+            
+            regressionModules[target] = module;
+        }
+        
+        std::vector<char> trained_modules(T, false);
+        
+        // One task per target dimension, each training on its own single target copy of the data
+        parallel_for(T, [&](unsigned int target, unsigned int)
+        {
+            GRT::RegressionData data(N, 1);
+            GRT::VectorDouble target_vector(1);
+            
+            data.reserve(M);
+            
+            for (GRT::UINT i = 0; i < M; ++i)
+            {
+                target_vector[0] = trainingData[i].getTargetVector()[target];
+                data.addSample(trainingData[i].getInputVector(), target_vector);
+            }
+            
+            trained_modules[target] = regressionModules[target]->train_(data);
+        });
+        
+        totalSquaredTrainingError = 0;
+        
+        for (GRT::UINT target = 0; target < T; ++target)
+        {
+            if (!trained_modules[target])
+            {
+                errorLog << "train_(RegressionData &trainingData) - Failed to train the regression module for dimension " << target << "!" << endl;
+                clear();
+                return false;
+            }
+            
+            totalSquaredTrainingError += regressionModules[target]->getTotalSquaredTrainingError();
+        }
+        
+        rootMeanSquaredTrainingError = sqrt(totalSquaredTrainingError / (M * T));
+        regressionData.resize(T);
+        trained = true;
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_mdreg_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (!trained || regressionModules.size() != numOutputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - Model Not Trained!" << endl;
+            return false;
+        }
+        
+        if (inputVector.size() != numInputDimensions)
+        {
+            errorLog << "predict_(VectorDouble &inputVector) - The size of the input vector (" << inputVector.size() << ") does not match the num features in the model (" << numInputDimensions << ")!" << endl;
+            return false;
+        }
+        
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT T = numOutputDimensions;
+        
+        scaled_input.resize(N);
+        
+        for (GRT::UINT n = 0; n < N; ++n)
+        {
+            scaled_input[n] = useScaling ? scale(inputVector[n], inputVectorRanges[n].minValue, inputVectorRanges[n].maxValue, 0.0, 1.0) : inputVector[n];
+        }
+        
+        regressionData.resize(T);
+        
+        if (!coefficients.empty())
+        {
+            const GRT::UINT P = N + 1;
+            
+            for (GRT::UINT target = 0; target < T; ++target)
+            {
+                const double *row = &coefficients[target * P];
+                double value = row[0];
+                
+                for (GRT::UINT n = 0; n < N; ++n)
+                {
+                    value += row[n + 1] * scaled_input[n];
+                }
+                
+                regressionData[target] = logistic[target] ? 1.0 / (1.0 + exp(-value)) : value;
+            }
+        }
+        else
+        {
+            for (GRT::UINT target = 0; target < T; ++target)
+            {
+                if (!regressionModules[target]->predict_(scaled_input))
+                {
+                    errorLog << "predict_(VectorDouble &inputVector) - Failed to predict dimension " << target << "!" << endl;
+                    return false;
+                }
+                
+                regressionData[target] = regressionModules[target]->getRegressionData()[0];
+            }
+        }
+        
+        if (useScaling)
+        {
+            for (GRT::UINT target = 0; target < T; ++target)
+            {
+                regressionData[target] = scale(regressionData[target], 0.0, 1.0, targetVectorRanges[target].minValue, targetVectorRanges[target].maxValue);
+            }
+        }
+        
+        return true;
+    }
+    
+    unsigned long long ml_mdreg_model::get_base_seed() const
+    {
+        if (seed != 0)
+        {
+            return seed;
+        }
+        
+        GRT::Timer timer;
+        
+        return (unsigned long long)timer.getSystemTime();
+    }
+    
+    bool ml_mdreg_model::loadModelFromFile(fstream &file)
+    {
+        coefficients.clear();
+        mixed_regressors = false;
+        
+        if (!GRT::MultidimensionalRegression::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        if (trained)
+        {
+            mixed_regressors = !read_regressor();
+            build_inference();
+        }
+        return true;
+    }
+    
+    // Takes the regressor, and for MLPs num_hidden, from the loaded modules so the attributes report them and a later
+    // train fits the same kind of model. Returns false, keeping the current regressor, unless the modules are all of one
+    // supported type
+    bool ml_mdreg_model::read_regressor()
+    {
+        mdreg_regressor loaded = MDREG_NUM_REGRESSORS;
+        
+        for (GRT::UINT target = 0; target < regressionModules.size(); ++target)
+        {
+            const GRT::Regressifier *module = regressionModules[target];
+            const std::string type = module == NULL ? "" : module->getRegressifierType();
+            mdreg_regressor module_regressor = MDREG_NUM_REGRESSORS;
+            
+            if (type == "LinearRegression")
+            {
+                module_regressor = MDREG_REGRESSOR_LINEAR;
+            }
+            else if (type == "LogisticRegression")
+            {
+                module_regressor = MDREG_REGRESSOR_LOGISTIC;
+            }
+            else if (type == "MLP")
+            {
+                module_regressor = MDREG_REGRESSOR_MLP;
+            }
+            
+            if (module_regressor == MDREG_NUM_REGRESSORS || (target > 0 && module_regressor != loaded))
+            {
+                return false;
+            }
+            loaded = module_regressor;
+        }
+        
+        if (loaded == MDREG_NUM_REGRESSORS)
+        {
+            return false;
+        }
+        
+        if (loaded == MDREG_REGRESSOR_LINEAR)
+        {
+            setRegressionModule(GRT::LinearRegression());
+        }
+        else if (loaded == MDREG_REGRESSOR_LOGISTIC)
+        {
+            setRegressionModule(GRT::LogisticRegression());
+        }
+        else
+        {
+            const GRT::MLP *mlp = dynamic_cast<const GRT::MLP *>(regressionModules[0]);
+            
+            if (mlp != NULL && mlp->getNumHiddenNeurons() > 0)
+            {
+                num_hidden = mlp->getNumHiddenNeurons();
+            }
+            setRegressionModule(GRT::MLP());
+        }
+        regressor = loaded;
+        
+        return true;
+    }
+    
+    // Packs the coefficients of linear and logistic modules that do not scale themselves, or leaves the packed
+    // coefficients empty so every module predicts for itself
+    void ml_mdreg_model::build_inference()
+    {
+        const GRT::UINT N = numInputDimensions;
+        const GRT::UINT T = numOutputDimensions;
+        const GRT::UINT P = N + 1;
+        
+        coefficients.assign(T * P, 0.0);
+        logistic.assign(T, false);
+        
+        for (GRT::UINT target = 0; target < T; ++target)
+        {
+            const GRT::Regressifier *module = regressionModules[target];
+            double *row = &coefficients[target * P];
+            bool success = false;
+            
+            if (module == NULL || module->getScalingEnabled() || module->getNumInputDimensions() != N)
+            {
+                success = false;
+            }
+            else if (module->getRegressifierType() == "LinearRegression")
+            {
+                ml_mdreg_coefficients<GRT::LinearRegression> reader;
+                
+                success = reader.read(module, row);
+            }
+            else if (module->getRegressifierType() == "LogisticRegression")
+            {
+                ml_mdreg_coefficients<GRT::LogisticRegression> reader;
+                
+                success = reader.read(module, row);
+                logistic[target] = true;
+            }
+            
+            if (!success)
+            {
+                coefficients.clear();
+                logistic.clear();
+                return;
+            }
+        }
+    }
+    
+    bool ml_mdreg_model::clear()
+    {
+        coefficients.clear();
+        logistic.clear();
+        mixed_regressors = false;
+        deleteRegressionModules();
+        
+        return GRT::MultidimensionalRegression::clear();
+    }
+    
+    class ml_mdreg : ml_regression
+    {
+        FLEXT_HEADER_S(ml_mdreg, ml_regression, setup);
+    
+    public:
+        ml_mdreg()
+        {
+            post("Multidimensional Regression based on the GRT library version " + GRT::GRTBase::getGRTVersion());
+            regression_data.setInputAndTargetDimensions(default_num_input_dimensions, default_num_output_dimensions);
+            set_scaling(default_scaling);
+            help.append_attributes(attribute_help);
+        }
+    
+    protected:
+        static void setup(t_classid c)
+        {
+            // Flext attribute set messages
+            FLEXT_CADDATTR_SET(c, "regressor", set_regressor);
+            FLEXT_CADDATTR_SET(c, "num_outputs", set_num_outputs);
+            FLEXT_CADDATTR_SET(c, "num_hidden", set_num_hidden);
+            FLEXT_CADDATTR_SET(c, "seed", set_seed);
+            
+            // Flext attribute get messages
+            FLEXT_CADDATTR_GET(c, "regressor", get_regressor);
+            FLEXT_CADDATTR_GET(c, "num_outputs", get_num_outputs);
+            FLEXT_CADDATTR_GET(c, "num_hidden", get_num_hidden);
+            FLEXT_CADDATTR_GET(c, "seed", get_seed);
+            
+            DefineHelp(c, ml_object_name.c_str());
+        }
+        
+        // Method overrides
+        void read(const t_symbol *path);
+        bool get_training_summary(GRT::UINT num_samples, double seconds, std::stringstream &summary) const;
+        
+        // Flext attribute setters
+        void set_regressor(int regressor);
+        void set_num_outputs(int num_outputs);
+        void set_num_hidden(int num_hidden);
+        void set_seed(int seed);
+        
+        // Flext attribute getters
+        void get_regressor(int &regressor) const;
+        void get_num_outputs(int &num_outputs) const;
+        void get_num_hidden(int &num_hidden) const;
+        void get_seed(int &seed) const;
+        
+        // Implement pure virtual methods
+        GRT::Regressifier &get_Regressifier_instance();
+        const GRT::Regressifier &get_Regressifier_instance() const;
+    
+    private:
+        // Flext attribute wrappers
+        FLEXT_CALLVAR_I(get_regressor, set_regressor);
+        FLEXT_CALLVAR_I(get_num_outputs, set_num_outputs);
+        FLEXT_CALLVAR_I(get_num_hidden, set_num_hidden);
+        FLEXT_CALLVAR_I(get_seed, set_seed);
+        
+        // Virtual method override
+        virtual const std::string get_object_name(void) const { return ml_object_name; };
+        
+        ml_mdreg_model regressifier;
+        
+        static const std::string attribute_help;
+    };
+    
+    // Method overrides
+    void ml_mdreg::read(const t_symbol *path)
+    {
+        ml_regression::read(path);
+        
+        if (regressifier.get_mixed_regressors())
+        {
+            error("the loaded outputs do not all use the same supported regressor, the regressor attribute is unchanged and train will use it for every output");
+        }
+    }
+    
+    bool ml_mdreg::get_training_summary(GRT::UINT, double, std::stringstream &summary) const
+    {
+        const GRT::UINT numOutputs = regression_data.getNumTargetDimensions();
+        
+        summary << ", " << numOutputs << " outputs on " << get_num_workers(numOutputs) << " threads";
+        
+        return true;
+    }
+    
+    // Flext attribute setters
+    void ml_mdreg::set_regressor(int regressor)
+    {
+        bool success = regressifier.set_regressor(regressor);
+        
+        if (success == false)
+        {
+            error("invalid regressor: " + std::to_string(regressor) + ", must be " + std::to_string(MDREG_REGRESSOR_LINEAR) + ":LINEAR, " + std::to_string(MDREG_REGRESSOR_LOGISTIC) + ":LOGISTIC or " + std::to_string(MDREG_REGRESSOR_MLP) + ":MLP");
+        }
+    }
+    
+    void ml_mdreg::set_num_outputs(int num_outputs)
+    {
+        if (num_outputs < 1)
+        {
+            error("number of outputs must be greater than zero");
+            return;
+        }
+        
+        if ((GRT::UINT)num_outputs == regression_data.getNumTargetDimensions())
+        {
+            return;
+        }
+        
+        bool success = regression_data.setInputAndTargetDimensions(regression_data.getNumInputDimensions(), num_outputs);
+        
+        if (success == false)
+        {
+            error("unable to set input and target dimensions");
+        }
+    }
+    
+    void ml_mdreg::set_num_hidden(int num_hidden)
+    {
+        bool success = regressifier.set_num_hidden(num_hidden);
+        
+        if (success == false)
+        {
+            error("unable to set num_hidden, hint: should be greater than 0");
+        }
+    }
+    
+    void ml_mdreg::set_seed(int seed)
+    {
+        if (seed < 0)
+        {
+            error("seed must be 0 or greater");
+            return;
+        }
+        
+        regressifier.set_seed(seed);
+    }
+    
+    // Flext attribute getters
+    void ml_mdreg::get_regressor(int &regressor) const
+    {
+        regressor = regressifier.get_regressor();
+    }
+    
+    void ml_mdreg::get_num_outputs(int &num_outputs) const
+    {
+        num_outputs = regression_data.getNumTargetDimensions();
+    }
+    
+    void ml_mdreg::get_num_hidden(int &num_hidden) const
+    {
+        num_hidden = regressifier.get_num_hidden();
+    }
+    
+    void ml_mdreg::get_seed(int &seed) const
+    {
+        seed = regressifier.get_seed();
+    }
+    
+    // Implement pure virtual methods
+    GRT::Regressifier &ml_mdreg::get_Regressifier_instance()
+    {
+        return regressifier;
+    }
+    
+    const GRT::Regressifier &ml_mdreg::get_Regressifier_instance() const
+    {
+        return regressifier;
+    }
+    
+    const std::string ml_mdreg::attribute_help =
+    "regressor:\tinteger selecting the model fitted to each output, 0:LINEAR linear regression, 1:LOGISTIC logistic regression, 2:MLP multilayer perceptron with one hidden layer; the outputs are trained at the same time on all available cores using max_iterations, min_change and training_rate (default LINEAR)\n"
+    "num_outputs:\tinteger setting the number of outputs, the first values of every 'add' (default " + std::to_string(default_num_output_dimensions) + ")\n"
+    "num_hidden:\tinteger setting the number of hidden neurons of each output's MLP regressor (default " + std::to_string(k_mdreg_default_num_hidden) + ")\n"
+    "seed:\tinteger seeding the initial weights of the MLP regressors, each output from its own stream, any value other than 0 makes training reproducible, 0 seeds from the clock (default 0)\n";
+    
+    typedef class ml_mdreg ml0x2emdreg;
+    
+#ifdef BUILD_AS_LIBRARY
+    FLEXT_LIB(ml_object_name.c_str(), ml_mdreg);
+#else
+    FLEXT_NEW(ml_object_name.c_str(), ml0x2emdreg);
+#endif
+    
+} //namespace ml
+
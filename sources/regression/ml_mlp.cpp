@@ -17,10 +17,12 @@
  */
 
 #include "ml_ml.h"
+#include "ml_parallel.h"
 
 namespace ml
 {
     const GRT::UINT default_num_hidden_neurons = 2;
+    const GRT::UINT default_warm_epochs = 50;
     const std::string ml_object_name = "ml.mlp";
     
     typedef enum mlp_layer_
@@ -32,6 +34,2335 @@ namespace ml
     }
     mlp_layer;
     
+    // Dense multilayer perceptron
+    //
+    // GRT::MLP keeps every neuron as a separate object with its own weight vector and trains one sample at a time.
+    // Here each layer is one contiguous weight matrix, stored input-major (weights[input * num_outputs + output])
+    // so that the inner loops of the matrix products run over outputs and vectorise. A whole mini-batch moves through
+    // a layer as a single blocked matrix-matrix product
+    const GRT::UINT k_mlp_block_rows = 32;
+    const GRT::UINT k_mlp_block_inner = 64;
+    const double k_mlp_initial_weight_range = 0.1;
+    
+    struct mlp_dense_layer
+    {
+        GRT::UINT num_inputs;
+        GRT::UINT num_outputs;
+        GRT::UINT activation;
+        std::vector<double> weights;
+        std::vector<double> biases;
+    };
+    
+    static inline double mlp_activate(double y, GRT::UINT activation, double gamma)
+    {
+        switch (activation)
+        {
+            case GRT::Neuron::SIGMOID:
+                // Same overflow guard as GRT::Neuron::fire()
+                if (y < -45.0)
+                {
+                    return 0.0;
+                }
+                if (y > 45.0)
+                {
+                    return 1.0;
+                }
+                return 1.0 / (1.0 + exp(-y));
+                
+            case GRT::Neuron::BIPOLAR_SIGMOID:
+                return (2.0 / (1.0 + exp(-gamma * y))) - 1.0;
+                
+            default:
+                return y;
+        }
+    }
+    
+    // The derivative expressed in terms of the activation output, as in GRT::Neuron::getDerivative()
+    static inline double mlp_derivative(double y, GRT::UINT activation, double gamma)
+    {
+        switch (activation)
+        {
+            case GRT::Neuron::SIGMOID:
+                return y * (1.0 - y);
+                
+            case GRT::Neuron::BIPOLAR_SIGMOID:
+                return (gamma * (1.0 - y * y)) / 2.0;
+                
+            default:
+                return 1.0;
+        }
+    }
+    
+    static void mlp_activate_block(double *values, GRT::UINT count, GRT::UINT activation, double gamma)
+    {
+        if (activation == GRT::Neuron::LINEAR)
+        {
+            return;
+        }
+        
+        for (GRT::UINT index = 0; index < count; ++index)
+        {
+            values[index] = mlp_activate(values[index], activation, gamma);
+        }
+    }
+    
+    // c (rows x n) = a (rows x k) * b (k x n) + bias
+    static void mlp_gemm_bias(const double *a, const double *b, const double *bias, double *c, GRT::UINT rows, GRT::UINT k, GRT::UINT n)
+    {
+        for (GRT::UINT row = 0; row < rows; ++row)
+        {
+            std::copy(bias, bias + n, c + row * n);
+        }
+        
+        for (GRT::UINT row_block = 0; row_block < rows; row_block += k_mlp_block_rows)
+        {
+            const GRT::UINT row_end = std::min(rows, row_block + k_mlp_block_rows);
+            
+            for (GRT::UINT inner_block = 0; inner_block < k; inner_block += k_mlp_block_inner)
+            {
+                const GRT::UINT inner_end = std::min(k, inner_block + k_mlp_block_inner);
+                
+                for (GRT::UINT row = row_block; row < row_end; ++row)
+                {
+                    const double *a_row = a + row * k;
+                    double *c_row = c + row * n;
+                    
+                    for (GRT::UINT inner = inner_block; inner < inner_end; ++inner)
+                    {
+                        const double a_value = a_row[inner];
+                        const double *b_row = b + inner * n;
+                        
+                        for (GRT::UINT column = 0; column < n; ++column)
+                        {
+                            c_row[column] += a_value * b_row[column];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    // c (k x n) += a^T (k x rows) * d (rows x n)
+    static void mlp_gemm_transpose_a(const double *a, const double *d, double *c, GRT::UINT rows, GRT::UINT k, GRT::UINT n)
+    {
+        for (GRT::UINT inner_block = 0; inner_block < k; inner_block += k_mlp_block_inner)
+        {
+            const GRT::UINT inner_end = std::min(k, inner_block + k_mlp_block_inner);
+            
+            for (GRT::UINT row = 0; row < rows; ++row)
+            {
+                const double *a_row = a + row * k;
+                const double *d_row = d + row * n;
+                
+                for (GRT::UINT inner = inner_block; inner < inner_end; ++inner)
+                {
+                    const double a_value = a_row[inner];
+                    double *c_row = c + inner * n;
+                    
+                    for (GRT::UINT column = 0; column < n; ++column)
+                    {
+                        c_row[column] += a_value * d_row[column];
+                    }
+                }
+            }
+        }
+    }
+    
+    // c (rows x k) = d (rows x n) * b^T (n x k)
+    static void mlp_gemm_transpose_b(const double *d, const double *b, double *c, GRT::UINT rows, GRT::UINT k, GRT::UINT n)
+    {
+        for (GRT::UINT row_block = 0; row_block < rows; row_block += k_mlp_block_rows)
+        {
+            const GRT::UINT row_end = std::min(rows, row_block + k_mlp_block_rows);
+            
+            for (GRT::UINT inner = 0; inner < k; ++inner)
+            {
+                const double *b_row = b + inner * n;
+                
+                for (GRT::UINT row = row_block; row < row_end; ++row)
+                {
+                    const double *d_row = d + row * n;
+                    double sum = 0.0;
+                    
+                    for (GRT::UINT column = 0; column < n; ++column)
+                    {
+                        sum += d_row[column] * b_row[column];
+                    }
+                    c[row * k + inner] = sum;
+                }
+            }
+        }
+    }
+    
+    class mlp_dense_network
+    {
+    public:
+        mlp_dense_network() : num_inputs(0), input_activation(GRT::Neuron::LINEAR), gamma(0) {}
+        
+        // layer_sizes holds the number of neurons in each hidden layer followed by the number of outputs
+        void init(GRT::UINT num_inputs, const std::vector<GRT::UINT> &layer_sizes, GRT::UINT input_activation, const std::vector<GRT::UINT> &activations, double gamma, GRT::Random &random);
+        
+        GRT::UINT get_num_inputs() const { return num_inputs; }
+        GRT::UINT get_num_outputs() const { return layers.empty() ? 0 : layers.back().num_outputs; }
+        GRT::UINT get_num_layers() const { return (GRT::UINT)layers.size(); }
+        bool has_nan() const;
+        
+        GRT::UINT num_inputs;
+        GRT::UINT input_activation;
+        double gamma;
+        
+        // GRT's input layer has a (normally untrained) weight and bias per input
+        std::vector<double> input_weights;
+        std::vector<double> input_biases;
+        std::vector<mlp_dense_layer> layers;
+    };
+    
+    void mlp_dense_network::init(GRT::UINT num_inputs, const std::vector<GRT::UINT> &layer_sizes, GRT::UINT input_activation, const std::vector<GRT::UINT> &activations, double gamma, GRT::Random &random)
+    {
+        this->num_inputs = num_inputs;
+        this->input_activation = input_activation;
+        this->gamma = gamma;
+        
+        input_weights.assign(num_inputs, 1.0);
+        input_biases.assign(num_inputs, 0.0);
+        layers.resize(layer_sizes.size());
+        
+        GRT::UINT layer_inputs = num_inputs;
+        
+        for (GRT::UINT index = 0; index < layers.size(); ++index)
+        {
+            mlp_dense_layer &layer = layers[index];
+            
+            layer.num_inputs = layer_inputs;
+            layer.num_outputs = layer_sizes[index];
+            layer.activation = activations[index];
+            layer.weights.resize(layer.num_inputs * layer.num_outputs);
+            layer.biases.resize(layer.num_outputs);
+            
+            // Same initial range as GRT::Neuron::init()
+            for (GRT::UINT weight = 0; weight < layer.weights.size(); ++weight)
+            {
+                layer.weights[weight] = random.getRandomNumberUniform(-k_mlp_initial_weight_range, k_mlp_initial_weight_range);
+            }
+            for (GRT::UINT bias = 0; bias < layer.biases.size(); ++bias)
+            {
+                layer.biases[bias] = random.getRandomNumberUniform(-k_mlp_initial_weight_range, k_mlp_initial_weight_range);
+            }
+            
+            layer_inputs = layer.num_outputs;
+        }
+    }
+    
+    bool mlp_dense_network::has_nan() const
+    {
+        for (GRT::UINT index = 0; index < layers.size(); ++index)
+        {
+            const mlp_dense_layer &layer = layers[index];
+            
+            for (GRT::UINT weight = 0; weight < layer.weights.size(); ++weight)
+            {
+                if (layer.weights[weight] != layer.weights[weight])
+                {
+                    return true;
+                }
+            }
+            for (GRT::UINT bias = 0; bias < layer.biases.size(); ++bias)
+            {
+                if (layer.biases[bias] != layer.biases[bias])
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    
+    // Contiguous copy of a (scaled) RegressionData set, one row per sample
+    struct mlp_dataset
+    {
+        mlp_dataset() : num_samples(0), num_inputs(0), num_targets(0) {}
+        
+        // Copies the samples of data listed in indices, in that order
+        void assign(const GRT::RegressionData &data, const std::vector<GRT::UINT> &indices)
+        {
+            num_samples = (GRT::UINT)indices.size();
+            num_inputs = data.getNumInputDimensions();
+            num_targets = data.getNumTargetDimensions();
+            inputs.resize(num_samples * num_inputs);
+            targets.resize(num_samples * num_targets);
+            
+            for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+            {
+                const GRT::VectorDouble &input = data[indices[sample]].getInputVector();
+                const GRT::VectorDouble &target = data[indices[sample]].getTargetVector();
+                
+                std::copy(input.begin(), input.end(), &inputs[sample * num_inputs]);
+                std::copy(target.begin(), target.end(), &targets[sample * num_targets]);
+            }
+        }
+        
+        GRT::UINT num_samples;
+        GRT::UINT num_inputs;
+        GRT::UINT num_targets;
+        std::vector<double> inputs;
+        std::vector<double> targets;
+    };
+    
+    typedef enum mlp_optimiser_
+    {
+        OPTIMISER_SGD,
+        OPTIMISER_RMSPROP,
+        OPTIMISER_ADAM,
+        MLP_NUM_OPTIMISERS
+    }
+    mlp_optimiser;
+    
+    typedef enum mlp_rate_schedule_
+    {
+        SCHEDULE_CONSTANT,
+        SCHEDULE_EXPONENTIAL,
+        SCHEDULE_COSINE,
+        MLP_NUM_RATE_SCHEDULES
+    }
+    mlp_rate_schedule;
+    
+    const double k_mlp_rmsprop_decay = 0.9;
+    const double k_mlp_adam_beta1 = 0.9;
+    const double k_mlp_adam_beta2 = 0.999;
+    const double k_mlp_optimiser_epsilon = 1.0e-8;
+    
+    struct mlp_training_settings
+    {
+        GRT::UINT batch_size;
+        GRT::UINT min_epochs;
+        GRT::UINT max_epochs;
+        double min_change;
+        double learning_rate;
+        double momentum;
+        bool randomise_order;
+        mlp_optimiser optimiser;
+        mlp_rate_schedule rate_schedule;
+        double rate_decay;
+        GRT::UINT patience;
+        double target_error;
+        bool log_errors;
+    };
+    
+    // Mini-batch gradient descent
+    //
+    // With OPTIMISER_SGD the update rule is GRT's back_prop() averaged over the batch, update = rate * (momentum *
+    // previous_update + (1 - momentum) * gradient), so a batch size of 1 is equivalent to GRT's online training.
+    // RMSProp and Adam scale each weight's step by a running estimate of its gradient magnitude. Convergence uses
+    // GRT's test on the change in total squared training error between epochs, optionally combined with patience
+    // based early stopping on the validation error and a target error
+    class mlp_trainer
+    {
+    public:
+        mlp_trainer(const mlp_training_settings &settings) : settings(settings), num_epochs(0), target_epoch(0), num_updates(0), training_error(0), validation_error(0), target_time(0) {}
+        
+        // Returns false if the network weights diverged
+        bool train(mlp_dense_network &network, const mlp_dataset &training, const mlp_dataset &validation, GRT::Random &random);
+        
+        // Root mean squared error per sample over the data set
+        double get_rms_error(const mlp_dense_network &network, const mlp_dataset &data);
+        
+        // Percentage of samples whose largest output matches the largest target
+        double get_accuracy(const mlp_dense_network &network, const mlp_dataset &data);
+        
+        GRT::UINT get_num_epochs() const { return num_epochs; }
+        double get_training_error() const { return training_error; }
+        double get_validation_error() const { return validation_error; }
+        
+        // Epoch and elapsed milliseconds at which the target error was first reached, 0 if it was not
+        GRT::UINT get_target_epoch() const { return target_epoch; }
+        double get_target_time() const { return target_time; }
+        
+        // Per-epoch RMS errors, filled if settings.log_errors is set. The validation log is empty without validation data
+        const GRT::VectorDouble &get_training_log() const { return training_log; }
+        const GRT::VectorDouble &get_validation_log() const { return validation_log; }
+        
+    private:
+        void reserve(const mlp_dense_network &network, GRT::UINT batch_size);
+        void reset_optimiser(const mlp_dense_network &network);
+        double get_learning_rate() const;
+        void forward(const mlp_dense_network &network, const double *inputs, GRT::UINT batch_size);
+        double backward(mlp_dense_network &network, const double *targets, GRT::UINT batch_size);
+        void update(mlp_dense_network &network, GRT::UINT batch_size);
+        
+        mlp_training_settings settings;
+        GRT::UINT num_epochs;
+        GRT::UINT target_epoch;
+        GRT::UINT num_updates;
+        double training_error;
+        double validation_error;
+        double target_time;
+        GRT::VectorDouble training_log;
+        GRT::VectorDouble validation_log;
+        
+        // activations[0] is the output of the input layer, activations[l + 1] the output of layer l
+        std::vector< std::vector<double> > activations;
+        std::vector< std::vector<double> > deltas;
+        std::vector< std::vector<double> > weight_gradients;
+        std::vector< std::vector<double> > bias_gradients;
+        // First moments (the previous update for SGD) and second moments of the gradients, per layer
+        std::vector< std::vector<double> > weight_updates;
+        std::vector< std::vector<double> > bias_updates;
+        std::vector< std::vector<double> > weight_moments;
+        std::vector< std::vector<double> > bias_moments;
+        std::vector<double> batch_inputs;
+        std::vector<double> batch_targets;
+        std::vector<GRT::UINT> order;
+    };
+    
+    // Sizes the per-batch workspace, growing it if needed. Optimiser state is kept
+    void mlp_trainer::reserve(const mlp_dense_network &network, GRT::UINT batch_size)
+    {
+        const GRT::UINT num_layers = network.get_num_layers();
+        
+        activations.resize(num_layers + 1);
+        deltas.resize(num_layers + 1);
+        weight_gradients.resize(num_layers);
+        bias_gradients.resize(num_layers);
+        
+        activations[0].resize(std::max<size_t>(activations[0].size(), batch_size * network.num_inputs));
+        deltas[0].resize(std::max<size_t>(deltas[0].size(), batch_size * network.num_inputs));
+        
+        for (GRT::UINT index = 0; index < num_layers; ++index)
+        {
+            const mlp_dense_layer &layer = network.layers[index];
+            
+            activations[index + 1].resize(std::max<size_t>(activations[index + 1].size(), batch_size * layer.num_outputs));
+            deltas[index + 1].resize(std::max<size_t>(deltas[index + 1].size(), batch_size * layer.num_outputs));
+            weight_gradients[index].resize(layer.weights.size());
+            bias_gradients[index].resize(layer.biases.size());
+        }
+    }
+    
+    void mlp_trainer::reset_optimiser(const mlp_dense_network &network)
+    {
+        const GRT::UINT num_layers = network.get_num_layers();
+        
+        num_updates = 0;
+        weight_updates.resize(num_layers);
+        bias_updates.resize(num_layers);
+        weight_moments.resize(num_layers);
+        bias_moments.resize(num_layers);
+        
+        for (GRT::UINT index = 0; index < num_layers; ++index)
+        {
+            const mlp_dense_layer &layer = network.layers[index];
+            
+            weight_updates[index].assign(layer.weights.size(), 0.0);
+            bias_updates[index].assign(layer.biases.size(), 0.0);
+            weight_moments[index].assign(layer.weights.size(), 0.0);
+            bias_moments[index].assign(layer.biases.size(), 0.0);
+        }
+    }
+    
+    double mlp_trainer::get_learning_rate() const
+    {
+        switch (settings.rate_schedule)
+        {
+            case SCHEDULE_EXPONENTIAL:
+                return settings.learning_rate * pow(settings.rate_decay, (double)num_epochs);
+                
+            case SCHEDULE_COSINE:
+                return settings.learning_rate * 0.5 * (1.0 + cos(M_PI * std::min(num_epochs, settings.max_epochs) / std::max<GRT::UINT>(1, settings.max_epochs)));
+                
+            default:
+                return settings.learning_rate;
+        }
+    }
+    
+    void mlp_trainer::forward(const mlp_dense_network &network, const double *inputs, GRT::UINT batch_size)
+    {
+        const GRT::UINT num_inputs = network.num_inputs;
+        double *input_layer = &activations[0][0];
+        
+        for (GRT::UINT row = 0; row < batch_size; ++row)
+        {
+            for (GRT::UINT input = 0; input < num_inputs; ++input)
+            {
+                const double y = inputs[row * num_inputs + input] * network.input_weights[input] + network.input_biases[input];
+                input_layer[row * num_inputs + input] = mlp_activate(y, network.input_activation, network.gamma);
+            }
+        }
+        
+        for (GRT::UINT index = 0; index < network.get_num_layers(); ++index)
+        {
+            const mlp_dense_layer &layer = network.layers[index];
+            double *output = &activations[index + 1][0];
+            
+            mlp_gemm_bias(&activations[index][0], &layer.weights[0], &layer.biases[0], output, batch_size, layer.num_inputs, layer.num_outputs);
+            mlp_activate_block(output, batch_size * layer.num_outputs, layer.activation, network.gamma);
+        }
+    }
+    
+    double mlp_trainer::backward(mlp_dense_network &network, const double *targets, GRT::UINT batch_size)
+    {
+        const GRT::UINT num_layers = network.get_num_layers();
+        const GRT::UINT num_outputs = network.get_num_outputs();
+        const double *output = &activations[num_layers][0];
+        double *output_delta = &deltas[num_layers][0];
+        double squared_error = 0.0;
+        
+        for (GRT::UINT index = 0; index < batch_size * num_outputs; ++index)
+        {
+            const double error = targets[index] - output[index];
+            output_delta[index] = mlp_derivative(output[index], network.layers.back().activation, network.gamma) * error;
+            squared_error += error * error;
+        }
+        
+        // Gradients for every layer are computed before any weights change, as in GRT's back_prop()
+        for (GRT::UINT index = num_layers; index-- > 0;)
+        {
+            const mlp_dense_layer &layer = network.layers[index];
+            const double *delta = &deltas[index + 1][0];
+            std::vector<double> &weight_gradient = weight_gradients[index];
+            std::vector<double> &bias_gradient = bias_gradients[index];
+            
+            std::fill(weight_gradient.begin(), weight_gradient.end(), 0.0);
+            std::fill(bias_gradient.begin(), bias_gradient.end(), 0.0);
+            
+            mlp_gemm_transpose_a(&activations[index][0], delta, &weight_gradient[0], batch_size, layer.num_inputs, layer.num_outputs);
+            
+            for (GRT::UINT row = 0; row < batch_size; ++row)
+            {
+                for (GRT::UINT neuron = 0; neuron < layer.num_outputs; ++neuron)
+                {
+                    bias_gradient[neuron] += delta[row * layer.num_outputs + neuron];
+                }
+            }
+            
+            // The input layer is not trained so its delta is not needed
+            if (index > 0)
+            {
+                double *previous_delta = &deltas[index][0];
+                const double *previous_output = &activations[index][0];
+                const GRT::UINT previous_activation = network.layers[index - 1].activation;
+                
+                mlp_gemm_transpose_b(delta, &layer.weights[0], previous_delta, batch_size, layer.num_inputs, layer.num_outputs);
+                
+                for (GRT::UINT value = 0; value < batch_size * layer.num_inputs; ++value)
+                {
+                    previous_delta[value] *= mlp_derivative(previous_output[value], previous_activation, network.gamma);
+                }
+            }
+        }
+        
+        return squared_error;
+    }
+    
+    // Applies the gradients of the last call to backward(), which are sums over the batch
+    void mlp_trainer::update(mlp_dense_network &network, GRT::UINT batch_size)
+    {
+        const double rate = get_learning_rate();
+        const double gradient_scale = 1.0 / batch_size;
+        
+        ++num_updates;
+        
+        for (GRT::UINT index = 0; index < network.get_num_layers(); ++index)
+        {
+            mlp_dense_layer &layer = network.layers[index];
+            
+            // Weights and biases are updated identically, so treat them as two parameter blocks
+            for (GRT::UINT block = 0; block < 2; ++block)
+            {
+                std::vector<double> &parameters = block == 0 ? layer.weights : layer.biases;
+                std::vector<double> &first = block == 0 ? weight_updates[index] : bias_updates[index];
+                std::vector<double> &second = block == 0 ? weight_moments[index] : bias_moments[index];
+                const std::vector<double> &gradient = block == 0 ? weight_gradients[index] : bias_gradients[index];
+                const GRT::UINT num_parameters = (GRT::UINT)parameters.size();
+                
+                switch (settings.optimiser)
+                {
+                    case OPTIMISER_RMSPROP:
+                        for (GRT::UINT parameter = 0; parameter < num_parameters; ++parameter)
+                        {
+                            const double g = gradient_scale * gradient[parameter];
+                            
+                            second[parameter] = k_mlp_rmsprop_decay * second[parameter] + (1.0 - k_mlp_rmsprop_decay) * g * g;
+                            parameters[parameter] += rate * g / (sqrt(second[parameter]) + k_mlp_optimiser_epsilon);
+                        }
+                        break;
+                        
+                    case OPTIMISER_ADAM:
+                    {
+                        const double first_correction = 1.0 / (1.0 - pow(k_mlp_adam_beta1, (double)num_updates));
+                        const double second_correction = 1.0 / (1.0 - pow(k_mlp_adam_beta2, (double)num_updates));
+                        
+                        for (GRT::UINT parameter = 0; parameter < num_parameters; ++parameter)
+                        {
+                            const double g = gradient_scale * gradient[parameter];
+                            
+                            first[parameter] = k_mlp_adam_beta1 * first[parameter] + (1.0 - k_mlp_adam_beta1) * g;
+                            second[parameter] = k_mlp_adam_beta2 * second[parameter] + (1.0 - k_mlp_adam_beta2) * g * g;
+                            parameters[parameter] += rate * (first[parameter] * first_correction) / (sqrt(second[parameter] * second_correction) + k_mlp_optimiser_epsilon);
+                        }
+                        break;
+                    }
+                        
+                    default:
+                    {
+                        const double momentum = settings.momentum;
+                        const double scale = (1.0 - momentum) * gradient_scale;
+                        
+                        for (GRT::UINT parameter = 0; parameter < num_parameters; ++parameter)
+                        {
+                            first[parameter] = rate * (momentum * first[parameter] + scale * gradient[parameter]);
+                            parameters[parameter] += first[parameter];
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    
+    double mlp_trainer::get_rms_error(const mlp_dense_network &network, const mlp_dataset &data)
+    {
+        if (data.num_samples == 0)
+        {
+            return 0.0;
+        }
+        
+        const GRT::UINT batch_size = std::max<GRT::UINT>(settings.batch_size, k_mlp_block_rows);
+        const GRT::UINT num_outputs = network.get_num_outputs();
+        double squared_error = 0.0;
+        
+        reserve(network, batch_size);
+        
+        for (GRT::UINT start = 0; start < data.num_samples; start += batch_size)
+        {
+            const GRT::UINT rows = std::min(batch_size, data.num_samples - start);
+            const double *output = &activations[network.get_num_layers()][0];
+            const double *targets = &data.targets[start * num_outputs];
+            
+            forward(network, &data.inputs[start * data.num_inputs], rows);
+            
+            for (GRT::UINT index = 0; index < rows * num_outputs; ++index)
+            {
+                const double error = targets[index] - output[index];
+                squared_error += error * error;
+            }
+        }
+        
+        return sqrt(squared_error / data.num_samples);
+    }
+    
+    double mlp_trainer::get_accuracy(const mlp_dense_network &network, const mlp_dataset &data)
+    {
+        if (data.num_samples == 0)
+        {
+            return 0.0;
+        }
+        
+        const GRT::UINT batch_size = std::max<GRT::UINT>(settings.batch_size, k_mlp_block_rows);
+        const GRT::UINT num_outputs = network.get_num_outputs();
+        GRT::UINT num_correct = 0;
+        
+        reserve(network, batch_size);
+        
+        for (GRT::UINT start = 0; start < data.num_samples; start += batch_size)
+        {
+            const GRT::UINT rows = std::min(batch_size, data.num_samples - start);
+            
+            forward(network, &data.inputs[start * data.num_inputs], rows);
+            
+            for (GRT::UINT row = 0; row < rows; ++row)
+            {
+                const double *output = &activations[network.get_num_layers()][row * num_outputs];
+                const double *target = &data.targets[(start + row) * num_outputs];
+                
+                if (std::max_element(output, output + num_outputs) - output == std::max_element(target, target + num_outputs) - target)
+                {
+                    ++num_correct;
+                }
+            }
+        }
+        
+        return num_correct * 100.0 / data.num_samples;
+    }
+    
+    bool mlp_trainer::train(mlp_dense_network &network, const mlp_dataset &training, const mlp_dataset &validation, GRT::Random &random)
+    {
+        const GRT::UINT num_samples = training.num_samples;
+        const GRT::UINT num_inputs = training.num_inputs;
+        const GRT::UINT num_targets = training.num_targets;
+        const GRT::UINT batch_size = std::max<GRT::UINT>(1, std::min(settings.batch_size, num_samples));
+        const bool track_validation = validation.num_samples > 0 && (settings.patience > 0 || settings.target_error > 0 || settings.log_errors);
+        double last_error = 0.0;
+        double best_error = 0.0;
+        GRT::UINT epochs_since_best = 0;
+        mlp_dense_network best_network;
+        GRT::Timer timer;
+        
+        num_epochs = 0;
+        target_epoch = 0;
+        target_time = 0.0;
+        training_error = 0.0;
+        validation_error = 0.0;
+        training_log.clear();
+        validation_log.clear();
+        
+        if (num_samples == 0)
+        {
+            return false;
+        }
+        
+        timer.start();
+        reserve(network, batch_size);
+        reset_optimiser(network);
+        batch_inputs.resize(batch_size * num_inputs);
+        batch_targets.resize(batch_size * num_targets);
+        order.resize(num_samples);
+        
+        for (GRT::UINT sample = 0; sample < num_samples; ++sample)
+        {
+            order[sample] = sample;
+        }
+        
+        bool keep_training = true;
+        
+        while (keep_training)
+        {
+            if (settings.randomise_order)
+            {
+                for (GRT::UINT sample = num_samples - 1; sample > 0; --sample)
+                {
+                    std::swap(order[sample], order[random.getRandomNumberInt(0, sample + 1)]);
+                }
+            }
+            
+            double total_error = 0.0;
+            
+            for (GRT::UINT start = 0; start < num_samples; start += batch_size)
+            {
+                const GRT::UINT rows = std::min(batch_size, num_samples - start);
+                
+                for (GRT::UINT row = 0; row < rows; ++row)
+                {
+                    const GRT::UINT sample = order[start + row];
+                    
+                    std::copy(&training.inputs[sample * num_inputs], &training.inputs[sample * num_inputs] + num_inputs, &batch_inputs[row * num_inputs]);
+                    std::copy(&training.targets[sample * num_targets], &training.targets[sample * num_targets] + num_targets, &batch_targets[row * num_targets]);
+                }
+                
+                forward(network, &batch_inputs[0], rows);
+                total_error += backward(network, &batch_targets[0], rows);
+                update(network, rows);
+            }
+            
+            if (network.has_nan())
+            {
+                return false;
+            }
+            
+            ++num_epochs;
+            training_error = sqrt(total_error / num_samples);
+            
+            if (track_validation)
+            {
+                validation_error = get_rms_error(network, validation);
+            }
+            
+            if (settings.log_errors)
+            {
+                training_log.push_back(training_error);
+                
+                if (track_validation)
+                {
+                    validation_log.push_back(validation_error);
+                }
+            }
+            
+            const double delta = fabs(total_error - last_error);
+            const double monitored_error = track_validation ? validation_error : training_error;
+            
+            last_error = total_error;
+            
+            if (delta <= settings.min_change && num_epochs >= settings.min_epochs)
+            {
+                keep_training = false;
+            }
+            
+            if (num_epochs >= settings.max_epochs)
+            {
+                keep_training = false;
+            }
+            
+            if (settings.target_error > 0 && monitored_error <= settings.target_error)
+            {
+                target_epoch = num_epochs;
+                target_time = timer.getMilliSeconds();
+                keep_training = false;
+            }
+            
+            if (settings.patience > 0)
+            {
+                if (num_epochs == 1 || monitored_error < best_error)
+                {
+                    best_error = monitored_error;
+                    best_network = network;
+                    epochs_since_best = 0;
+                }
+                else if (++epochs_since_best >= settings.patience && num_epochs >= settings.min_epochs)
+                {
+                    keep_training = false;
+                }
+            }
+        }
+        
+        // Early stopping restores the weights from the epoch with the lowest monitored error
+        if (settings.patience > 0 && epochs_since_best > 0)
+        {
+            network = best_network;
+            training_error = get_rms_error(network, training);
+        }
+        
+        if (validation.num_samples > 0)
+        {
+            validation_error = get_rms_error(network, validation);
+        }
+        
+        return true;
+    }
+    
+    // Small-network forward kernels
+    //
+    // Most patches use tiny networks, so the forward pass is specialised at compile time for common layer sizes and
+    // activation functions. With sizes and activations fixed the loops unroll, the activation switch folds away and
+    // the intermediate layers live on the stack. Other shapes, or a non-linear input layer, use a generic loop over
+    // the same flat weight layout: input weights, input biases, hidden weights (input-major), hidden biases, output
+    // weights (hidden-major), output biases
+    typedef void (*mlp_small_kernel)(const double *weights, double gamma, const double *input, double *output);
+    
+    template <GRT::UINT I, GRT::UINT H, GRT::UINT O, GRT::UINT HA, GRT::UINT OA>
+    static void mlp_small_forward(const double *weights, double gamma, const double *input, double *output)
+    {
+        const double *input_weights = weights;
+        const double *input_biases = input_weights + I;
+        const double *hidden_weights = input_biases + I;
+        const double *hidden_biases = hidden_weights + I * H;
+        const double *output_weights = hidden_biases + H;
+        const double *output_biases = output_weights + H * O;
+        double hidden[H];
+        
+        for (GRT::UINT neuron = 0; neuron < H; ++neuron)
+        {
+            hidden[neuron] = hidden_biases[neuron];
+        }
+        
+        // The specialised kernels are only used with a linear input layer
+        for (GRT::UINT in = 0; in < I; ++in)
+        {
+            const double x = input[in] * input_weights[in] + input_biases[in];
+            
+            for (GRT::UINT neuron = 0; neuron < H; ++neuron)
+            {
+                hidden[neuron] += x * hidden_weights[in * H + neuron];
+            }
+        }
+        
+        for (GRT::UINT neuron = 0; neuron < H; ++neuron)
+        {
+            hidden[neuron] = mlp_activate(hidden[neuron], HA, gamma);
+        }
+        
+        for (GRT::UINT out = 0; out < O; ++out)
+        {
+            output[out] = output_biases[out];
+        }
+        
+        for (GRT::UINT neuron = 0; neuron < H; ++neuron)
+        {
+            for (GRT::UINT out = 0; out < O; ++out)
+            {
+                output[out] += hidden[neuron] * output_weights[neuron * O + out];
+            }
+        }
+        
+        for (GRT::UINT out = 0; out < O; ++out)
+        {
+            output[out] = mlp_activate(output[out], OA, gamma);
+        }
+    }
+    
+    template <GRT::UINT I, GRT::UINT H, GRT::UINT O>
+    static mlp_small_kernel mlp_select_activations(GRT::UINT hidden_activation, GRT::UINT output_activation)
+    {
+        const GRT::UINT output_linear = output_activation == GRT::Neuron::LINEAR;
+        const GRT::UINT output_sigmoid = output_activation == GRT::Neuron::SIGMOID;
+        
+        switch (hidden_activation)
+        {
+            case GRT::Neuron::LINEAR:
+                return output_linear ? mlp_small_forward<I, H, O, GRT::Neuron::LINEAR, GRT::Neuron::LINEAR> : output_sigmoid ? mlp_small_forward<I, H, O, GRT::Neuron::LINEAR, GRT::Neuron::SIGMOID> : NULL;
+            case GRT::Neuron::SIGMOID:
+                return output_linear ? mlp_small_forward<I, H, O, GRT::Neuron::SIGMOID, GRT::Neuron::LINEAR> : output_sigmoid ? mlp_small_forward<I, H, O, GRT::Neuron::SIGMOID, GRT::Neuron::SIGMOID> : NULL;
+            case GRT::Neuron::BIPOLAR_SIGMOID:
+                return output_linear ? mlp_small_forward<I, H, O, GRT::Neuron::BIPOLAR_SIGMOID, GRT::Neuron::LINEAR> : output_sigmoid ? mlp_small_forward<I, H, O, GRT::Neuron::BIPOLAR_SIGMOID, GRT::Neuron::SIGMOID> : NULL;
+            default:
+                return NULL;
+        }
+    }
+    
+    template <GRT::UINT I, GRT::UINT H>
+    static mlp_small_kernel mlp_select_outputs(GRT::UINT num_outputs, GRT::UINT hidden_activation, GRT::UINT output_activation)
+    {
+        switch (num_outputs)
+        {
+            case 1: return mlp_select_activations<I, H, 1>(hidden_activation, output_activation);
+            case 2: return mlp_select_activations<I, H, 2>(hidden_activation, output_activation);
+            case 4: return mlp_select_activations<I, H, 4>(hidden_activation, output_activation);
+            default: return NULL;
+        }
+    }
+    
+    template <GRT::UINT I>
+    static mlp_small_kernel mlp_select_hidden(GRT::UINT num_hidden, GRT::UINT num_outputs, GRT::UINT hidden_activation, GRT::UINT output_activation)
+    {
+        switch (num_hidden)
+        {
+            case 2: return mlp_select_outputs<I, 2>(num_outputs, hidden_activation, output_activation);
+            case 4: return mlp_select_outputs<I, 4>(num_outputs, hidden_activation, output_activation);
+            case 8: return mlp_select_outputs<I, 8>(num_outputs, hidden_activation, output_activation);
+            case 16: return mlp_select_outputs<I, 16>(num_outputs, hidden_activation, output_activation);
+            default: return NULL;
+        }
+    }
+    
+    // Returns NULL if there is no specialised kernel for the shape
+    static mlp_small_kernel mlp_select_kernel(GRT::UINT num_inputs, GRT::UINT num_hidden, GRT::UINT num_outputs, GRT::UINT input_activation, GRT::UINT hidden_activation, GRT::UINT output_activation)
+    {
+        if (input_activation != GRT::Neuron::LINEAR)
+        {
+            return NULL;
+        }
+        
+        switch (num_inputs)
+        {
+            case 2: return mlp_select_hidden<2>(num_hidden, num_outputs, hidden_activation, output_activation);
+            case 3: return mlp_select_hidden<3>(num_hidden, num_outputs, hidden_activation, output_activation);
+            case 4: return mlp_select_hidden<4>(num_hidden, num_outputs, hidden_activation, output_activation);
+            case 6: return mlp_select_hidden<6>(num_hidden, num_outputs, hidden_activation, output_activation);
+            case 8: return mlp_select_hidden<8>(num_hidden, num_outputs, hidden_activation, output_activation);
+            default: return NULL;
+        }
+    }
+    
+    class mlp_small_network
+    {
+    public:
+        mlp_small_network() : num_inputs(0), num_hidden(0), num_outputs(0), input_activation(0), hidden_activation(0), output_activation(0), gamma(0), kernel(NULL) {}
+        
+        // network must have a single hidden layer
+        void build(const mlp_dense_network &network);
+        void clear() { weights.clear(); kernel = NULL; }
+        bool is_built() const { return !weights.empty(); }
+        bool is_specialised() const { return kernel != NULL; }
+        GRT::UINT get_num_outputs() const { return num_outputs; }
+        
+        void forward(const double *input, double *output)
+        {
+            if (kernel)
+            {
+                kernel(&weights[0], gamma, input, output);
+                return;
+            }
+            forward_generic(input, output);
+        }
+        
+    private:
+        void forward_generic(const double *input, double *output);
+        
+        GRT::UINT num_inputs;
+        GRT::UINT num_hidden;
+        GRT::UINT num_outputs;
+        GRT::UINT input_activation;
+        GRT::UINT hidden_activation;
+        GRT::UINT output_activation;
+        double gamma;
+        std::vector<double> weights;
+        std::vector<double> inputs;
+        std::vector<double> hidden;
+        mlp_small_kernel kernel;
+    };
+    
+    void mlp_small_network::build(const mlp_dense_network &network)
+    {
+        const mlp_dense_layer &hidden_layer = network.layers[0];
+        const mlp_dense_layer &output_layer = network.layers[1];
+        
+        num_inputs = network.num_inputs;
+        num_hidden = hidden_layer.num_outputs;
+        num_outputs = output_layer.num_outputs;
+        input_activation = network.input_activation;
+        hidden_activation = hidden_layer.activation;
+        output_activation = output_layer.activation;
+        gamma = network.gamma;
+        
+        weights.clear();
+        weights.insert(weights.end(), network.input_weights.begin(), network.input_weights.end());
+        weights.insert(weights.end(), network.input_biases.begin(), network.input_biases.end());
+        weights.insert(weights.end(), hidden_layer.weights.begin(), hidden_layer.weights.end());
+        weights.insert(weights.end(), hidden_layer.biases.begin(), hidden_layer.biases.end());
+        weights.insert(weights.end(), output_layer.weights.begin(), output_layer.weights.end());
+        weights.insert(weights.end(), output_layer.biases.begin(), output_layer.biases.end());
+        
+        inputs.resize(num_inputs);
+        hidden.resize(num_hidden);
+        kernel = mlp_select_kernel(num_inputs, num_hidden, num_outputs, input_activation, hidden_activation, output_activation);
+    }
+    
+    void mlp_small_network::forward_generic(const double *input, double *output)
+    {
+        const double *input_weights = &weights[0];
+        const double *input_biases = input_weights + num_inputs;
+        const double *hidden_weights = input_biases + num_inputs;
+        const double *hidden_biases = hidden_weights + num_inputs * num_hidden;
+        const double *output_weights = hidden_biases + num_hidden;
+        const double *output_biases = output_weights + num_hidden * num_outputs;
+        
+        for (GRT::UINT in = 0; in < num_inputs; ++in)
+        {
+            inputs[in] = mlp_activate(input[in] * input_weights[in] + input_biases[in], input_activation, gamma);
+        }
+        
+        std::copy(hidden_biases, hidden_biases + num_hidden, hidden.begin());
+        
+        for (GRT::UINT in = 0; in < num_inputs; ++in)
+        {
+            for (GRT::UINT neuron = 0; neuron < num_hidden; ++neuron)
+            {
+                hidden[neuron] += inputs[in] * hidden_weights[in * num_hidden + neuron];
+            }
+        }
+        
+        mlp_activate_block(&hidden[0], num_hidden, hidden_activation, gamma);
+        std::copy(output_biases, output_biases + num_outputs, output);
+        
+        for (GRT::UINT neuron = 0; neuron < num_hidden; ++neuron)
+        {
+            for (GRT::UINT out = 0; out < num_outputs; ++out)
+            {
+                output[out] += hidden[neuron] * output_weights[neuron * num_outputs + out];
+            }
+        }
+        
+        mlp_activate_block(output, num_outputs, output_activation, gamma);
+    }
+    
+    // Fused forward pass for networks of any depth
+    //
+    // Each layer keeps its weights output-major so that one pass over a contiguous weight row gives the dot product,
+    // which is combined with the bias and activation before moving to the next output
+    class mlp_fused_network
+    {
+    public:
+        mlp_fused_network() : num_inputs(0), input_activation(GRT::Neuron::LINEAR), gamma(0) {}
+        
+        void build(const mlp_dense_network &network);
+        void clear() { layers.clear(); num_inputs = 0; }
+        bool is_built() const { return !layers.empty(); }
+        
+        // Writes the outputs of the last layer to output, input is already scaled
+        void forward(const double *input, double *output);
+        
+    private:
+        GRT::UINT num_inputs;
+        GRT::UINT input_activation;
+        double gamma;
+        std::vector<double> input_weights;
+        std::vector<double> input_biases;
+        std::vector<mlp_dense_layer> layers;
+        
+        // Preallocated activations, two buffers of the widest layer
+        std::vector<double> values;
+    };
+    
+    void mlp_fused_network::build(const mlp_dense_network &network)
+    {
+        GRT::UINT max_width = network.num_inputs;
+        
+        num_inputs = network.num_inputs;
+        input_activation = network.input_activation;
+        gamma = network.gamma;
+        input_weights = network.input_weights;
+        input_biases = network.input_biases;
+        layers = network.layers;
+        
+        for (GRT::UINT index = 0; index < layers.size(); ++index)
+        {
+            const mlp_dense_layer &source = network.layers[index];
+            mlp_dense_layer &layer = layers[index];
+            
+            for (GRT::UINT input = 0; input < layer.num_inputs; ++input)
+            {
+                for (GRT::UINT output = 0; output < layer.num_outputs; ++output)
+                {
+                    layer.weights[output * layer.num_inputs + input] = source.weights[input * layer.num_outputs + output];
+                }
+            }
+            
+            max_width = std::max(max_width, layer.num_outputs);
+        }
+        
+        values.resize(2 * max_width);
+    }
+    
+    void mlp_fused_network::forward(const double *input, double *output)
+    {
+        double *current = &values[0];
+        double *next = &values[values.size() / 2];
+        
+        for (GRT::UINT in = 0; in < num_inputs; ++in)
+        {
+            current[in] = mlp_activate(input[in] * input_weights[in] + input_biases[in], input_activation, gamma);
+        }
+        
+        for (GRT::UINT index = 0; index < layers.size(); ++index)
+        {
+            const mlp_dense_layer &layer = layers[index];
+            double *result = index + 1 == layers.size() ? output : next;
+            
+            for (GRT::UINT out = 0; out < layer.num_outputs; ++out)
+            {
+                const double *row = &layer.weights[out * layer.num_inputs];
+                double sum = layer.biases[out];
+                
+                for (GRT::UINT in = 0; in < layer.num_inputs; ++in)
+                {
+                    sum += row[in] * current[in];
+                }
+                
+                result[out] = mlp_activate(sum, layer.activation, gamma);
+            }
+            
+            std::swap(current, next);
+        }
+    }
+    
+    // Int8 quantised forward pass
+    //
+    // Weights are quantised symmetrically per layer (scale = max |w| / 127) and stored output-major so each output is
+    // one contiguous int8 dot product. The input of each layer is quantised on the fly with its own symmetric scale,
+    // products are accumulated in int32 and the result is rescaled to floating point for the bias and activation.
+    // The quantised tables are derived deterministically from the trained weights
+    const float k_mlp_int8_max = 127.0f;
+    
+    struct mlp_quantised_layer
+    {
+        GRT::UINT num_inputs;
+        GRT::UINT num_outputs;
+        GRT::UINT activation;
+        float weight_scale;
+        std::vector<int8_t> weights;
+        std::vector<float> biases;
+    };
+    
+    class mlp_quantised_network
+    {
+    public:
+        mlp_quantised_network() : num_inputs(0), input_activation(GRT::Neuron::LINEAR), gamma(0) {}
+        
+        void build(const mlp_dense_network &network);
+        void clear() { layers.clear(); num_inputs = 0; }
+        bool is_built() const { return !layers.empty(); }
+        GRT::UINT get_num_inputs() const { return num_inputs; }
+        GRT::UINT get_num_outputs() const { return layers.empty() ? 0 : layers.back().num_outputs; }
+        
+        // Writes get_num_outputs() values to outputs, inputs are already scaled
+        void forward(const double *inputs, double *outputs);
+        
+    private:
+        static float quantise(const float *values, GRT::UINT count, int8_t *quantised);
+        
+        GRT::UINT num_inputs;
+        GRT::UINT input_activation;
+        float gamma;
+        std::vector<float> input_weights;
+        std::vector<float> input_biases;
+        std::vector<mlp_quantised_layer> layers;
+        
+        // Preallocated activations, sized for the widest layer
+        std::vector<float> values;
+        std::vector<int8_t> quantised_values;
+    };
+    
+    void mlp_quantised_network::build(const mlp_dense_network &network)
+    {
+        GRT::UINT max_width = network.num_inputs;
+        
+        num_inputs = network.num_inputs;
+        input_activation = network.input_activation;
+        gamma = (float)network.gamma;
+        input_weights.assign(network.input_weights.begin(), network.input_weights.end());
+        input_biases.assign(network.input_biases.begin(), network.input_biases.end());
+        layers.resize(network.get_num_layers());
+        
+        for (GRT::UINT index = 0; index < layers.size(); ++index)
+        {
+            const mlp_dense_layer &source = network.layers[index];
+            mlp_quantised_layer &layer = layers[index];
+            double max_weight = 0.0;
+            
+            for (GRT::UINT weight = 0; weight < source.weights.size(); ++weight)
+            {
+                max_weight = std::max(max_weight, fabs(source.weights[weight]));
+            }
+            
+            layer.num_inputs = source.num_inputs;
+            layer.num_outputs = source.num_outputs;
+            layer.activation = source.activation;
+            layer.weight_scale = max_weight > 0 ? (float)(max_weight / k_mlp_int8_max) : 1.0f;
+            layer.weights.resize(source.weights.size());
+            layer.biases.assign(source.biases.begin(), source.biases.end());
+            
+            for (GRT::UINT input = 0; input < layer.num_inputs; ++input)
+            {
+                for (GRT::UINT output = 0; output < layer.num_outputs; ++output)
+                {
+                    const double weight = source.weights[input * layer.num_outputs + output];
+                    layer.weights[output * layer.num_inputs + input] = (int8_t)lrint(weight / layer.weight_scale);
+                }
+            }
+            
+            max_width = std::max(max_width, layer.num_outputs);
+        }
+        
+        values.resize(2 * max_width);
+        quantised_values.resize(max_width);
+    }
+    
+    // Returns the scale that maps the int8 values back to the originals
+    float mlp_quantised_network::quantise(const float *values, GRT::UINT count, int8_t *quantised)
+    {
+        float max_value = 0.0f;
+        
+        for (GRT::UINT index = 0; index < count; ++index)
+        {
+            max_value = std::max(max_value, fabsf(values[index]));
+        }
+        
+        if (max_value == 0.0f)
+        {
+            std::fill(quantised, quantised + count, 0);
+            return 0.0f;
+        }
+        
+        const float inverse_scale = k_mlp_int8_max / max_value;
+        
+        for (GRT::UINT index = 0; index < count; ++index)
+        {
+            quantised[index] = (int8_t)lrintf(values[index] * inverse_scale);
+        }
+        
+        return max_value / k_mlp_int8_max;
+    }
+    
+    void mlp_quantised_network::forward(const double *inputs, double *outputs)
+    {
+        float *current = &values[0];
+        float *next = &values[values.size() / 2];
+        int8_t *quantised = &quantised_values[0];
+        
+        // The input layer is a per-dimension weight and bias, done in floating point
+        for (GRT::UINT input = 0; input < num_inputs; ++input)
+        {
+            current[input] = (float)mlp_activate(inputs[input] * input_weights[input] + input_biases[input], input_activation, gamma);
+        }
+        
+        for (GRT::UINT index = 0; index < layers.size(); ++index)
+        {
+            const mlp_quantised_layer &layer = layers[index];
+            const float scale = quantise(current, layer.num_inputs, quantised) * layer.weight_scale;
+            
+            for (GRT::UINT output = 0; output < layer.num_outputs; ++output)
+            {
+                const int8_t *weights = &layer.weights[output * layer.num_inputs];
+                int32_t accumulator = 0;
+                
+                for (GRT::UINT input = 0; input < layer.num_inputs; ++input)
+                {
+                    accumulator += (int32_t)weights[input] * (int32_t)quantised[input];
+                }
+                
+                next[output] = (float)mlp_activate(accumulator * scale + layer.biases[output], layer.activation, gamma);
+            }
+            
+            std::swap(current, next);
+        }
+        
+        for (GRT::UINT output = 0; output < get_num_outputs(); ++output)
+        {
+            outputs[output] = current[output];
+        }
+    }
+    
+    // GRT::MLP with an alternative mini-batch training engine, selected by set_batch_size(). A batch size of 0 keeps
+    // GRT's own online gradient descent
+    class ml_mlp_model : public GRT::MLP
+    {
+    public:
+        ml_mlp_model()
+        :
+        batch_size(0),
+        seed(0),
+        optimiser(OPTIMISER_SGD),
+        rate_schedule(SCHEDULE_CONSTANT),
+        rate_decay(0.99),
+        patience(0),
+        target_error(0),
+        log_errors(false),
+        warm_epochs(default_warm_epochs),
+        num_epochs_trained(0),
+        target_epoch(0),
+        target_time(0),
+        deep(false),
+        quantised(false)
+        {}
+        
+        bool train_(GRT::ClassificationData &trainingData);
+        bool train_(GRT::RegressionData &trainingData);
+        bool predict_(GRT::VectorDouble &inputVector);
+        bool saveModelToFile(fstream &file) const;
+        bool loadModelFromFile(fstream &file);
+        bool clear();
+        
+        // Sizes of the hidden layers. With more than one the network is trained and run by the dense engine and saved in
+        // its own format, otherwise GRT's single hidden layer of getNumHiddenNeurons() is used
+        void set_hidden_layers(const std::vector<GRT::UINT> &hidden_layers) { this->hidden_layers = hidden_layers; }
+        const std::vector<GRT::UINT> &get_hidden_layers() const { return hidden_layers; }
+        
+        // True if the current model has more than one hidden layer
+        bool is_deep() const { return deep; }
+        
+        // True if predict_() uses a forward pass specialised at compile time for the network's shape
+        bool is_specialised() const { return small_network.is_specialised(); }
+        
+        // When quantised, predictions use the int8 forward pass. The setting is saved with the model
+        void set_quantised(bool quantised);
+        bool get_quantised() const { return quantised; }
+        
+        // Runs inputs through the floating point and quantised forward passes, for benchmarking
+        bool compare_quantised(const std::vector<GRT::VectorDouble> &inputs, double &mean_difference, double &max_difference, double &speedup);
+        
+        void set_batch_size(GRT::UINT batch_size) { this->batch_size = batch_size; }
+        GRT::UINT get_batch_size() const { return batch_size; }
+        
+        // Seed for weight initialisation, training order and the validation split of the mini-batch trainer, 0 seeds
+        // from the clock
+        void set_seed(GRT::UINT seed) { this->seed = seed; }
+        GRT::UINT get_seed() const { return seed; }
+        
+        // Options of the mini-batch trainer, see mlp_trainer
+        void set_optimiser(mlp_optimiser optimiser) { this->optimiser = optimiser; }
+        void set_rate_schedule(mlp_rate_schedule rate_schedule) { this->rate_schedule = rate_schedule; }
+        void set_rate_decay(double rate_decay) { this->rate_decay = rate_decay; }
+        void set_patience(GRT::UINT patience) { this->patience = patience; }
+        void set_target_error(double target_error) { this->target_error = target_error; }
+        void set_log_errors(bool log_errors) { this->log_errors = log_errors; }
+        mlp_optimiser get_optimiser() const { return optimiser; }
+        mlp_rate_schedule get_rate_schedule() const { return rate_schedule; }
+        double get_rate_decay() const { return rate_decay; }
+        GRT::UINT get_patience() const { return patience; }
+        double get_target_error() const { return target_error; }
+        bool get_log_errors() const { return log_errors; }
+        
+        // Total number of epochs run by the last call to train, summed over random training iterations
+        GRT::UINT get_num_epochs_trained() const { return num_epochs_trained; }
+        
+        // Warm starting continues training a trained network for at most warm_epochs instead of reinitialising it
+        void set_warm_epochs(GRT::UINT warm_epochs) { this->warm_epochs = warm_epochs; }
+        GRT::UINT get_warm_epochs() const { return warm_epochs; }
+        bool can_warm_start(GRT::UINT num_inputs, const std::vector<GRT::UINT> &hidden_layers, GRT::UINT num_outputs, GRT::UINT input_activation, GRT::UINT hidden_activation, GRT::UINT output_activation, bool classification) const;
+        bool train_warm(GRT::ClassificationData trainingData);
+        bool train_warm(GRT::RegressionData trainingData);
+        
+        // Epoch and milliseconds at which the selected network first reached the target error, 0 if it did not
+        GRT::UINT get_target_epoch() const { return target_epoch; }
+        double get_target_time() const { return target_time; }
+        
+        // Per-epoch RMS errors of the selected network, empty unless error logging is on
+        const GRT::VectorDouble &get_epoch_training_errors() const { return epoch_training_errors; }
+        const GRT::VectorDouble &get_epoch_validation_errors() const { return epoch_validation_errors; }
+        
+        using GRT::MLP::train_;
+        using GRT::MLP::predict_;
+        using GRT::MLP::saveModelToFile;
+        using GRT::MLP::loadModelFromFile;
+        
+    protected:
+        bool train_dense(GRT::RegressionData &trainingData);
+        unsigned long long get_base_seed() const;
+        mlp_training_settings get_training_settings() const;
+        void split_data(const GRT::RegressionData &data, unsigned long long base_seed, mlp_dataset &training, mlp_dataset &validation);
+        void read_network(mlp_dense_network &network) const;
+        void write_network(const mlp_dense_network &network);
+        void build_inference();
+        bool predict_fast(const GRT::VectorDouble &inputVector, bool use_quantised);
+        bool predict_float(GRT::VectorDouble &inputVector);
+        bool save_deep_model(fstream &file) const;
+        bool load_deep_model(fstream &file);
+        
+        GRT::UINT batch_size;
+        GRT::UINT seed;
+        mlp_optimiser optimiser;
+        mlp_rate_schedule rate_schedule;
+        double rate_decay;
+        GRT::UINT patience;
+        double target_error;
+        bool log_errors;
+        GRT::UINT warm_epochs;
+        
+        GRT::UINT num_epochs_trained;
+        GRT::UINT target_epoch;
+        double target_time;
+        GRT::VectorDouble epoch_training_errors;
+        GRT::VectorDouble epoch_validation_errors;
+        
+        std::vector<GRT::UINT> hidden_layers;
+        bool deep;
+        mlp_dense_network deep_network;
+        mlp_fused_network fused_network;
+        
+        bool quantised;
+        mlp_small_network small_network;
+        mlp_quantised_network quantised_network;
+        GRT::VectorDouble scaled_input;
+        GRT::VectorDouble network_output;
+        
+        static const std::string quantised_header;
+        static const std::string deep_model_header;
+    };
+    
+    const std::string ml_mlp_model::quantised_header = "MLPQuantisedInference:";
+    const std::string ml_mlp_model::deep_model_header = "ML_MLP_DEEP_MODEL_FILE_V1.0";
+    
+    bool ml_mlp_model::train_(GRT::ClassificationData &trainingData)
+    {
+        small_network.clear();
+        fused_network.clear();
+        quantised_network.clear();
+        
+        // GRT's trainer only handles a single hidden layer
+        if (batch_size == 0 && hidden_layers.size() <= 1)
+        {
+            deep = false;
+            deep_network.layers.clear();
+            
+            bool success = GRT::MLP::train_(trainingData);
+            
+            num_epochs_trained = 0;
+            
+            for (GRT::UINT index = 0; index < trainingErrorLog.size(); ++index)
+            {
+                num_epochs_trained += (GRT::UINT)trainingErrorLog[index].size();
+            }
+            build_inference();
+            
+            return success;
+        }
+        
+        if (!initialized || trainingData.getNumDimensions() != numInputNeurons || trainingData.getNumClasses() != numOutputNeurons)
+        {
+            return false;
+        }
+        
+        GRT::RegressionData regressionTrainingData = trainingData.reformatAsRegressionData();
+        
+        classificationModeActive = true;
+        
+        bool success = train_dense(regressionTrainingData);
+        
+        build_inference();
+        
+        return success;
+    }
+    
+    bool ml_mlp_model::train_(GRT::RegressionData &trainingData)
+    {
+        small_network.clear();
+        fused_network.clear();
+        quantised_network.clear();
+        
+        // GRT's trainer only handles a single hidden layer
+        if (batch_size == 0 && hidden_layers.size() <= 1)
+        {
+            deep = false;
+            deep_network.layers.clear();
+            
+            bool success = GRT::MLP::train_(trainingData);
+            
+            num_epochs_trained = 0;
+            
+            for (GRT::UINT index = 0; index < trainingErrorLog.size(); ++index)
+            {
+                num_epochs_trained += (GRT::UINT)trainingErrorLog[index].size();
+            }
+            build_inference();
+            
+            return success;
+        }
+        
+        classificationModeActive = false;
+        
+        bool success = train_dense(trainingData);
+        
+        build_inference();
+        
+        return success;
+    }
+    
+    bool ml_mlp_model::predict_(GRT::VectorDouble &inputVector)
+    {
+        if (quantised && quantised_network.is_built())
+        {
+            return predict_fast(inputVector, true);
+        }
+        
+        return predict_float(inputVector);
+    }
+    
+    // Mirrors GRT::MLP::predict_() using the small-network, fused or quantised forward pass, without allocating
+    bool ml_mlp_model::predict_fast(const GRT::VectorDouble &inputVector, bool use_quantised)
+    {
+        if (!trained || inputVector.size() != numInputNeurons)
+        {
+            return false;
+        }
+        
+        for (GRT::UINT index = 0; index < numInputNeurons; ++index)
+        {
+            scaled_input[index] = useScaling ? scale(inputVector[index], inputVectorRanges[index].minValue, inputVectorRanges[index].maxValue, 0.0, 1.0) : inputVector[index];
+        }
+        
+        if (use_quantised)
+        {
+            quantised_network.forward(&scaled_input[0], &network_output[0]);
+        }
+        else if (deep)
+        {
+            fused_network.forward(&scaled_input[0], &network_output[0]);
+        }
+        else
+        {
+            small_network.forward(&scaled_input[0], &network_output[0]);
+        }
+        
+        if (classificationModeActive)
+        {
+            const double min_output = *std::min_element(network_output.begin(), network_output.end());
+            double sum = 0.0;
+            
+            for (GRT::UINT index = 0; index < numOutputNeurons; ++index)
+            {
+                classLikelihoods[index] = network_output[index] - min_output;
+                sum += classLikelihoods[index];
+            }
+            
+            GRT::UINT best_index = 0;
+            
+            maxLikelihood = 0;
+            
+            for (GRT::UINT index = 0; index < numOutputNeurons; ++index)
+            {
+                if (sum > 0)
+                {
+                    classLikelihoods[index] /= sum;
+                }
+                
+                if (classLikelihoods[index] > maxLikelihood)
+                {
+                    maxLikelihood = classLikelihoods[index];
+                    best_index = index;
+                }
+            }
+            
+            predictedClassLabel = best_index + 1;
+            
+            if (useNullRejection && maxLikelihood < nullRejectionCoeff)
+            {
+                predictedClassLabel = 0;
+            }
+            
+            regressionData = network_output;
+            
+            return true;
+        }
+        
+        for (GRT::UINT index = 0; index < numOutputNeurons; ++index)
+        {
+            regressionData[index] = useScaling ? scale(network_output[index], 0.0, 1.0, targetVectorRanges[index].minValue, targetVectorRanges[index].maxValue) : network_output[index];
+        }
+        
+        return true;
+    }
+    
+    // The float forward pass predict_() serves when quantisation is off. GRT's own layers are only used when neither
+    // the small nor the fused network is built, and are empty for a loaded deep model
+    bool ml_mlp_model::predict_float(GRT::VectorDouble &inputVector)
+    {
+        if (small_network.is_built() || fused_network.is_built())
+        {
+            return predict_fast(inputVector, false);
+        }
+        
+        if (deep)
+        {
+            return false;
+        }
+        
+        return GRT::MLP::predict_(inputVector);
+    }
+    
+    // The quantisation flag follows GRT's model as an extra header and value, older model files without it still load.
+    // Networks with more than one hidden layer are saved in their own format
+    bool ml_mlp_model::saveModelToFile(fstream &file) const
+    {
+        if (deep)
+        {
+            return save_deep_model(file);
+        }
+        
+        if (!GRT::MLP::saveModelToFile(file))
+        {
+            return false;
+        }
+        
+        file << quantised_header << " " << quantised << std::endl;
+        
+        return true;
+    }
+    
+    bool ml_mlp_model::loadModelFromFile(fstream &file)
+    {
+        small_network.clear();
+        fused_network.clear();
+        quantised_network.clear();
+        deep = false;
+        deep_network.layers.clear();
+        
+        const std::streampos start = file.tellg();
+        std::string word;
+        
+        if (file >> word && word == deep_model_header)
+        {
+            return load_deep_model(file);
+        }
+        
+        file.clear();
+        file.seekg(start);
+        
+        if (!GRT::MLP::loadModelFromFile(file))
+        {
+            return false;
+        }
+        
+        if (file >> word && word == quantised_header)
+        {
+            file >> quantised;
+        }
+        
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_mlp_model::save_deep_model(fstream &file) const
+    {
+        if (!file.is_open())
+        {
+            return false;
+        }
+        
+        const std::streamsize precision = file.precision(17);
+        
+        file << deep_model_header << std::endl;
+        file << "Trained: " << trained << std::endl;
+        file << "NumInputNeurons: " << numInputNeurons << std::endl;
+        file << "NumOutputNeurons: " << numOutputNeurons << std::endl;
+        file << "InputLayerActivationFunction: " << inputLayerActivationFunction << std::endl;
+        file << "HiddenLayerActivationFunction: " << hiddenLayerActivationFunction << std::endl;
+        file << "OutputLayerActivationFunction: " << outputLayerActivationFunction << std::endl;
+        file << "Gamma: " << gamma << std::endl;
+        file << "UseScaling: " << useScaling << std::endl;
+        file << "ClassificationMode: " << classificationModeActive << std::endl;
+        file << "UseNullRejection: " << useNullRejection << std::endl;
+        file << "NullRejectionCoeff: " << nullRejectionCoeff << std::endl;
+        file << "TrainingError: " << trainingError << std::endl;
+        
+        file << "InputRanges:";
+        for (GRT::UINT index = 0; index < inputVectorRanges.size(); ++index)
+        {
+            file << " " << inputVectorRanges[index].minValue << " " << inputVectorRanges[index].maxValue;
+        }
+        file << std::endl << "TargetRanges:";
+        for (GRT::UINT index = 0; index < targetVectorRanges.size(); ++index)
+        {
+            file << " " << targetVectorRanges[index].minValue << " " << targetVectorRanges[index].maxValue;
+        }
+        file << std::endl;
+        
+        file << "InputLayer:";
+        for (GRT::UINT index = 0; index < deep_network.num_inputs; ++index)
+        {
+            file << " " << deep_network.input_weights[index] << " " << deep_network.input_biases[index];
+        }
+        file << std::endl;
+        
+        file << "NumLayers: " << deep_network.get_num_layers() << std::endl;
+        
+        for (GRT::UINT index = 0; index < deep_network.get_num_layers(); ++index)
+        {
+            const mlp_dense_layer &layer = deep_network.layers[index];
+            
+            file << "Layer: " << layer.num_inputs << " " << layer.num_outputs << " " << layer.activation << std::endl;
+            file << "Weights:";
+            for (GRT::UINT weight = 0; weight < layer.weights.size(); ++weight)
+            {
+                file << " " << layer.weights[weight];
+            }
+            file << std::endl << "Biases:";
+            for (GRT::UINT bias = 0; bias < layer.biases.size(); ++bias)
+            {
+                file << " " << layer.biases[bias];
+            }
+            file << std::endl;
+        }
+        
+        file << quantised_header << " " << quantised << std::endl;
+        file.precision(precision);
+        
+        return true;
+    }
+    
+    // Reads the fields written by save_deep_model(), after the header
+    bool ml_mlp_model::load_deep_model(fstream &file)
+    {
+        std::string word;
+        GRT::UINT numLayers = 0;
+        mlp_dense_network network;
+        
+        file >> word >> trained;
+        file >> word >> numInputNeurons;
+        file >> word >> numOutputNeurons;
+        file >> word >> inputLayerActivationFunction;
+        file >> word >> hiddenLayerActivationFunction;
+        file >> word >> outputLayerActivationFunction;
+        file >> word >> gamma;
+        file >> word >> useScaling;
+        file >> word >> classificationModeActive;
+        file >> word >> useNullRejection;
+        file >> word >> nullRejectionCoeff;
+        file >> word >> trainingError;
+        
+        if (!file)
+        {
+            return false;
+        }
+        
+        inputVectorRanges.resize(numInputNeurons);
+        targetVectorRanges.resize(numOutputNeurons);
+        
+        file >> word;
+        for (GRT::UINT index = 0; index < numInputNeurons; ++index)
+        {
+            file >> inputVectorRanges[index].minValue >> inputVectorRanges[index].maxValue;
+        }
+        file >> word;
+        for (GRT::UINT index = 0; index < numOutputNeurons; ++index)
+        {
+            file >> targetVectorRanges[index].minValue >> targetVectorRanges[index].maxValue;
+        }
+        
+        network.num_inputs = numInputNeurons;
+        network.input_activation = inputLayerActivationFunction;
+        network.gamma = gamma;
+        network.input_weights.resize(numInputNeurons);
+        network.input_biases.resize(numInputNeurons);
+        
+        file >> word;
+        for (GRT::UINT index = 0; index < numInputNeurons; ++index)
+        {
+            file >> network.input_weights[index] >> network.input_biases[index];
+        }
+        
+        file >> word >> numLayers;
+        
+        if (!file || numLayers < 2)
+        {
+            return false;
+        }
+        
+        network.layers.resize(numLayers);
+        
+        for (GRT::UINT index = 0; index < numLayers; ++index)
+        {
+            mlp_dense_layer &layer = network.layers[index];
+            
+            file >> word >> layer.num_inputs >> layer.num_outputs >> layer.activation;
+            
+            if (!file || layer.num_inputs != (index == 0 ? numInputNeurons : network.layers[index - 1].num_outputs))
+            {
+                return false;
+            }
+            
+            layer.weights.resize(layer.num_inputs * layer.num_outputs);
+            layer.biases.resize(layer.num_outputs);
+            
+            file >> word;
+            for (GRT::UINT weight = 0; weight < layer.weights.size(); ++weight)
+            {
+                file >> layer.weights[weight];
+            }
+            file >> word;
+            for (GRT::UINT bias = 0; bias < layer.biases.size(); ++bias)
+            {
+                file >> layer.biases[bias];
+            }
+        }
+        
+        if (!file || network.layers.back().num_outputs != numOutputNeurons)
+        {
+            return false;
+        }
+        
+        if (file >> word && word == quantised_header)
+        {
+            file >> quantised;
+        }
+        
+        numHiddenNeurons = network.layers[0].num_outputs;
+        numInputDimensions = numInputNeurons;
+        numOutputDimensions = numOutputNeurons;
+        hidden_layers.clear();
+        
+        for (GRT::UINT index = 0; index + 1 < numLayers; ++index)
+        {
+            hidden_layers.push_back(network.layers[index].num_outputs);
+        }
+        
+        deep = true;
+        deep_network = network;
+        initialized = true;
+        regressionData.assign(numOutputNeurons, 0.0);
+        classLikelihoods.assign(numOutputNeurons, 0.0);
+        build_inference();
+        
+        return true;
+    }
+    
+    bool ml_mlp_model::clear()
+    {
+        small_network.clear();
+        fused_network.clear();
+        quantised_network.clear();
+        deep = false;
+        deep_network.layers.clear();
+        return GRT::MLP::clear();
+    }
+    
+    void ml_mlp_model::set_quantised(bool quantised)
+    {
+        this->quantised = quantised;
+        build_inference();
+    }
+    
+    // Selects the forward pass used by predict_() after training or loading. Buffers are sized here so that
+    // prediction does not allocate
+    void ml_mlp_model::build_inference()
+    {
+        small_network.clear();
+        fused_network.clear();
+        quantised_network.clear();
+        
+        if (!trained)
+        {
+            return;
+        }
+        
+        mlp_dense_network network;
+        
+        read_network(network);
+        
+        if (deep)
+        {
+            fused_network.build(network);
+        }
+        else
+        {
+            small_network.build(network);
+        }
+        
+        if (quantised)
+        {
+            quantised_network.build(network);
+        }
+        
+        scaled_input.resize(numInputNeurons);
+        network_output.resize(numOutputNeurons);
+        regressionData.resize(numOutputNeurons);
+        classLikelihoods.resize(numOutputNeurons);
+    }
+    
+    bool ml_mlp_model::compare_quantised(const std::vector<GRT::VectorDouble> &inputs, double &mean_difference, double &max_difference, double &speedup)
+    {
+        const GRT::UINT min_benchmark_ms = 50;
+        
+        if (!quantised_network.is_built() || inputs.empty())
+        {
+            return false;
+        }
+        
+        std::vector<GRT::VectorDouble> float_outputs(inputs.size());
+        GRT::VectorDouble input;
+        GRT::UINT num_values = 0;
+        
+        mean_difference = 0.0;
+        max_difference = 0.0;
+        
+        // The float pass runs first and its outputs are kept, as the quantised pass overwrites regressionData
+        for (GRT::UINT sample = 0; sample < inputs.size(); ++sample)
+        {
+            input = inputs[sample];
+            
+            if (!predict_float(input))
+            {
+                return false;
+            }
+            
+            float_outputs[sample] = regressionData;
+        }
+        
+        for (GRT::UINT sample = 0; sample < inputs.size(); ++sample)
+        {
+            if (!predict_fast(inputs[sample], true))
+            {
+                return false;
+            }
+            
+            const GRT::VectorDouble &float_output = float_outputs[sample];
+            
+            for (GRT::UINT index = 0; index < float_output.size() && index < regressionData.size(); ++index)
+            {
+                const double difference = fabs(float_output[index] - regressionData[index]);
+                
+                mean_difference += difference;
+                max_difference = std::max(max_difference, difference);
+                ++num_values;
+            }
+        }
+        
+        mean_difference /= std::max<GRT::UINT>(1, num_values);
+        
+        // Repeat passes over the inputs until each timing is long enough to be meaningful with a millisecond timer
+        GRT::Timer timer;
+        GRT::UINT float_passes = 0;
+        GRT::UINT quantised_passes = 0;
+        
+        timer.start();
+        
+        while (timer.getMilliSeconds() < min_benchmark_ms)
+        {
+            for (GRT::UINT sample = 0; sample < inputs.size(); ++sample)
+            {
+                input = inputs[sample];
+                predict_float(input);
+            }
+            ++float_passes;
+        }
+        
+        const double float_time = timer.getMilliSeconds() / (double)float_passes;
+        
+        timer.start();
+        
+        while (timer.getMilliSeconds() < min_benchmark_ms)
+        {
+            for (GRT::UINT sample = 0; sample < inputs.size(); ++sample)
+            {
+                predict_fast(inputs[sample], true);
+            }
+            ++quantised_passes;
+        }
+        
+        const double quantised_time = timer.getMilliSeconds() / (double)quantised_passes;
+        
+        speedup = quantised_time > 0 ? float_time / quantised_time : 0.0;
+        
+        return true;
+    }
+    
+    bool ml_mlp_model::train_dense(GRT::RegressionData &trainingData)
+    {
+        trained = false;
+        num_epochs_trained = 0;
+        target_epoch = 0;
+        target_time = 0;
+        epoch_training_errors.clear();
+        epoch_validation_errors.clear();
+        
+        const GRT::UINT numSamples = trainingData.getNumSamples();
+        
+        if (!initialized || numSamples == 0)
+        {
+            return false;
+        }
+        
+        if (trainingData.getNumInputDimensions() != numInputNeurons || trainingData.getNumTargetDimensions() != numOutputNeurons)
+        {
+            return false;
+        }
+        
+        numInputDimensions = numInputNeurons;
+        numOutputDimensions = numOutputNeurons;
+        inputVectorRanges = trainingData.getInputRanges();
+        targetVectorRanges = trainingData.getTargetRanges();
+        
+        if (useScaling)
+        {
+            trainingData.scale(inputVectorRanges, targetVectorRanges, 0.0, 1.0);
+        }
+        
+        // The validation split and every restart draw from streams derived from one base seed so that a non-zero seed
+        // gives the same network on every run, however the restarts are scheduled across threads
+        const unsigned long long base_seed = get_base_seed();
+        const mlp_training_settings settings = get_training_settings();
+        mlp_dataset training;
+        mlp_dataset validation;
+        
+        split_data(trainingData, base_seed, training, validation);
+        
+        deep = hidden_layers.size() > 1;
+        
+        std::vector<GRT::UINT> layer_sizes = deep ? hidden_layers : std::vector<GRT::UINT>(1, numHiddenNeurons);
+        std::vector<GRT::UINT> activations(layer_sizes.size(), hiddenLayerActivationFunction);
+        
+        layer_sizes.push_back(numOutputNeurons);
+        activations.push_back(outputLayerActivationFunction);
+        
+        // Each restart trains a private network with its own trainer workspace and RNG stream
+        const GRT::UINT numRestarts = std::max<GRT::UINT>(1, numRandomTrainingIterations);
+        std::vector<mlp_dense_network> networks(numRestarts);
+        std::vector<double> errors(numRestarts, 0.0);
+        std::vector<GRT::UINT> epochs(numRestarts, 0);
+        std::vector<char> succeeded(numRestarts, 0);
+        std::vector<GRT::UINT> target_epochs(numRestarts, 0);
+        std::vector<double> target_times(numRestarts, 0.0);
+        std::vector<GRT::VectorDouble> training_logs(numRestarts);
+        std::vector<GRT::VectorDouble> validation_logs(numRestarts);
+        
+        parallel_for(numRestarts, [&](unsigned int restart, unsigned int)
+        {
+            GRT::Random restart_random(base_seed + restart + 1);
+            mlp_trainer trainer(settings);
+            
+            networks[restart].init(numInputNeurons, layer_sizes, inputLayerActivationFunction, activations, gamma, restart_random);
+            succeeded[restart] = trainer.train(networks[restart], training, validation, restart_random);
+            epochs[restart] = trainer.get_num_epochs();
+            errors[restart] = validation.num_samples > 0 ? trainer.get_validation_error() : trainer.get_training_error();
+            target_epochs[restart] = trainer.get_target_epoch();
+            target_times[restart] = trainer.get_target_time();
+            training_logs[restart] = trainer.get_training_log();
+            validation_logs[restart] = trainer.get_validation_log();
+        });
+        
+        // GRT keeps one training error log per random training iteration
+        trainingErrorLog = training_logs;
+        
+        // Keep the best restart, judged on the validation set if there is one, as GRT does. Ties go to the lowest
+        // restart index so the choice does not depend on thread scheduling
+        GRT::UINT best_restart = 0;
+        double best_error = 0.0;
+        bool found = false;
+        
+        for (GRT::UINT restart = 0; restart < numRestarts; ++restart)
+        {
+            num_epochs_trained += epochs[restart];
+            
+            if (succeeded[restart] && (!found || errors[restart] < best_error))
+            {
+                best_restart = restart;
+                best_error = errors[restart];
+                found = true;
+            }
+        }
+        
+        if (!found)
+        {
+            return false;
+        }
+        
+        const mlp_dense_network &best_network = networks[best_restart];
+        mlp_trainer trainer(settings);
+        
+        target_epoch = target_epochs[best_restart];
+        target_time = target_times[best_restart];
+        epoch_training_errors = training_logs[best_restart];
+        epoch_validation_errors = validation_logs[best_restart];
+        
+        write_network(best_network);
+        
+        regressionData.assign(numOutputNeurons, 0.0);
+        classLikelihoods.assign(numOutputNeurons, 0.0);
+        trainingError = best_error;
+        trained = true;
+        
+        if (classificationModeActive)
+        {
+            // GRT reports classification accuracy as the training error in classification mode
+            trainingError = trainer.get_accuracy(best_network, training);
+        }
+        
+        return true;
+    }
+    
+    unsigned long long ml_mlp_model::get_base_seed() const
+    {
+        if (seed != 0)
+        {
+            return seed;
+        }
+        
+        GRT::Timer timer;
+        
+        return (unsigned long long)timer.getSystemTime();
+    }
+    
+    mlp_training_settings ml_mlp_model::get_training_settings() const
+    {
+        mlp_training_settings settings;
+        
+        settings.batch_size = std::max<GRT::UINT>(1, batch_size);
+        settings.min_epochs = minNumEpochs;
+        settings.max_epochs = maxNumEpochs;
+        settings.min_change = minChange;
+        settings.learning_rate = getTrainingRate();
+        settings.momentum = momentum;
+        settings.randomise_order = randomiseTrainingOrder;
+        settings.optimiser = optimiser;
+        settings.rate_schedule = rate_schedule;
+        settings.rate_decay = rate_decay;
+        settings.patience = patience;
+        settings.target_error = target_error;
+        settings.log_errors = log_errors;
+        
+        return settings;
+    }
+    
+    // Splits (scaled) data into training and validation sets with a shuffle seeded from base_seed
+    void ml_mlp_model::split_data(const GRT::RegressionData &data, unsigned long long base_seed, mlp_dataset &training, mlp_dataset &validation)
+    {
+        const GRT::UINT numSamples = data.getNumSamples();
+        std::vector<GRT::UINT> indices(numSamples);
+        GRT::Random partition_random(base_seed);
+        
+        for (GRT::UINT sample = 0; sample < numSamples; ++sample)
+        {
+            indices[sample] = sample;
+        }
+        
+        GRT::UINT numTrainingSamples = numSamples;
+        
+        if (useValidationSet && numSamples > 1)
+        {
+            for (GRT::UINT sample = numSamples - 1; sample > 0; --sample)
+            {
+                std::swap(indices[sample], indices[partition_random.getRandomNumberInt(0, sample + 1)]);
+            }
+            numTrainingSamples = std::max<GRT::UINT>(1, (GRT::UINT)(numSamples * (100 - validationSetSize) / 100.0));
+        }
+        
+        training.assign(data, std::vector<GRT::UINT>(indices.begin(), indices.begin() + numTrainingSamples));
+        validation.assign(data, std::vector<GRT::UINT>(indices.begin() + numTrainingSamples, indices.end()));
+    }
+    
+    bool ml_mlp_model::can_warm_start(GRT::UINT num_inputs, const std::vector<GRT::UINT> &hidden_layers, GRT::UINT num_outputs, GRT::UINT input_activation, GRT::UINT hidden_activation, GRT::UINT output_activation, bool classification) const
+    {
+        std::vector<GRT::UINT> trained_layers(1, numHiddenNeurons);
+        
+        if (deep)
+        {
+            trained_layers.clear();
+            
+            for (GRT::UINT index = 0; index + 1 < deep_network.get_num_layers(); ++index)
+            {
+                trained_layers.push_back(deep_network.layers[index].num_outputs);
+            }
+        }
+        
+        return trained && numInputNeurons == num_inputs && trained_layers == hidden_layers && numOutputNeurons == num_outputs &&
+               inputLayerActivationFunction == input_activation && hiddenLayerActivationFunction == hidden_activation &&
+               outputLayerActivationFunction == output_activation && classificationModeActive == classification;
+    }
+    
+    bool ml_mlp_model::train_warm(GRT::ClassificationData trainingData)
+    {
+        if (!trained || !classificationModeActive || trainingData.getNumDimensions() != numInputNeurons || trainingData.getNumClasses() != numOutputNeurons)
+        {
+            return false;
+        }
+        
+        GRT::RegressionData regressionTrainingData = trainingData.reformatAsRegressionData();
+        
+        return train_warm(regressionTrainingData);
+    }
+    
+    // Continues training from the current weights, keeping the scaling ranges the network was trained with. Always
+    // uses the mini-batch trainer, with a batch size of 1 (GRT's online rule) if batch_size is 0
+    bool ml_mlp_model::train_warm(GRT::RegressionData trainingData)
+    {
+        if (!trained || trainingData.getNumSamples() == 0)
+        {
+            return false;
+        }
+        
+        if (trainingData.getNumInputDimensions() != numInputNeurons || trainingData.getNumTargetDimensions() != numOutputNeurons)
+        {
+            return false;
+        }
+        
+        if (useScaling)
+        {
+            trainingData.scale(inputVectorRanges, targetVectorRanges, 0.0, 1.0);
+        }
+        
+        const unsigned long long base_seed = get_base_seed();
+        mlp_training_settings settings = get_training_settings();
+        mlp_dataset training;
+        mlp_dataset validation;
+        mlp_dense_network network;
+        GRT::Random warm_random(base_seed + 1);
+        
+        split_data(trainingData, base_seed, training, validation);
+        read_network(network);
+        
+        settings.max_epochs = warm_epochs;
+        settings.min_epochs = std::min(minNumEpochs, warm_epochs);
+        
+        mlp_trainer trainer(settings);
+        
+        if (!trainer.train(network, training, validation, warm_random))
+        {
+            return false;
+        }
+        
+        write_network(network);
+        build_inference();
+        
+        num_epochs_trained = trainer.get_num_epochs();
+        target_epoch = trainer.get_target_epoch();
+        target_time = trainer.get_target_time();
+        epoch_training_errors = trainer.get_training_log();
+        epoch_validation_errors = trainer.get_validation_log();
+        trainingErrorLog.assign(1, epoch_training_errors);
+        trainingError = validation.num_samples > 0 ? trainer.get_validation_error() : trainer.get_training_error();
+        
+        if (classificationModeActive)
+        {
+            trainingError = trainer.get_accuracy(network, training);
+        }
+        
+        return true;
+    }
+    
+    // Copies the current model into a dense network: the deep network as is, or GRT's neurons as a single hidden layer
+    void ml_mlp_model::read_network(mlp_dense_network &network) const
+    {
+        if (deep)
+        {
+            network = deep_network;
+            return;
+        }
+        
+        network.num_inputs = numInputNeurons;
+        network.input_activation = inputLayerActivationFunction;
+        network.gamma = gamma;
+        network.input_weights.resize(numInputNeurons);
+        network.input_biases.resize(numInputNeurons);
+        network.layers.resize(2);
+        
+        for (GRT::UINT neuron = 0; neuron < numInputNeurons; ++neuron)
+        {
+            network.input_weights[neuron] = inputLayer[neuron].weights[0];
+            network.input_biases[neuron] = inputLayer[neuron].bias;
+        }
+        
+        mlp_dense_layer &hidden = network.layers[0];
+        mlp_dense_layer &output = network.layers[1];
+        
+        hidden.num_inputs = numInputNeurons;
+        hidden.num_outputs = numHiddenNeurons;
+        hidden.activation = hiddenLayerActivationFunction;
+        hidden.weights.resize(numInputNeurons * numHiddenNeurons);
+        hidden.biases.resize(numHiddenNeurons);
+        output.num_inputs = numHiddenNeurons;
+        output.num_outputs = numOutputNeurons;
+        output.activation = outputLayerActivationFunction;
+        output.weights.resize(numHiddenNeurons * numOutputNeurons);
+        output.biases.resize(numOutputNeurons);
+        
+        for (GRT::UINT neuron = 0; neuron < numHiddenNeurons; ++neuron)
+        {
+            for (GRT::UINT input = 0; input < numInputNeurons; ++input)
+            {
+                hidden.weights[input * numHiddenNeurons + neuron] = hiddenLayer[neuron].weights[input];
+            }
+            hidden.biases[neuron] = hiddenLayer[neuron].bias;
+        }
+        
+        for (GRT::UINT neuron = 0; neuron < numOutputNeurons; ++neuron)
+        {
+            for (GRT::UINT input = 0; input < numHiddenNeurons; ++input)
+            {
+                output.weights[input * numOutputNeurons + neuron] = outputLayer[neuron].weights[input];
+            }
+            output.biases[neuron] = outputLayer[neuron].bias;
+        }
+    }
+    
+    // Copies a dense network with a single hidden layer into GRT's neurons so that GRT's predict and save can use it
+    void ml_mlp_model::write_network(const mlp_dense_network &network)
+    {
+        if (deep)
+        {
+            deep_network = network;
+            return;
+        }
+        
+        const mlp_dense_layer &hidden = network.layers[0];
+        const mlp_dense_layer &output = network.layers[1];
+        
+        for (GRT::UINT neuron = 0; neuron < numInputNeurons; ++neuron)
+        {
+            inputLayer[neuron].weights[0] = network.input_weights[neuron];
+            inputLayer[neuron].bias = network.input_biases[neuron];
+        }
+        
+        for (GRT::UINT neuron = 0; neuron < numHiddenNeurons; ++neuron)
+        {
+            for (GRT::UINT input = 0; input < numInputNeurons; ++input)
+            {
+                hiddenLayer[neuron].weights[input] = hidden.weights[input * numHiddenNeurons + neuron];
+                hiddenLayer[neuron].previousUpdate[input] = 0.0;
+            }
+            hiddenLayer[neuron].bias = hidden.biases[neuron];
+            hiddenLayer[neuron].previousBiasUpdate = 0.0;
+        }
+        
+        for (GRT::UINT neuron = 0; neuron < numOutputNeurons; ++neuron)
+        {
+            for (GRT::UINT input = 0; input < numHiddenNeurons; ++input)
+            {
+                outputLayer[neuron].weights[input] = output.weights[input * numOutputNeurons + neuron];
+                outputLayer[neuron].previousUpdate[input] = 0.0;
+            }
+            outputLayer[neuron].bias = output.biases[neuron];
+            outputLayer[neuron].previousBiasUpdate = 0.0;
+        }
+    }
+    
     class ml_mlp : ml
     {
         FLEXT_HEADER_S(ml_mlp, ml, setup);
@@ -42,7 +2373,9 @@ namespace ml
         numHiddenNeurons(default_num_hidden_neurons),
         inputActivationFunction((GRT::Neuron::ActivationFunctions)mlp.getInputLayerActivationFunction()),
         hiddenActivationFunction((GRT::Neuron::ActivationFunctions)mlp.getHiddenLayerActivationFunction()),
-        outputActivationFunction((GRT::Neuron::ActivationFunctions)mlp.getOutputLayerActivationFunction())
+        outputActivationFunction((GRT::Neuron::ActivationFunctions)mlp.getOutputLayerActivationFunction()),
+        warm_start(false),
+        warm_started(false)
         {
             post("Multilayer Perceptron based on the GRT library version " + GRT::GRTBase::getGRTVersion());
             
@@ -68,6 +2401,7 @@ namespace ml
             FLEXT_CADDATTR_SET(c, "mode", set_mode);
             FLEXT_CADDATTR_SET(c, "num_outputs", set_num_outputs);
             FLEXT_CADDATTR_SET(c, "num_hidden", set_num_hidden);
+            FLEXT_CADDATTR_SET(c, "layers", set_layers);
             FLEXT_CADDATTR_SET(c, "min_epochs", set_min_epochs);
             FLEXT_CADDATTR_SET(c, "max_epochs", set_max_epochs);
             FLEXT_CADDATTR_SET(c, "min_change", set_min_change);
@@ -83,10 +2417,22 @@ namespace ml
             FLEXT_CADDATTR_SET(c, "use_validation_set", set_use_validation_set);
             FLEXT_CADDATTR_SET(c, "validation_set_size", set_validation_set_size);
             FLEXT_CADDATTR_SET(c, "randomize_training_order", set_randomise_training_order);
+            FLEXT_CADDATTR_SET(c, "batch_size", set_batch_size);
+            FLEXT_CADDATTR_SET(c, "seed", set_seed);
+            FLEXT_CADDATTR_SET(c, "quantize", set_quantize);
+            FLEXT_CADDATTR_SET(c, "warm_start", set_warm_start);
+            FLEXT_CADDATTR_SET(c, "warm_epochs", set_warm_epochs);
+            FLEXT_CADDATTR_SET(c, "optimiser", set_optimiser);
+            FLEXT_CADDATTR_SET(c, "rate_schedule", set_rate_schedule);
+            FLEXT_CADDATTR_SET(c, "rate_decay", set_rate_decay);
+            FLEXT_CADDATTR_SET(c, "patience", set_patience);
+            FLEXT_CADDATTR_SET(c, "target_error", set_target_error);
+            FLEXT_CADDATTR_SET(c, "error_log", set_error_log);
             
             FLEXT_CADDATTR_GET(c, "mode", get_mode);
             FLEXT_CADDATTR_GET(c, "num_outputs", get_num_outputs);
             FLEXT_CADDATTR_GET(c, "num_hidden", get_num_hidden);
+            FLEXT_CADDATTR_GET(c, "layers", get_layers);
             FLEXT_CADDATTR_GET(c, "max_epochs", get_max_epochs);
             FLEXT_CADDATTR_GET(c, "min_change", get_min_change);
             FLEXT_CADDATTR_GET(c, "training_rate", get_training_rate);
@@ -101,6 +2447,17 @@ namespace ml
             FLEXT_CADDATTR_GET(c, "use_validation_set", get_use_validation_set);
             FLEXT_CADDATTR_GET(c, "validation_set_size", get_validation_set_size);
             FLEXT_CADDATTR_GET(c, "randomize_training_order", get_randomise_training_order);
+            FLEXT_CADDATTR_GET(c, "batch_size", get_batch_size);
+            FLEXT_CADDATTR_GET(c, "seed", get_seed);
+            FLEXT_CADDATTR_GET(c, "quantize", get_quantize);
+            FLEXT_CADDATTR_GET(c, "warm_start", get_warm_start);
+            FLEXT_CADDATTR_GET(c, "warm_epochs", get_warm_epochs);
+            FLEXT_CADDATTR_GET(c, "optimiser", get_optimiser);
+            FLEXT_CADDATTR_GET(c, "rate_schedule", get_rate_schedule);
+            FLEXT_CADDATTR_GET(c, "rate_decay", get_rate_decay);
+            FLEXT_CADDATTR_GET(c, "patience", get_patience);
+            FLEXT_CADDATTR_GET(c, "target_error", get_target_error);
+            FLEXT_CADDATTR_GET(c, "error_log", get_error_log);
        
             DefineHelp(c, ml_object_name.c_str());
         }
@@ -109,11 +2466,17 @@ namespace ml
         void train();
         void map(int argc, const t_atom *argv);
         void error();
+        void output_error_log();
+        void report_quantisation();
+        
+        // Method overrides
+        bool get_training_summary(GRT::UINT num_samples, double seconds, std::stringstream &summary) const;
         
         // Flext attribute setters
         void set_mode(int mode);
         void set_num_outputs(int num_outputs);
         void set_num_hidden(int num_hidden);
+        void set_layers(const AtomList &layers);
         void set_min_epochs(int min_epochs);
         void set_max_epochs(int max_epochs);
         void set_min_change(float min_change);
@@ -129,11 +2492,23 @@ namespace ml
         void set_use_validation_set(bool use_validation_set);
         void set_validation_set_size(int validation_set_size);
         void set_randomise_training_order(bool randomise_training_order);
+        void set_batch_size(int batch_size);
+        void set_seed(int seed);
+        void set_quantize(bool quantize);
+        void set_warm_start(bool warm_start);
+        void set_warm_epochs(int warm_epochs);
+        void set_optimiser(int optimiser);
+        void set_rate_schedule(int rate_schedule);
+        void set_rate_decay(float rate_decay);
+        void set_patience(int patience);
+        void set_target_error(float target_error);
+        void set_error_log(bool error_log);
         
         // Flext attribute getters
         void get_mode(int &mode) const;
         void get_num_outputs(int &num_outputs) const;
         void get_num_hidden(int &num_hidden) const;
+        void get_layers(AtomList &layers) const;
         void get_min_epochs(int &min_epochs) const;
         void get_max_epochs(int &max_epochs) const;
         void get_min_change(float &min_change) const;
@@ -149,6 +2524,17 @@ namespace ml
         void get_use_validation_set(bool &use_validation_set) const;
         void get_validation_set_size(int &validation_set_size) const;
         void get_randomise_training_order(bool &randomise_training_order) const;
+        void get_batch_size(int &batch_size) const;
+        void get_seed(int &seed) const;
+        void get_quantize(bool &quantize) const;
+        void get_warm_start(bool &warm_start) const;
+        void get_warm_epochs(int &warm_epochs) const;
+        void get_optimiser(int &optimiser) const;
+        void get_rate_schedule(int &rate_schedule) const;
+        void get_rate_decay(float &rate_decay) const;
+        void get_patience(int &patience) const;
+        void get_target_error(float &target_error) const;
+        void get_error_log(bool &error_log) const;
         
         // Implement pure virtual methods
         GRT::MLBase &get_MLBase_instance();
@@ -166,6 +2552,7 @@ namespace ml
         FLEXT_CALLVAR_I(get_mode, set_mode);
         FLEXT_CALLVAR_I(get_num_outputs, set_num_outputs);
         FLEXT_CALLVAR_I(get_num_hidden, set_num_hidden);
+        FLEXT_CALLVAR_V(get_layers, set_layers);
         FLEXT_CALLVAR_I(get_min_epochs, set_min_epochs);
         FLEXT_CALLVAR_I(get_max_epochs, set_max_epochs);
         FLEXT_CALLVAR_F(get_min_change, set_min_change);
@@ -181,18 +2568,34 @@ namespace ml
         FLEXT_CALLVAR_B(get_use_validation_set, set_use_validation_set);
         FLEXT_CALLVAR_I(get_validation_set_size, set_validation_set_size);
         FLEXT_CALLVAR_B(get_randomise_training_order, set_randomise_training_order);
+        FLEXT_CALLVAR_I(get_batch_size, set_batch_size);
+        FLEXT_CALLVAR_I(get_seed, set_seed);
+        FLEXT_CALLVAR_B(get_quantize, set_quantize);
+        FLEXT_CALLVAR_B(get_warm_start, set_warm_start);
+        FLEXT_CALLVAR_I(get_warm_epochs, set_warm_epochs);
+        FLEXT_CALLVAR_I(get_optimiser, set_optimiser);
+        FLEXT_CALLVAR_I(get_rate_schedule, set_rate_schedule);
+        FLEXT_CALLVAR_F(get_rate_decay, set_rate_decay);
+        FLEXT_CALLVAR_I(get_patience, set_patience);
+        FLEXT_CALLVAR_F(get_target_error, set_target_error);
+        FLEXT_CALLVAR_B(get_error_log, set_error_log);
 
         // Virtual method override
         virtual const std::string get_object_name(void) const { return ml_object_name; };
         
-        GRT::MLP mlp;
+        ml_mlp_model mlp;
         GRT::UINT numHiddenNeurons;
         GRT::Neuron::ActivationFunctions inputActivationFunction;
         GRT::Neuron::ActivationFunctions hiddenActivationFunction;
         GRT::Neuron::ActivationFunctions outputActivationFunction;
+        bool warm_start;
+        
+        // Whether the last train continued from the previous weights
+        bool warm_started;
         
         static const std::string method_help;
         static const std::string attribute_help;
+        static const t_symbol *s_epoch;
     };
     
     // Flext attribute setters
@@ -251,6 +2654,39 @@ namespace ml
     void ml_mlp::set_num_hidden(int num_hidden)
     {
         this->numHiddenNeurons = num_hidden;
+        mlp.set_hidden_layers(std::vector<GRT::UINT>());
+    }
+    
+    void ml_mlp::set_layers(const AtomList &layers)
+    {
+        std::vector<GRT::UINT> hidden_layers;
+        
+        for (int index = 0; index < layers.Count(); ++index)
+        {
+            const int size = GetAInt(layers[index]);
+            
+            if (size < 1)
+            {
+                flext::error("layer sizes must be greater than zero");
+                return;
+            }
+            hidden_layers.push_back(size);
+        }
+        
+        if (hidden_layers.empty())
+        {
+            flext::error("layers needs at least one hidden layer size");
+            return;
+        }
+        
+        this->numHiddenNeurons = hidden_layers[0];
+        
+        if (hidden_layers.size() == 1)
+        {
+            hidden_layers.clear();
+        }
+        
+        mlp.set_hidden_layers(hidden_layers);
     }
     
     void ml_mlp::set_min_epochs(int min_epochs)
@@ -411,6 +2847,114 @@ namespace ml
         }
     }
     
+    void ml_mlp::set_batch_size(int batch_size)
+    {
+        if (batch_size < 0)
+        {
+            flext::error("batch_size must be 0 or greater");
+            return;
+        }
+        
+        mlp.set_batch_size(batch_size);
+    }
+    
+    void ml_mlp::set_seed(int seed)
+    {
+        if (seed < 0)
+        {
+            flext::error("seed must be 0 or greater");
+            return;
+        }
+        
+        mlp.set_seed(seed);
+    }
+    
+    void ml_mlp::set_quantize(bool quantize)
+    {
+        mlp.set_quantised(quantize);
+        
+        if (quantize && mlp.getTrained())
+        {
+            report_quantisation();
+        }
+    }
+    
+    void ml_mlp::set_warm_start(bool warm_start)
+    {
+        this->warm_start = warm_start;
+    }
+    
+    void ml_mlp::set_warm_epochs(int warm_epochs)
+    {
+        if (warm_epochs < 1)
+        {
+            flext::error("unable to set warm_epochs, hint: should be greater than 0");
+            return;
+        }
+        
+        mlp.set_warm_epochs(warm_epochs);
+    }
+    
+    void ml_mlp::set_optimiser(int optimiser)
+    {
+        if (optimiser < 0 || optimiser >= MLP_NUM_OPTIMISERS)
+        {
+            flext::error("optimiser must be between 0 and %d", MLP_NUM_OPTIMISERS - 1);
+            return;
+        }
+        
+        mlp.set_optimiser((mlp_optimiser)optimiser);
+    }
+    
+    void ml_mlp::set_rate_schedule(int rate_schedule)
+    {
+        if (rate_schedule < 0 || rate_schedule >= MLP_NUM_RATE_SCHEDULES)
+        {
+            flext::error("rate_schedule must be between 0 and %d", MLP_NUM_RATE_SCHEDULES - 1);
+            return;
+        }
+        
+        mlp.set_rate_schedule((mlp_rate_schedule)rate_schedule);
+    }
+    
+    void ml_mlp::set_rate_decay(float rate_decay)
+    {
+        if (rate_decay <= 0 || rate_decay > 1)
+        {
+            flext::error("unable to set rate_decay, hint: should be greater than 0 and no more than 1");
+            return;
+        }
+        
+        mlp.set_rate_decay(rate_decay);
+    }
+    
+    void ml_mlp::set_patience(int patience)
+    {
+        if (patience < 0)
+        {
+            flext::error("patience must be 0 or greater");
+            return;
+        }
+        
+        mlp.set_patience(patience);
+    }
+    
+    void ml_mlp::set_target_error(float target_error)
+    {
+        if (target_error < 0)
+        {
+            flext::error("target_error must be 0 or greater");
+            return;
+        }
+        
+        mlp.set_target_error(target_error);
+    }
+    
+    void ml_mlp::set_error_log(bool error_log)
+    {
+        mlp.set_log_errors(error_log);
+    }
+    
     // Flext attribute getters
     void ml_mlp::get_mode(int &mode) const
     {
@@ -436,6 +2980,30 @@ namespace ml
         num_hidden = this->numHiddenNeurons;
     }
     
+    void ml_mlp::get_layers(AtomList &layers) const
+    {
+        const std::vector<GRT::UINT> &hidden_layers = mlp.get_hidden_layers();
+        
+        layers.Clear();
+        
+        if (hidden_layers.size() <= 1)
+        {
+            t_atom size_a;
+            
+            SetInt(size_a, numHiddenNeurons);
+            layers.Append(size_a);
+            return;
+        }
+        
+        for (GRT::UINT index = 0; index < hidden_layers.size(); ++index)
+        {
+            t_atom size_a;
+            
+            SetInt(size_a, hidden_layers[index]);
+            layers.Append(size_a);
+        }
+    }
+    
     void ml_mlp::get_min_epochs(int &min_epochs) const
     {
         min_epochs = mlp.getMaxNumEpochs();
@@ -511,6 +3079,61 @@ namespace ml
         flext::error("function not implemented");
     }
     
+    void ml_mlp::get_batch_size(int &batch_size) const
+    {
+        batch_size = mlp.get_batch_size();
+    }
+    
+    void ml_mlp::get_seed(int &seed) const
+    {
+        seed = mlp.get_seed();
+    }
+    
+    void ml_mlp::get_quantize(bool &quantize) const
+    {
+        quantize = mlp.get_quantised();
+    }
+    
+    void ml_mlp::get_warm_start(bool &warm_start) const
+    {
+        warm_start = this->warm_start;
+    }
+    
+    void ml_mlp::get_warm_epochs(int &warm_epochs) const
+    {
+        warm_epochs = mlp.get_warm_epochs();
+    }
+    
+    void ml_mlp::get_optimiser(int &optimiser) const
+    {
+        optimiser = mlp.get_optimiser();
+    }
+    
+    void ml_mlp::get_rate_schedule(int &rate_schedule) const
+    {
+        rate_schedule = mlp.get_rate_schedule();
+    }
+    
+    void ml_mlp::get_rate_decay(float &rate_decay) const
+    {
+        rate_decay = mlp.get_rate_decay();
+    }
+    
+    void ml_mlp::get_patience(int &patience) const
+    {
+        patience = mlp.get_patience();
+    }
+    
+    void ml_mlp::get_target_error(float &target_error) const
+    {
+        target_error = mlp.get_target_error();
+    }
+    
+    void ml_mlp::get_error_log(bool &error_log) const
+    {
+        error_log = mlp.get_log_errors();
+    }
+    
     // Methods
     // NOTE: MLP is special since it supports both regression and classification, we therefore override these methods
     void ml_mlp::train()
@@ -526,36 +3149,59 @@ namespace ml
         }
         
         bool success = false;
+        GRT::Timer timer;
         
-        if (data_type == LABELLED_CLASSIFICATION)
+        timer.start();
+        
+        const bool classification = data_type == LABELLED_CLASSIFICATION;
+        const GRT::UINT numInputs = classification ? classification_data.getNumDimensions() : regression_data.getNumInputDimensions();
+        const GRT::UINT numOutputs = classification ? classification_data.getNumClasses() : regression_data.getNumTargetDimensions();
+        const std::vector<GRT::UINT> hidden_layers = mlp.get_hidden_layers().size() > 1 ? mlp.get_hidden_layers() : std::vector<GRT::UINT>(1, numHiddenNeurons);
+        
+        warm_started = false;
+        
+        if (warm_start)
         {
-            mlp.init(
-                     classification_data.getNumDimensions(),
-                     numHiddenNeurons,
-                     classification_data.getNumClasses(),
-                     inputActivationFunction,
-                     hiddenActivationFunction,
-                     outputActivationFunction
-                     );
-            success = mlp.train(classification_data);
+            warm_started = mlp.can_warm_start(numInputs, hidden_layers, numOutputs, inputActivationFunction, hiddenActivationFunction, outputActivationFunction, classification);
+            
+            if (!warm_started)
+            {
+                post("network not trained or topology changed, training from scratch");
+            }
         }
-        else if (data_type == LABELLED_REGRESSION)
+        
+        if (warm_started)
         {
-            mlp.init(
-                     regression_data.getNumInputDimensions(),
-                     numHiddenNeurons,
-                     regression_data.getNumTargetDimensions(),
-                     inputActivationFunction,
-                     hiddenActivationFunction,
-                     outputActivationFunction
-                     );
-            success = mlp.train(regression_data);
+            success = classification ? mlp.train_warm(classification_data) : mlp.train_warm(regression_data);
         }
-
+        else
+        {
+            mlp.init(numInputs, hidden_layers[0], numOutputs, inputActivationFunction, hiddenActivationFunction, outputActivationFunction);
+            
+            if (classification)
+            {
+                success = mlp.train(classification_data);
+            }
+            else
+            {
+                success = mlp.train(regression_data);
+            }
+        }
+        
         if (!success)
         {
             flext::error("training failed");
         }
+        else
+        {
+            post_training_summary(numSamples, std::max<double>(timer.getMilliSeconds(), 1.0) / 1000.0);
+            output_error_log();
+            
+            if (mlp.get_quantised())
+            {
+                report_quantisation();
+            }
+        }
         
         t_atom a_success;
         
@@ -685,6 +3331,82 @@ namespace ml
                       
     }
     
+    // Outputs "epoch <n> <training error> [<validation error>]" from the info outlet for every epoch of the selected network
+    // Method overrides
+    // Reports training throughput so that batch sizes (and batch_size 0, the GRT trainer) can be compared on the same data
+    bool ml_mlp::get_training_summary(GRT::UINT num_samples, double seconds, std::stringstream &summary) const
+    {
+        const double samples = (double)num_samples * mlp.get_num_epochs_trained();
+        
+        summary << ", " << mlp.get_num_epochs_trained() << " epochs (" << (GRT::UINT)(samples / seconds) << " samples/s, batch_size " << mlp.get_batch_size() << (warm_started ? ", warm start" : "") << ")";
+        
+        if ((mlp.get_batch_size() > 0 || warm_started) && mlp.get_target_error() > 0)
+        {
+            if (mlp.get_target_epoch() > 0)
+            {
+                summary << "\nreached target_error " << mlp.get_target_error() << " at epoch " << mlp.get_target_epoch() << " after " << mlp.get_target_time() / 1000.0 << "s";
+            }
+            else
+            {
+                summary << "\ntarget_error " << mlp.get_target_error() << " not reached";
+            }
+        }
+        
+        return true;
+    }
+    
+    void ml_mlp::output_error_log()
+    {
+        const GRT::VectorDouble &training_errors = mlp.get_epoch_training_errors();
+        const GRT::VectorDouble &validation_errors = mlp.get_epoch_validation_errors();
+        
+        for (GRT::UINT epoch = 0; epoch < training_errors.size(); ++epoch)
+        {
+            AtomList epoch_l;
+            t_atom value_a;
+            
+            SetInt(value_a, epoch + 1);
+            epoch_l.Append(value_a);
+            SetFloat(value_a, training_errors[epoch]);
+            epoch_l.Append(value_a);
+            
+            if (epoch < validation_errors.size())
+            {
+                SetFloat(value_a, validation_errors[epoch]);
+                epoch_l.Append(value_a);
+            }
+            
+            ToOutAnything(1, s_epoch, epoch_l);
+        }
+    }
+    
+    // Posts the difference between quantised and floating point outputs and the speedup, measured on the training data
+    void ml_mlp::report_quantisation()
+    {
+        const GRT::UINT max_benchmark_samples = 1000;
+        const bool classification = get_data_type() == LABELLED_CLASSIFICATION;
+        const GRT::UINT numSamples = std::min(max_benchmark_samples, classification ? classification_data.getNumSamples() : regression_data.getNumSamples());
+        std::vector<GRT::VectorDouble> inputs(numSamples);
+        double mean_difference = 0;
+        double max_difference = 0;
+        double speedup = 0;
+        
+        for (GRT::UINT sample = 0; sample < numSamples; ++sample)
+        {
+            inputs[sample] = classification ? classification_data[sample].getSample() : regression_data[sample].getInputVector();
+        }
+        
+        if (!mlp.compare_quantised(inputs, mean_difference, max_difference, speedup))
+        {
+            return;
+        }
+        
+        std::stringstream post_stream;
+        
+        post_stream << "quantized inference over " << numSamples << " samples: mean absolute difference " << mean_difference << ", max " << max_difference << " from the float model, " << speedup << "x speed";
+        post(post_stream.str());
+    }
+    
     // Implement pure virtual methods
     GRT::MLBase &ml_mlp::get_MLBase_instance()
     {
@@ -748,6 +3470,7 @@ namespace ml
     const std::string ml_mlp::attribute_help =
     "num_outputs:\tinteger setting number of neurons in the output layer of the MLP (default " + std::to_string( default_num_output_dimensions) + ")\n"
     "num_hidden:\tinteger setting number of neurons in the hidden layer of the MLP (default " + std::to_string( default_num_hidden_neurons) + ")\n"
+    "layers:\tlist of integers giving the number of neurons in each hidden layer, e.g. 'layers 16 8 4'; with more than one layer the MLP is trained by the mini-batch trainer (batch_size 0 uses 1) and saved in its own model format, a single value is the same as num_hidden (default " + std::to_string(default_num_hidden_neurons) + ")\n"
     "min_epochs:\tinteger setting the minimum number of training iterations (default 10)\n"
     "max_epochs:\tinteger setting the maximum number of training iterations (default 100)\n"
     "min_change:\tfloating point value setting the minimum change that must be achieved between two training epochs for the training to continue (default 1.0e-5)\n"
@@ -763,8 +3486,21 @@ namespace ml
     "use_validation_set:\tinteger (0 or 1) sets whether to use a validation training set (default 1)\n"
     "validation_set_size:\tinteger integer determining the size of the validation set (default 20)\n"
     "randomize_training_order:\tinteger (0 or 1) sets whether to randomize the training order (default 0)\n"
+    "batch_size:\tinteger setting the number of samples per weight update, 0 uses the original per-sample GRT trainer, values greater than 0 use the mini-batch matrix trainer, which runs rand_training_iterations in parallel (default 0)\n"
+    "optimiser:\tinteger selecting the optimiser of the mini-batch trainer, 0:SGD with momentum, 1:RMSPROP, 2:ADAM; adaptive optimisers usually need a smaller training_rate such as 0.01 (default SGD)\n"
+    "rate_schedule:\tinteger selecting how the mini-batch trainer varies training_rate over epochs, 0:CONSTANT, 1:EXPONENTIAL decay by rate_decay per epoch, 2:COSINE annealing to 0 at max_epochs (default CONSTANT)\n"
+    "rate_decay:\tfloating point value between 0 and 1 multiplying the training rate after each epoch for the exponential rate_schedule (default 0.99)\n"
+    "patience:\tinteger number of epochs without improvement in validation error after which the mini-batch trainer stops and restores the best weights, 0 disables early stopping (default 0)\n"
+    "target_error:\tfloating point value, when greater than 0 the mini-batch trainer stops once the validation (or training) RMS error falls to this value and reports the time taken (default 0)\n"
+    "error_log:\tinteger (0 or 1) when on, the mini-batch trainer outputs 'epoch <n> <training error> <validation error>' from the right outlet for each epoch after training (default 0)\n"
+    "quantize:\tinteger (0 or 1) when on, 'map' uses an int8 quantised copy of the network with per-layer scales, the difference from the float model and the speedup are posted when it is enabled or retrained; saved with the model (default 0)\n"
+    "warm_start:\tinteger (0 or 1) when on, 'train' continues from the current weights if the network is trained and its topology is unchanged, instead of starting from random weights (default 0)\n"
+    "warm_epochs:\tinteger setting the maximum number of epochs for warm start training (default " + std::to_string(default_warm_epochs) + ")\n"
+    "seed:\tinteger seeding the mini-batch trainer, any value other than 0 makes training reproducible, 0 seeds from the clock (default 0)\n"
     "scaling:\tinteger (0 or 1) sets whether values are automatically scaled (default 1)\n";
     
+    const t_symbol *ml_mlp::s_epoch = flext::MakeSymbol("epoch");
+    
     typedef class ml_mlp ml0x2emlp;
     
 #ifdef BUILD_AS_LIBRARY
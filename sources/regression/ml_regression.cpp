@@ -77,13 +77,20 @@ namespace ml
             return;
         }
         
+        GRT::Timer timer;
         bool success = false;
+        
+        timer.start();
         success = regressifier.train(regression_data);
         
         if (!success)
         {
             error("training failed");
         }
+        else
+        {
+            post_training_summary(numSamples, timer.getMilliSeconds() / 1000.0);
+        }
         
         t_atom a_success;
         